@@ -0,0 +1,118 @@
+#pragma once
+
+#include "BitEngine/Common/TypeDefinition.h"
+
+namespace BitEngine {
+
+/**
+ * Fixed size bit set, one bit per component type.
+ * Bits are kept in aligned 64 bit words, operations are plain loops over the words
+ * without branches, so the compiler can turn them into vector instructions:
+ * a single SSE op for 128 bits, a single AVX op for 256 bits.
+ */
+template <u32 N>
+struct alignas(N >= 256 ? 32 : (N >= 128 ? 16 : 8)) ComponentMask {
+    static_assert(N > 0 && N % 64 == 0, "ComponentMask size must be a multiple of 64");
+    static constexpr u32 BITS = N;
+    static constexpr u32 WORDS = N / 64;
+
+    ComponentMask()
+        : words{}
+    {
+    }
+
+    void set(u32 bit)
+    {
+        words[bit / 64] |= 1ull << (bit % 64);
+    }
+
+    void unset(u32 bit)
+    {
+        words[bit / 64] &= ~(1ull << (bit % 64));
+    }
+
+    bool test(u32 bit) const
+    {
+        return (words[bit / 64] & (1ull << (bit % 64))) != 0;
+    }
+
+    void clear()
+    {
+        for (u32 i = 0; i < WORDS; ++i) {
+            words[i] = 0;
+        }
+    }
+
+    bool none() const
+    {
+        u64 any = 0;
+        for (u32 i = 0; i < WORDS; ++i) {
+            any |= words[i];
+        }
+        return any == 0;
+    }
+
+    // True if every bit of other is set in this mask
+    bool containsAll(const ComponentMask& other) const
+    {
+        u64 missing = 0;
+        for (u32 i = 0; i < WORDS; ++i) {
+            missing |= other.words[i] & ~words[i];
+        }
+        return missing == 0;
+    }
+
+    // True if at least one bit is set in both masks
+    bool intersects(const ComponentMask& other) const
+    {
+        u64 common = 0;
+        for (u32 i = 0; i < WORDS; ++i) {
+            common |= words[i] & other.words[i];
+        }
+        return common != 0;
+    }
+
+    ComponentMask& operator|=(const ComponentMask& other)
+    {
+        for (u32 i = 0; i < WORDS; ++i) {
+            words[i] |= other.words[i];
+        }
+        return *this;
+    }
+
+    ComponentMask operator|(const ComponentMask& other) const
+    {
+        ComponentMask result = *this;
+        result |= other;
+        return result;
+    }
+
+    bool operator==(const ComponentMask& other) const
+    {
+        u64 diff = 0;
+        for (u32 i = 0; i < WORDS; ++i) {
+            diff |= words[i] ^ other.words[i];
+        }
+        return diff == 0;
+    }
+
+    bool operator!=(const ComponentMask& other) const
+    {
+        return !(*this == other);
+    }
+
+    // For unordered containers
+    struct Hash {
+        size_t operator()(const ComponentMask& mask) const
+        {
+            u64 h = 0xcbf29ce484222325ull;
+            for (u32 i = 0; i < WORDS; ++i) {
+                h = (h ^ mask.words[i]) * 0x100000001b3ull;
+            }
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+    };
+
+    u64 words[WORDS];
+};
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace BitEngine {
+
+template <typename Signature>
+class Delegate;
+
+/**
+ * Move only callable, a lighter std::function.
+ * A call is a single indirect call to a thunk that knows the stored type:
+ * - bind<Handler, &Handler::method>(handler) makes the member function a template argument,
+ *   the thunk calls it directly and it can be inlined there
+ * - bind(handler, &Handler::method) stores the member function pointer with the handler
+ * - any callable that fits STORAGE_SIZE and moves without throwing is stored inline,
+ *   bigger ones (a std::function, lambdas capturing a lot) are moved to the heap once
+ * Nothing is allocated for the first two and for small lambdas.
+ */
+template <typename R, typename... Args>
+class Delegate<R(Args...)> {
+public:
+    // Handler pointer plus a member function pointer, whatever the compiler makes of it
+    static constexpr size_t STORAGE_SIZE = 4 * sizeof(void*);
+
+    Delegate()
+        : m_invoke(nullptr)
+        , m_manage(nullptr)
+    {
+    }
+
+    template <typename Func,
+        typename = typename std::enable_if<!std::is_same<typename std::decay<Func>::type, Delegate>::value
+            && std::is_invocable_r<R, typename std::decay<Func>::type&, Args...>::value>::type>
+    Delegate(Func&& f)
+        : m_invoke(nullptr)
+        , m_manage(nullptr)
+    {
+        init(std::forward<Func>(f));
+    }
+
+    Delegate(Delegate&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    Delegate& operator=(Delegate&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    Delegate(const Delegate&) = delete;
+    Delegate& operator=(const Delegate&) = delete;
+
+    ~Delegate()
+    {
+        reset();
+    }
+
+    template <typename Handler, R (Handler::*Method)(Args...)>
+    static Delegate bind(Handler* handler)
+    {
+        Delegate delegate;
+        new (delegate.m_storage) Handler*(handler);
+        delegate.m_invoke = [](void* storage, Args... args) -> R {
+            return ((*static_cast<Handler**>(storage))->*Method)(std::forward<Args>(args)...);
+        };
+        return delegate;
+    }
+
+    template <typename Handler>
+    static Delegate bind(Handler* handler, R (Handler::*method)(Args...))
+    {
+        struct Bound {
+            Handler* handler;
+            R (Handler::*method)(Args...);
+        };
+        static_assert(sizeof(Bound) <= STORAGE_SIZE, "Member function pointer doesn't fit the delegate");
+        Delegate delegate;
+        new (delegate.m_storage) Bound{ handler, method };
+        delegate.m_invoke = [](void* storage, Args... args) -> R {
+            const Bound* bound = static_cast<const Bound*>(storage);
+            return (bound->handler->*bound->method)(std::forward<Args>(args)...);
+        };
+        return delegate;
+    }
+
+    R operator()(Args... args) const
+    {
+        return m_invoke(m_storage, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const
+    {
+        return m_invoke != nullptr;
+    }
+
+    void reset()
+    {
+        if (m_manage != nullptr) {
+            m_manage(Operation::DESTROY, m_storage, nullptr);
+        }
+        m_invoke = nullptr;
+        m_manage = nullptr;
+    }
+
+private:
+    enum class Operation {
+        MOVE,
+        DESTROY,
+    };
+
+    using Invoke = R (*)(void* storage, Args...);
+    // nullptr when the stored value can be copied with memcpy and needs no destructor
+    using Manage = void (*)(Operation operation, void* storage, void* source);
+
+    template <typename F>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(F) <= STORAGE_SIZE && alignof(F) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<F>::value;
+    }
+
+    template <typename Func>
+    void init(Func&& f)
+    {
+        using F = typename std::decay<Func>::type;
+        if constexpr (fitsInline<F>()) {
+            new (m_storage) F(std::forward<Func>(f));
+            m_invoke = [](void* storage, Args... args) -> R {
+                return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+            };
+            if constexpr (!std::is_trivially_copyable<F>::value) {
+                m_manage = [](Operation operation, void* storage, void* source) {
+                    if (operation == Operation::MOVE) {
+                        new (storage) F(std::move(*static_cast<F*>(source)));
+                        static_cast<F*>(source)->~F();
+                    }
+                    else {
+                        static_cast<F*>(storage)->~F();
+                    }
+                };
+            }
+        }
+        else {
+            new (m_storage) F*(new F(std::forward<Func>(f)));
+            m_invoke = [](void* storage, Args... args) -> R {
+                return (**static_cast<F**>(storage))(std::forward<Args>(args)...);
+            };
+            m_manage = [](Operation operation, void* storage, void* source) {
+                if (operation == Operation::MOVE) {
+                    new (storage) F*(*static_cast<F**>(source));
+                }
+                else {
+                    delete *static_cast<F**>(storage);
+                }
+            };
+        }
+    }
+
+    void moveFrom(Delegate& other)
+    {
+        m_invoke = other.m_invoke;
+        m_manage = other.m_manage;
+        if (m_manage != nullptr) {
+            m_manage(Operation::MOVE, m_storage, other.m_storage);
+        }
+        else {
+            std::memcpy(m_storage, other.m_storage, STORAGE_SIZE);
+        }
+        other.m_invoke = nullptr;
+        other.m_manage = nullptr;
+    }
+
+    // Mutable so a const delegate can call a mutable lambda, like std::function
+    alignas(std::max_align_t) mutable unsigned char m_storage[STORAGE_SIZE];
+    Invoke m_invoke;
+    Manage m_manage;
+};
+}
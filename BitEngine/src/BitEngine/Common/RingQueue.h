@@ -0,0 +1,292 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// No TypeDefinition.h, the profiler uses these queues and TypeDefinition.h includes the profiler
+
+namespace BitEngine {
+
+namespace RingQueueDetail {
+    inline uint64_t roundCapacity(uint32_t capacity)
+    {
+        uint64_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+}
+
+/**
+ * Bounded single producer, single consumer queue.
+ * One thread pushes and one thread pops, both without locks or read-modify-write
+ * atomics: each side owns one index and only reads the other one when its cached copy
+ * says the queue looks full (producer) or empty (consumer).
+ * push returns false when the queue is full, the caller decides to drop, retry or grow.
+ * The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SpscRingQueue {
+public:
+    using value_type = T;
+
+    explicit SpscRingQueue(uint32_t capacity = 256)
+        : m_mask(RingQueueDetail::roundCapacity(capacity) - 1)
+        , m_items(new T[m_mask + 1])
+        , m_head(0)
+        , m_cachedTail(0)
+        , m_tail(0)
+        , m_cachedHead(0)
+    {
+    }
+
+    SpscRingQueue(const SpscRingQueue&) = delete;
+    SpscRingQueue& operator=(const SpscRingQueue&) = delete;
+
+    // Producer only
+    template <typename... Args>
+    bool push(Args&&... args)
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask) {
+                return false;
+            }
+        }
+        m_items[tail & m_mask] = T(std::forward<Args>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    bool tryPop(T& out)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) {
+                return false;
+            }
+        }
+        out = std::move(m_items[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called while other threads use the queue
+    bool empty() const
+    {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+
+    uint32_t capacity() const { return static_cast<uint32_t>(m_mask + 1); }
+
+private:
+    const uint64_t m_mask;
+    const std::unique_ptr<T[]> m_items;
+
+    // Consumer side
+    alignas(64) std::atomic<uint64_t> m_head;
+    uint64_t m_cachedTail;
+
+    // Producer side
+    alignas(64) std::atomic<uint64_t> m_tail;
+    uint64_t m_cachedHead;
+};
+
+/**
+ * Bounded multiple producer, single consumer queue.
+ * Producers claim a slot with a CAS on the tail, every slot has a sequence number that
+ * tells if it's free for the producer of a given position or ready for the consumer.
+ * The consumer owns the head and never competes with anyone.
+ * A producer that claimed a slot and was preempted before publishing it holds back the
+ * items pushed after it until it finishes, tryPop reports empty meanwhile.
+ * push returns false when the queue is full.
+ * The capacity is rounded up to a power of two.
+ * Based on Dmitry Vyukov's bounded MPMC queue.
+ */
+template <typename T>
+class MpscRingQueue {
+public:
+    using value_type = T;
+
+    explicit MpscRingQueue(uint32_t capacity = 256)
+        : m_mask(RingQueueDetail::roundCapacity(capacity) - 1)
+        , m_cells(new Cell[m_mask + 1])
+        , m_head(0)
+        , m_tail(0)
+    {
+        for (uint64_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRingQueue(const MpscRingQueue&) = delete;
+    MpscRingQueue& operator=(const MpscRingQueue&) = delete;
+
+    // Any thread
+    template <typename... Args>
+    bool push(Args&&... args)
+    {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &m_cells[tail & m_mask];
+            const uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(sequence - tail);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                // The consumer didn't free this slot yet
+                return false;
+            }
+            else {
+                tail = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = T(std::forward<Args>(args)...);
+        cell->sequence.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    bool tryPop(T& out)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        Cell& cell = m_cells[head & m_mask];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+        out = std::move(cell.value);
+        // Free for the producer one lap ahead
+        cell.sequence.store(head + m_mask + 1, std::memory_order_release);
+        m_head.store(head + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Approximate when called while other threads use the queue
+    bool empty() const
+    {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_relaxed);
+    }
+
+    uint32_t capacity() const { return static_cast<uint32_t>(m_mask + 1); }
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        T value;
+    };
+
+    const uint64_t m_mask;
+    const std::unique_ptr<Cell[]> m_cells;
+
+    alignas(64) std::atomic<uint64_t> m_head; // consumer only, atomic so empty() can read it
+    alignas(64) std::atomic<uint64_t> m_tail;
+};
+
+/**
+ * Adds a blocking pop to a ring queue, for a consumer thread that sleeps until there
+ * is work (a writer or loader thread).
+ * Producers only touch the mutex when the consumer is actually sleeping, otherwise a push
+ * costs the queue atomics plus one load. release() wakes the consumer for good, pop()
+ * keeps returning the remaining items and then false.
+ */
+template <typename Queue>
+class BlockingQueue {
+public:
+    using value_type = typename Queue::value_type;
+
+    explicit BlockingQueue(uint32_t capacity = 256)
+        : m_queue(capacity)
+        , m_sleeping(0)
+        , m_released(false)
+    {
+    }
+
+    // Returns false when the queue is full, it never waits for space
+    template <typename... Args>
+    bool push(Args&&... args)
+    {
+        if (!m_queue.push(std::forward<Args>(args)...)) {
+            return false;
+        }
+        // Pairs with the fence in pop: either we see the consumer sleeping
+        // or the consumer sees the item before going to sleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleeping.load(std::memory_order_relaxed) != 0) {
+            wake();
+        }
+        return true;
+    }
+
+    bool tryPop(value_type& out)
+    {
+        return m_queue.tryPop(out);
+    }
+
+    // Waits for an item, returns false only after release() when the queue is empty
+    bool pop(value_type& out)
+    {
+        if (m_queue.tryPop(out)) {
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!m_queue.tryPop(out)) {
+            if (m_released.load(std::memory_order_relaxed)) {
+                m_sleeping.store(0, std::memory_order_relaxed);
+                return false;
+            }
+            m_cond.wait(lock);
+        }
+        m_sleeping.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    void release()
+    {
+        m_released.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake();
+    }
+
+    // Undo release() before starting a new consumer
+    void reopen()
+    {
+        m_released.store(false, std::memory_order_relaxed);
+    }
+
+    bool empty() const
+    {
+        return m_queue.empty();
+    }
+
+private:
+    void wake()
+    {
+        // Taking the lock makes sure the consumer is either before its last check or
+        // already waiting, so the notification can't be missed
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_cond.notify_one();
+    }
+
+    Queue m_queue;
+    std::atomic<uint32_t> m_sleeping;
+    std::atomic<bool> m_released;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
+}
@@ -26,10 +26,15 @@ public:
         return false;
     }
 
+    ThreadSafeQueue()
+        : m_released(false)
+    {
+    }
+
     bool pop(T& out)
     {
         std::unique_lock<std::mutex> lock(m_mutex);
-        if (m_queue.empty()) {
+        if (m_queue.empty() && !m_released) {
             m_cond.wait(lock);
         }
 
@@ -43,6 +48,18 @@ public:
         }
     }
 
+    // Waits for the lock, unlike tryPop, but not for an item
+    bool popIfAny(T& out)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.empty()) {
+            return false;
+        }
+        out = std::move(m_queue.front());
+        m_queue.pop();
+        return true;
+    }
+
     void clear()
     {
         std::unique_lock<std::mutex> lock(m_mutex);
@@ -75,6 +92,12 @@ public:
         return m_queue.empty();
     }
 
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
     void swap(ThreadSafeQueue& queue)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
@@ -87,9 +110,20 @@ public:
         m_cond.notify_all();
     }
 
+    // Wake up all waiting pop() calls, pop() won't wait anymore after this.
+    // Unlike notify(), this can't be missed by a thread that is about to wait.
+    void release()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released = true;
+        lock.unlock();
+        m_cond.notify_all();
+    }
+
 private:
     std::mutex m_mutex;
     std::condition_variable m_cond;
     std::queue<T> m_queue;
+    bool m_released;
 };
 }
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "BitEngine/Common/TypeDefinition.h"
+
+namespace BitEngine {
+
+/**
+ * Chase-Lev work stealing deque.
+ * A single owner thread pushes and pops at the bottom (LIFO), any number of other
+ * threads steal from the top (FIFO). No locks: the owner only synchronizes with thieves
+ * when there is one item left, and thieves race with each other on a single CAS.
+ * The buffer grows when full. Old buffers may still be read by a thief, so they are
+ * only freed with the deque.
+ * T must be trivially copyable, usually a pointer.
+ * Based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al, 2013).
+ */
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque items must be trivially copyable");
+
+public:
+    explicit WorkStealingDeque(u32 capacity = 256)
+        : m_top(0)
+        , m_bottom(0)
+    {
+        u32 size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_buffers.emplace_back(new Buffer(size));
+        m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only
+    void push(T item)
+    {
+        const s64 b = m_bottom.load(std::memory_order_relaxed);
+        const s64 t = m_top.load(std::memory_order_acquire);
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        if (b - t > buffer->mask) {
+            buffer = grow(buffer, t, b);
+        }
+        buffer->put(b, item);
+        // The paper uses a release fence and a relaxed store, a release store is the same
+        // on x86 and ARM, and thread sanitizer understands it
+        m_bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // Owner only, takes the most recently pushed item
+    bool pop(T& out)
+    {
+        const s64 b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        s64 t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Was empty
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        out = buffer->get(b);
+        if (t == b) {
+            // Last item, a thief may be taking it too
+            const bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread, takes the oldest item
+    // Returns false when empty or when another thread took the item first
+    bool steal(T& out)
+    {
+        s64 t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const s64 b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+
+        Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+        const T item = buffer->get(t);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        out = item;
+        return true;
+    }
+
+    // Approximate when called while other threads use the deque
+    bool empty() const
+    {
+        return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+    }
+
+    // Approximate when called while other threads use the deque
+    u32 size() const
+    {
+        const s64 size = m_bottom.load(std::memory_order_relaxed) - m_top.load(std::memory_order_relaxed);
+        return size > 0 ? static_cast<u32>(size) : 0;
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(u32 size)
+            : mask(size - 1)
+            , items(new std::atomic<T>[size])
+        {
+        }
+
+        T get(s64 i) const { return items[i & mask].load(std::memory_order_relaxed); }
+        void put(s64 i, T item) { items[i & mask].store(item, std::memory_order_relaxed); }
+
+        const s64 mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+    Buffer* grow(Buffer* old, s64 t, s64 b)
+    {
+        m_buffers.emplace_back(new Buffer(static_cast<u32>(old->mask + 1) * 2));
+        Buffer* buffer = m_buffers.back().get();
+        for (s64 i = t; i < b; ++i) {
+            buffer->put(i, old->get(i));
+        }
+        m_buffer.store(buffer, std::memory_order_release);
+        return buffer;
+    }
+
+    // Owner and thieves touch different ends, keep them in different cache lines
+    alignas(64) std::atomic<s64> m_top;
+    alignas(64) std::atomic<s64> m_bottom;
+    alignas(64) std::atomic<Buffer*> m_buffer;
+    std::vector<std::unique_ptr<Buffer> > m_buffers; // owner only, every buffer used so far
+};
+}
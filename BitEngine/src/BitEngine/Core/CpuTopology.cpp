@@ -0,0 +1,150 @@
+#include "BitEngine/Core/CpuTopology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace BitEngine {
+namespace CpuTopology {
+
+    namespace {
+        std::vector<Cpu> allOnNodeZero()
+        {
+            const u32 hardwareThreads = std::thread::hardware_concurrency();
+            const u32 count = hardwareThreads > 0 ? hardwareThreads : 1;
+            std::vector<Cpu> cpus(count);
+            for (u32 i = 0; i < count; ++i) {
+                cpus[i] = Cpu{ i, 0 };
+            }
+            return cpus;
+        }
+
+#ifdef __linux__
+        // Parse a sysfs cpu list, like "0-3,8,10-11"
+        std::vector<u32> parseCpuList(const std::string& list)
+        {
+            std::vector<u32> ids;
+            std::stringstream ss(list);
+            std::string range;
+            while (std::getline(ss, range, ',')) {
+                if (range.empty()) {
+                    continue;
+                }
+                const size_t dash = range.find('-');
+                const u32 first = std::stoul(range.substr(0, dash));
+                const u32 last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+                for (u32 id = first; id <= last; ++id) {
+                    ids.emplace_back(id);
+                }
+            }
+            return ids;
+        }
+
+        // NUMA node of each CPU id, 0 when sysfs has no node information
+        std::vector<u32> readNodes(u32 maxCpu)
+        {
+            std::vector<u32> nodeOf(maxCpu + 1, 0);
+            for (u32 node = 0;; ++node) {
+                std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                if (!file.is_open()) {
+                    break;
+                }
+                std::string list;
+                std::getline(file, list);
+                for (const u32 id : parseCpuList(list)) {
+                    if (id <= maxCpu) {
+                        nodeOf[id] = node;
+                    }
+                }
+            }
+            return nodeOf;
+        }
+#endif
+    }
+
+    std::vector<Cpu> getCpus()
+    {
+        std::vector<Cpu> cpus;
+
+#if defined(_WIN32)
+        // Only the first processor group (64 CPUs) is considered
+        DWORD_PTR processMask, systemMask;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+            return allOnNodeZero();
+        }
+
+        ULONG highestNode = 0;
+        GetNumaHighestNodeNumber(&highestNode);
+        for (ULONG node = 0; node <= highestNode; ++node) {
+            ULONGLONG nodeMask = 0;
+            if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &nodeMask)) {
+                continue;
+            }
+            for (u32 id = 0; id < 64; ++id) {
+                const ULONGLONG bit = 1ull << id;
+                if ((nodeMask & bit) && (processMask & bit)) {
+                    cpus.emplace_back(Cpu{ id, static_cast<u32>(node) });
+                }
+            }
+        }
+#elif defined(__linux__)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            return allOnNodeZero();
+        }
+
+        u32 maxCpu = 0;
+        for (u32 id = 0; id < CPU_SETSIZE; ++id) {
+            if (CPU_ISSET(id, &allowed)) {
+                maxCpu = id;
+            }
+        }
+
+        const std::vector<u32> nodeOf = readNodes(maxCpu);
+        for (u32 id = 0; id <= maxCpu; ++id) {
+            if (CPU_ISSET(id, &allowed)) {
+                cpus.emplace_back(Cpu{ id, nodeOf[id] });
+            }
+        }
+#endif
+
+        if (cpus.empty()) {
+            return allOnNodeZero();
+        }
+
+        std::stable_sort(cpus.begin(), cpus.end(), [](const Cpu& a, const Cpu& b) { return a.node < b.node; });
+        return cpus;
+    }
+
+    bool pinCurrentThread(u32 cpu)
+    {
+#if defined(_WIN32)
+        if (cpu >= 64) {
+            return false;
+        }
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+        if (cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+}
+}
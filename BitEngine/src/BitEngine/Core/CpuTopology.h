@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include "BitEngine/Common/TypeDefinition.h"
+#include "BitEngine/Core/api.h"
+
+namespace BitEngine {
+
+/**
+ * Logical CPUs available to the process and the NUMA node they belong to.
+ * Used to place worker threads: CPUs of the same node share memory and caches,
+ * so threads that exchange work should run on the same node.
+ */
+namespace CpuTopology {
+
+    struct Cpu {
+        u32 id; // logical CPU index, as used by pinCurrentThread
+        u32 node; // NUMA node, 0 on machines without NUMA information
+    };
+
+    // CPUs the process is allowed to run on, sorted by node and then by id
+    // Never empty: when the platform doesn't tell, one CPU per hardware thread on node 0
+    BE_API std::vector<Cpu> getCpus();
+
+    // Restrict the calling thread to run only on the given CPU
+    // Returns false if the platform doesn't support it or the call failed
+    BE_API bool pinCurrentThread(u32 cpu);
+}
+}
@@ -0,0 +1,103 @@
+#include "BitEngine/Core/EventBus.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "BitEngine/Core/Profiler.h"
+
+namespace BitEngine {
+
+static std::atomic<u32> eventTypeCounter(0);
+static std::atomic<u64> eventBusInstances(0);
+
+u32 EventBusDetail::nextEventTypeIndex()
+{
+    return eventTypeCounter.fetch_add(1);
+}
+
+EventBus::EventBus()
+    : m_instanceID(++eventBusInstances)
+    , m_epoch(0)
+    , m_handles(0)
+    , m_dispatching(false)
+{
+}
+
+EventBus::~EventBus()
+{
+    for (ThreadQueue* queue : m_queues) {
+        delete queue;
+    }
+}
+
+EventBus::ThreadQueue& EventBus::getThreadQueue()
+{
+    // Most posts come from the same thread to the same bus, avoid the lock for those
+    struct Cache {
+        u64 instance;
+        ThreadQueue* queue;
+    };
+    static thread_local Cache cache = { 0, nullptr };
+    if (cache.instance == m_instanceID) {
+        return *cache.queue;
+    }
+
+    std::lock_guard<std::mutex> lock(m_queuesMutex);
+    const std::thread::id thread = std::this_thread::get_id();
+    ThreadQueue* queue = nullptr;
+    for (ThreadQueue* q : m_queues) {
+        if (q->thread == thread) {
+            queue = q;
+            break;
+        }
+    }
+
+    if (queue == nullptr) {
+        queue = new ThreadQueue();
+        queue->thread = thread;
+        m_queues.emplace_back(queue);
+    }
+
+    cache = Cache{ m_instanceID, queue };
+    return *queue;
+}
+
+void EventBus::dispatchAll()
+{
+    BE_PROFILE_FUNCTION();
+    BE_ASSERT(!m_dispatching);
+
+    // New posts go to the other side from here on
+    const u32 side = m_epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+    {
+        std::lock_guard<std::mutex> lock(m_queuesMutex);
+        m_dispatchQueues = m_queues;
+    }
+
+    // Wait for posts that started before the epoch changed
+    ptrsize types = 0;
+    for (ThreadQueue* queue : m_dispatchQueues) {
+        while (queue->posting.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+        types = std::max(types, queue->arrays[side].size());
+    }
+
+    m_dispatching = true;
+    for (ptrsize type = 0; type < types; ++type) {
+        ChannelBase* channel = type < m_channels.size() ? m_channels[type].get() : nullptr;
+        for (ThreadQueue* queue : m_dispatchQueues) {
+            std::vector<std::unique_ptr<EventArrayBase> >& arrays = queue->arrays[side];
+            if (type >= arrays.size() || arrays[type] == nullptr || arrays[type]->empty()) {
+                continue;
+            }
+            if (channel != nullptr) {
+                channel->deliver(*arrays[type]);
+            }
+            // Keeps the memory for the next frames
+            arrays[type]->clear();
+        }
+    }
+    m_dispatching = false;
+}
+}
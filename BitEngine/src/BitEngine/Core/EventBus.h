@@ -0,0 +1,246 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BitEngine/Common/Delegate.h"
+#include "BitEngine/Common/TypeDefinition.h"
+#include "BitEngine/Core/Assert.h"
+
+namespace BitEngine {
+
+namespace EventBusDetail {
+    BE_API u32 nextEventTypeIndex();
+
+    // Small index for each event type, the same for every bus
+    template <typename EventType>
+    u32 eventTypeIndex()
+    {
+        static const u32 index = nextEventTypeIndex();
+        return index;
+    }
+}
+
+/**
+ * Deferred events posted from any thread and delivered on one thread at a sync point.
+ * Every thread posts to its own queue, with one contiguous array per event type that keeps
+ * its memory between frames: post() takes no lock and, once the arrays grew, allocates nothing.
+ * dispatchAll() delivers the events type by type. For each type, each queue (in the order the
+ * threads first posted) hands its array to every subscriber: batch subscribers get the whole
+ * array, the others are called once per event in a tight loop.
+ * Events of one type posted by one thread keep their order, there is no order between types
+ * or between threads.
+ * Events posted while dispatchAll runs, including by subscribers, are delivered by the next
+ * dispatchAll. A thread that stays inside post() holds dispatchAll back until it returns.
+ * Each post() synchronizes with dispatchAll once, a Poster does it once for all its posts.
+ * subscribe, unsubscribe and dispatchAll belong to the thread owning the bus, not inside
+ * a subscriber.
+ */
+class BE_API EventBus : public NonCopyable, NonAssignable {
+private:
+    struct EventArrayBase;
+    struct ThreadQueue;
+
+public:
+    template <typename EventType>
+    using Callback = Delegate<void(const EventType&)>;
+    template <typename EventType>
+    using BatchCallback = Delegate<void(const EventType* events, ptrsize count)>;
+
+    EventBus();
+    ~EventBus();
+
+    template <typename EventType>
+    u32 subscribe(Callback<EventType> callback)
+    {
+        const u32 handle = ++m_handles;
+        getChannel<EventType>().subscribers.emplace_back(Subscriber<Callback<EventType> >{ std::move(callback), handle });
+        return handle;
+    }
+
+    template <typename EventType>
+    u32 subscribeBatch(BatchCallback<EventType> callback)
+    {
+        const u32 handle = ++m_handles;
+        getChannel<EventType>().batchSubscribers.emplace_back(Subscriber<BatchCallback<EventType> >{ std::move(callback), handle });
+        return handle;
+    }
+
+    template <typename EventType>
+    void unsubscribe(u32 handle)
+    {
+        Channel<EventType>& channel = getChannel<EventType>();
+        removeSubscriber(channel.subscribers, handle);
+        removeSubscriber(channel.batchSubscribers, handle);
+    }
+
+    /**
+     * Posts many events paying for the synchronization with dispatchAll only once,
+     * for systems producing lots of events in a loop.
+     * dispatchAll waits for every Poster alive when it starts, keep them short lived
+     * and never call dispatchAll on a thread holding one.
+     */
+    class Poster {
+    public:
+        explicit Poster(EventBus& bus)
+            : m_queue(bus.getThreadQueue())
+            , m_arrays(bus.beginPosting(m_queue))
+        {
+        }
+
+        ~Poster()
+        {
+            endPosting(m_queue);
+        }
+
+        Poster(const Poster&) = delete;
+        Poster& operator=(const Poster&) = delete;
+
+        template <typename EventType>
+        void post(EventType event)
+        {
+            EventBus::push(m_arrays, std::move(event));
+        }
+
+    private:
+        ThreadQueue& m_queue;
+        std::vector<std::unique_ptr<EventArrayBase> >& m_arrays;
+    };
+
+    // Any thread, delivered on the next dispatchAll
+    template <typename EventType>
+    void post(EventType event)
+    {
+        ThreadQueue& queue = getThreadQueue();
+        push(beginPosting(queue), std::move(event));
+        endPosting(queue);
+    }
+
+    // Deliver everything posted before this call, on the thread owning the bus
+    void dispatchAll();
+
+private:
+    struct EventArrayBase {
+        virtual ~EventArrayBase() {}
+        virtual bool empty() const = 0;
+        virtual void clear() = 0;
+    };
+
+    template <typename EventType>
+    struct EventArray : public EventArrayBase {
+        bool empty() const override { return events.empty(); }
+        void clear() override { events.clear(); }
+        std::vector<EventType> events;
+    };
+
+    struct ChannelBase {
+        virtual ~ChannelBase() {}
+        virtual void deliver(EventArrayBase& array) = 0;
+    };
+
+    template <typename Call>
+    struct Subscriber {
+        Call callback;
+        u32 handle;
+    };
+
+    template <typename EventType>
+    struct Channel : public ChannelBase {
+        void deliver(EventArrayBase& array) override
+        {
+            const std::vector<EventType>& events = static_cast<EventArray<EventType>&>(array).events;
+            for (const Subscriber<BatchCallback<EventType> >& s : batchSubscribers) {
+                s.callback(events.data(), events.size());
+            }
+            for (const Subscriber<Callback<EventType> >& s : subscribers) {
+                for (const EventType& event : events) {
+                    s.callback(event);
+                }
+            }
+        }
+
+        std::vector<Subscriber<Callback<EventType> > > subscribers;
+        std::vector<Subscriber<BatchCallback<EventType> > > batchSubscribers;
+    };
+
+    struct ThreadQueue {
+        std::thread::id thread;
+        std::atomic<u32> posting{ 0 }; // posts and Posters running on this thread
+        // Indexed by event type, one side is posted to while the other is dispatched
+        std::vector<std::unique_ptr<EventArrayBase> > arrays[2];
+    };
+
+    // Arrays of the side being posted to, until posting is decremented
+    std::vector<std::unique_ptr<EventArrayBase> >& beginPosting(ThreadQueue& queue)
+    {
+        // Only this thread writes posting, no read-modify-write needed.
+        // Pairs with the epoch change in dispatchAll: either it waits for this post
+        // or this post sees the new epoch
+        queue.posting.store(queue.posting.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+        return queue.arrays[m_epoch.load(std::memory_order_seq_cst) & 1];
+    }
+
+    static void endPosting(ThreadQueue& queue)
+    {
+        queue.posting.store(queue.posting.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+    }
+
+    template <typename EventType>
+    static void push(std::vector<std::unique_ptr<EventArrayBase> >& arrays, EventType&& event)
+    {
+        const u32 type = EventBusDetail::eventTypeIndex<EventType>();
+        if (type >= arrays.size()) {
+            arrays.resize(type + 1);
+        }
+        if (arrays[type] == nullptr) {
+            arrays[type].reset(new EventArray<EventType>());
+        }
+        static_cast<EventArray<EventType>*>(arrays[type].get())->events.emplace_back(std::move(event));
+    }
+
+    template <typename EventType>
+    Channel<EventType>& getChannel()
+    {
+        BE_ASSERT(!m_dispatching);
+        const u32 type = EventBusDetail::eventTypeIndex<EventType>();
+        if (type >= m_channels.size()) {
+            m_channels.resize(type + 1);
+        }
+        if (m_channels[type] == nullptr) {
+            m_channels[type].reset(new Channel<EventType>());
+        }
+        return static_cast<Channel<EventType>&>(*m_channels[type]);
+    }
+
+    template <typename Subscribers>
+    static void removeSubscriber(Subscribers& subscribers, u32 handle)
+    {
+        for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+            if (it->handle == handle) {
+                subscribers.erase(it);
+                return;
+            }
+        }
+    }
+
+    ThreadQueue& getThreadQueue();
+
+    // Identifies this instance in the thread local queue cache
+    const u64 m_instanceID;
+    // Even: threads post to arrays[0], odd: arrays[1]
+    std::atomic<u32> m_epoch;
+
+    std::mutex m_queuesMutex;
+    std::vector<ThreadQueue*> m_queues;
+    std::vector<ThreadQueue*> m_dispatchQueues; // copy of m_queues used while dispatching
+
+    // Indexed by event type
+    std::vector<std::unique_ptr<ChannelBase> > m_channels;
+    u32 m_handles;
+    bool m_dispatching;
+};
+}
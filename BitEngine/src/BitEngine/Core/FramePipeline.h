@@ -0,0 +1,84 @@
+#pragma once
+
+#include <utility>
+
+#include "BitEngine/Core/Assert.h"
+#include "BitEngine/Core/TaskManager.h"
+
+namespace BitEngine {
+
+/**
+ * Overlaps producing a frame with consuming the frame before it, using two slots.
+ * Each frame, produce() starts filling one slot in a background task while the main thread
+ * consumes the slot filled in the previous frame (getReadySlot), then finishFrame() waits for
+ * the producer, helping with the task manager work, and swaps the slots.
+ * A frame takes about max(produce, consume) instead of produce + consume, with one frame
+ * of latency. The consumer must be done with the ready slot before finishFrame returns.
+ * Slot is usually a render queue: the game simulation fills one while the renderer, that must
+ * stay on the thread owning the graphics context, draws the other.
+ */
+template <typename Slot>
+class FramePipeline {
+public:
+    FramePipeline(TaskManager* taskManager, Slot* first, Slot* second)
+        : m_taskManager(taskManager)
+        , m_slots{ first, second }
+        , m_producing(0)
+        , m_hasReady(false)
+    {
+    }
+
+    ~FramePipeline()
+    {
+        finishFrame();
+    }
+
+    // Start filling the free slot, f signature: void(Slot& slot)
+    // Runs on a worker thread, f must not call main thread only functions
+    template <typename Func>
+    void produce(Func&& f)
+    {
+        BE_ASSERT(m_task == nullptr);
+        Slot* slot = m_slots[m_producing];
+        if (m_taskManager == nullptr) {
+            // No overlap, the frame is consumed right after it's produced
+            f(*slot);
+            swap();
+            return;
+        }
+
+        m_task = m_taskManager->addTask([slot, f = std::forward<Func>(f)]() mutable { f(*slot); });
+    }
+
+    // Slot filled by the last finished frame, nullptr before the first one finishes
+    Slot* getReadySlot() const
+    {
+        return m_hasReady ? m_slots[1 - m_producing] : nullptr;
+    }
+
+    // Wait the slot being filled, it becomes the ready slot
+    // Main thread only
+    void finishFrame()
+    {
+        if (m_task == nullptr) {
+            return;
+        }
+        m_taskManager->waitTask(m_task);
+        m_task.reset();
+        swap();
+    }
+
+private:
+    void swap()
+    {
+        m_producing = 1 - m_producing;
+        m_hasReady = true;
+    }
+
+    TaskManager* const m_taskManager;
+    Slot* const m_slots[2];
+    TaskPtr m_task; // producing the current frame
+    u32 m_producing; // slot being filled
+    bool m_hasReady;
+};
+}
@@ -1,95 +1,196 @@
 #include "BitEngine/Core/Logger.h"
 #include "BitEngine/Core/GeneralTaskManager.h"
 
+#include <algorithm>
+#include <chrono>
+
+#include "BitEngine/Core/CpuTopology.h"
+#include "BitEngine/Core/EngineConfiguration.h"
+
 namespace BitEngine {
 
+namespace {
+    // Worker running on this thread, set by the worker threads only
+    thread_local TaskWorker* t_currentWorker = nullptr;
+
+    // Scans over all queues before an idle worker parks
+    const u32 IDLE_ROUNDS_BEFORE_PARKING = 16;
+
+    u64 nowNs()
+    {
+        return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    double toMs(u64 ns)
+    {
+        return static_cast<double>(ns) / 1000000.0;
+    }
+}
+
 TaskWorker::TaskWorker(GeneralTaskManager* _manager, Task::Affinity _affinity, u32 id)
     : m_working(true)
+    , m_threadId(id)
+    , m_cpu(-1)
+    , m_node(0)
     , m_affinity(_affinity)
     , m_manager(_manager)
-    , m_threadId(id)
 {
 }
 
+TaskWorker::~TaskWorker()
+{
+    Task* task;
+    while (m_deque.pop(task)) {
+        task->heldSelf.reset();
+    }
+}
+
 void TaskWorker::start()
 {
     m_thread = std::thread(&TaskWorker::work, this);
 }
 
-// Return false if dit nothing
-void TaskWorker::process(TaskPtr task)
+void TaskWorker::stop()
+{
+    m_working = false;
+}
+
+void TaskWorker::process(const TaskPtr& task)
 {
     BE_PROFILE_FUNCTION();
-    if (task->isReady()) {
-        //LOG(EngineLog, BE_LOG_VERBOSE) << " processing task " << task;
+    //LOG(EngineLog, BE_LOG_VERBOSE) << " processing task " << task;
+
+    // Only this thread writes the counters, relaxed operations never contend
+    if (collectsStats()) {
+        const u64 latency = nowNs() - task->queuedAt;
+        m_counters.executed.fetch_add(1, std::memory_order_relaxed);
+        m_counters.latencyNs.fetch_add(latency, std::memory_order_relaxed);
+        u64 maxLatency = m_counters.maxLatencyNs.load(std::memory_order_relaxed);
+        while (latency > maxLatency && !m_counters.maxLatencyNs.compare_exchange_weak(maxLatency, latency, std::memory_order_relaxed)) {
+        }
+    }
 
-        task->execute();
+    task->execute();
 
-        if (task->isFrameRequired()) {
-            m_manager->incFinishedFrameRequired();
-        }
+    if (task->isFrameRequired()) {
+        m_manager->incFinishedFrameRequired();
+    }
 
-        if (task->isRepeating()) {
-            if (task->isOncePerFrame()) {
-                m_manager->scheduleToNextFrame(task);
-            }
-            else {
-                m_manager->addTask(task);
-            }
+    // Continuations go to this worker deque, their input is likely still in cache
+    task->releaseSuccessors([this](TaskPtr&& successor) { m_manager->enqueue(std::move(successor)); });
+
+    if (task->isRepeating()) {
+        if (task->isOncePerFrame()) {
+            m_manager->scheduleToNextFrame(task);
+        }
+        else {
+            m_manager->requeue(task);
         }
-        // Task done
-    }
-    else {
-        m_manager->addTask(task);
     }
 }
 
 void TaskWorker::work()
 {
+    t_currentWorker = this;
+    if (m_cpu >= 0 && !CpuTopology::pinCurrentThread(m_cpu)) {
+        LOG(EngineLog, BE_LOG_WARNING) << "Failed to pin worker " << m_threadId << " to cpu " << m_cpu;
+    }
+
     try {
-        do {
+        u32 idleRounds = 0;
+        while (m_working) {
             BE_PROFILE_FUNCTION();
+            // Read before looking for work, any task added after this wakes up park()
+            const u64 epoch = m_manager->m_workEpoch.load();
+
             TaskPtr task = nextTask();
-            if (task == nullptr) {
+            if (task != nullptr) {
+                if (idleRounds != 0) {
+                    endIdle();
+                }
+                process(task);
+                idleRounds = 0;
+            }
+            else if (++idleRounds < IDLE_ROUNDS_BEFORE_PARKING) {
+                if (idleRounds == 1) {
+                    beginIdle();
+                }
                 std::this_thread::yield();
             }
             else {
-                process(task);
+                m_manager->park(this, epoch);
+                // Still idle until a task is found
+                idleRounds = 1;
             }
-        } while (m_working);
+        }
+        endIdle();
         LOG(BitEngine::EngineLog, BE_LOG_INFO) << "Thread ended";
     }
     catch (...) {
         LOG(BitEngine::EngineLog, BE_LOG_ERROR) << "Thread failed!";
     }
+    t_currentWorker = nullptr;
 }
 
 TaskPtr TaskWorker::nextTask()
 {
     BE_PROFILE_FUNCTION();
-    TaskPtr newTask;
-    if (!m_taskQueue.tryPop(newTask)) {
-        if (m_affinity == Task::Affinity::BACKGROUND) {
-            u32 threadTest = m_threadId++;
-            while (threadTest != m_threadId) {
-                if (threadTest == 0) {
-                    ++threadTest;
-                }
-                TaskWorker* worker = m_manager->getWorker(threadTest);
-                if (worker->m_affinity == Task::Affinity::BACKGROUND && worker->m_taskQueue.tryPop(newTask)) {
-                    return newTask;
-                }
-                ++threadTest;
-            }
-            std::this_thread::yield();
-            m_taskQueue.pop(newTask);
-        }
+    TaskPtr task;
+
+    Task* queued;
+    if (m_deque.pop(queued)) {
+        return std::move(queued->heldSelf);
     }
-    else {
-        //LOG(EngineLog, BE_LOG_VERBOSE) << "poped: " << newTask << " from " << this;
+
+    if (m_manager->popShared(task)) {
+        return task;
+    }
+
+    task = stealTask();
+    if (task == nullptr) {
+        m_manager->popIdle(task);
+    }
+    return task;
+}
+
+bool TaskWorker::collectsStats() const
+{
+    return m_manager->m_configuration.m_CollectStats;
+}
+
+void TaskWorker::beginIdle()
+{
+    if (collectsStats()) {
+        m_counters.idleSince.store(nowNs(), std::memory_order_relaxed);
+    }
+}
+
+void TaskWorker::endIdle()
+{
+    if (!collectsStats()) {
+        return;
+    }
+
+    // The main thread may have taken the part until the frame end, the exchange gets what is left
+    const u64 since = m_counters.idleSince.exchange(0, std::memory_order_relaxed);
+    if (since != 0) {
+        const u64 now = nowNs();
+        if (now > since) {
+            m_counters.idleNs.fetch_add(now - since, std::memory_order_relaxed);
+        }
     }
+}
 
-    return newTask;
+TaskPtr TaskWorker::stealTask()
+{
+    for (const u32 victim : m_stealOrder) {
+        Task* queued;
+        if (m_manager->workers[victim]->m_deque.steal(queued)) {
+            m_counters.stolen.fetch_add(1, std::memory_order_relaxed);
+            return std::move(queued->heldSelf);
+        }
+    }
+    return nullptr;
 }
 
 void TaskWorker::wait()
@@ -100,8 +201,19 @@ void TaskWorker::wait()
 }
 
 GeneralTaskManager::GeneralTaskManager()
+    : GeneralTaskManager(TaskManagerConfiguration())
+{
+}
+
+GeneralTaskManager::GeneralTaskManager(const TaskManagerConfiguration& configuration)
     : TaskManager()
+    , m_configuration(configuration)
+    , m_idleCount(0)
+    , m_sharedCount(0)
+    , m_parkedWorkers(0)
+    , m_workEpoch(0)
     , mainThread(std::this_thread::get_id())
+    , m_frameStart(nowNs())
 {
     LOG(EngineLog, BE_LOG_INFO) << "Main thread: " << mainThread;
     requiredTasksFrame = 0;
@@ -111,29 +223,88 @@ GeneralTaskManager::GeneralTaskManager()
 
 void GeneralTaskManager::init()
 {
-    const int nThreads = 4; //std::thread::hardware_concurrency() + 1;
+    u32 backgroundWorkers = m_configuration.m_WorkerCount;
+    if (backgroundWorkers == 0) {
+        // The main thread keeps a CPU for itself
+        backgroundWorkers = std::max(static_cast<u32>(CpuTopology::getCpus().size()), 2u) - 1;
+    }
+
+    // Worker 0 is the main thread
+    const u32 nThreads = backgroundWorkers + 1;
     m_totalWorkers = nThreads;
 
     workers.resize(m_totalWorkers);
     LOG(EngineLog, BE_LOG_INFO) << "Task manager initializing " << nThreads << " threads";
 
-    for (int i = 0; i < nThreads; ++i) {
+    for (u32 i = 0; i < nThreads; ++i) {
         workers[i] = new TaskWorker(this, Task::Affinity::BACKGROUND, i);
     }
+    placeWorkers();
 
-    // Worker 0 is used for main tasks only
-    for (int i = 1; i < nThreads; ++i) {
+    for (u32 i = 1; i < nThreads; ++i) {
         workers[i]->start();
     }
 }
 
+void GeneralTaskManager::placeWorkers()
+{
+    if (m_configuration.m_PinThreads) {
+        // CPUs come sorted by node, the first one is left to the main thread.
+        // With more workers than CPUs, they wrap around and share.
+        const std::vector<CpuTopology::Cpu> cpus = CpuTopology::getCpus();
+        workers[0]->m_node = cpus[0].node;
+        for (u32 i = 1; i < workers.size(); ++i) {
+            const CpuTopology::Cpu& cpu = cpus[i % cpus.size()];
+            workers[i]->m_cpu = cpu.id;
+            workers[i]->m_node = cpu.node;
+        }
+    }
+
+    // Each worker starts with the one after it, so they don't all go after the same victim
+    const u32 count = static_cast<u32>(workers.size());
+    for (u32 i = 0; i < count; ++i) {
+        TaskWorker* worker = workers[i];
+        worker->m_stealOrder.clear();
+        for (u32 k = 1; k < count; ++k) {
+            worker->m_stealOrder.emplace_back((i + k) % count);
+        }
+        std::stable_partition(worker->m_stealOrder.begin(), worker->m_stealOrder.end(),
+            [this, worker](u32 victim) { return workers[victim]->m_node == worker->m_node; });
+    }
+}
+
+TaskManagerConfiguration GeneralTaskManager::loadConfiguration(EngineConfiguration& engineConfig)
+{
+    TaskManagerConfiguration configuration;
+    const double workerCount = engineConfig.getConfiguration("TaskManager", "Workers", "0")->getValueAsReal();
+    configuration.m_WorkerCount = workerCount > 0 ? static_cast<u32>(workerCount) : 0;
+    configuration.m_PinThreads = engineConfig.getConfiguration("TaskManager", "PinThreads", "false")->getValueAsBool();
+    configuration.m_CollectStats = engineConfig.getConfiguration("TaskManager", "CollectStats", "true")->getValueAsBool();
+    configuration.m_MainTaskBudgetMs = engineConfig.getConfiguration("TaskManager", "MainTaskBudgetMs", "2")->getValueAsReal();
+    return configuration;
+}
+
 void GeneralTaskManager::update()
 {
     BE_PROFILE_FUNCTION();
 
+    // Only the critical tasks queued until now, a repeating one would be queued again.
+    // Waits for the lock, a producer pushing at the same time must not make them skip a frame
     TaskPtr task;
-    workers[0]->m_taskQueue.tryPop(task);
-    if (task != nullptr) {
+    ThreadSafeQueue<TaskPtr>& critical = m_mainTasks[static_cast<u32>(Task::Priority::CRITICAL)];
+    for (size_t count = critical.size(); count > 0 && critical.popIfAny(task); --count) {
+        workers[0]->process(task);
+    }
+
+    // Critical tasks don't use the budget
+    const u64 start = nowNs();
+    const u64 budget = static_cast<u64>(m_configuration.m_MainTaskBudgetMs * 1000000.0);
+
+    // One normal task even over the budget, then normal and idle tasks while it lasts
+    if (popMain(task, Task::Priority::NORMAL)) {
+        workers[0]->process(task);
+    }
+    while (nowNs() - start < budget && popMain(task, Task::Priority::IDLE)) {
         workers[0]->process(task);
     }
 
@@ -146,6 +317,8 @@ void GeneralTaskManager::update()
 
 void GeneralTaskManager::prepareNextFrame()
 {
+    collectFrameStats();
+
     std::vector<TaskPtr> swaped;
     {
         std::lock_guard<std::mutex> lock(nextFrameTasksMutex);
@@ -157,7 +330,43 @@ void GeneralTaskManager::prepareNextFrame()
         addTaskMutex.unlock();
     }
     for (TaskPtr& task : swaped) {
-        addTask(task);
+        addTask(std::move(task));
+    }
+}
+
+void GeneralTaskManager::collectFrameStats()
+{
+    const u64 now = nowNs();
+    m_frameStats.frame++;
+    m_frameStats.frameMs = toMs(now - m_frameStart);
+    m_frameStart = now;
+
+    m_frameStats.mainQueueDepth = 0;
+    for (ThreadSafeQueue<TaskPtr>& queue : m_mainTasks) {
+        m_frameStats.mainQueueDepth += static_cast<u32>(queue.size());
+    }
+    m_frameStats.sharedQueueDepth = m_sharedCount.load(std::memory_order_relaxed) + m_idleCount.load(std::memory_order_relaxed);
+
+    m_frameStats.workers.resize(workers.size());
+    for (u32 i = 0; i < workers.size(); ++i) {
+        TaskWorker::Counters& counters = workers[i]->m_counters;
+        TaskWorkerStats& stats = m_frameStats.workers[i];
+
+        // Idle right now: count until here, the worker counts the rest when it finds work
+        u64 idleNs = 0;
+        u64 since = counters.idleSince.load(std::memory_order_relaxed);
+        if (since != 0 && since < now && counters.idleSince.compare_exchange_strong(since, now, std::memory_order_relaxed)) {
+            idleNs = now - since;
+        }
+        idleNs += counters.idleNs.exchange(0, std::memory_order_relaxed);
+
+        const u64 latencyNs = counters.latencyNs.exchange(0, std::memory_order_relaxed);
+        stats.tasksExecuted = counters.executed.exchange(0, std::memory_order_relaxed);
+        stats.tasksStolen = counters.stolen.exchange(0, std::memory_order_relaxed);
+        stats.queueDepth = workers[i]->m_deque.size();
+        stats.idleMs = toMs(idleNs);
+        stats.averageLatencyMs = stats.tasksExecuted > 0 ? toMs(latencyNs) / stats.tasksExecuted : 0;
+        stats.maxLatencyMs = toMs(counters.maxLatencyNs.exchange(0, std::memory_order_relaxed));
     }
 }
 
@@ -166,13 +375,22 @@ void GeneralTaskManager::shutdown()
     for (TaskWorker* tw : workers) {
         tw->stop();
     }
+    notifyAllWorkers();
 
     for (TaskWorker* tw : workers) {
         tw->wait();
+    }
+
+    // Only after every thread stopped, a worker may be stealing from any other
+    for (TaskWorker* tw : workers) {
         delete tw;
     }
 
     workers.clear();
+    m_sharedTasks.clear();
+    m_sharedCount = 0;
+    m_idleTasks.clear();
+    m_idleCount = 0;
 }
 
 void GeneralTaskManager::addTask(TaskPtr task)
@@ -185,15 +403,38 @@ void GeneralTaskManager::addTask(TaskPtr task)
         }
     } // unlock
 
+    // Tasks waiting for dependencies are queued by the worker finishing the last one
+    if (task->submit(task)) {
+        enqueue(std::move(task));
+    }
+}
+
+void GeneralTaskManager::enqueue(TaskPtr task)
+{
+    if (m_configuration.m_CollectStats) {
+        task->queuedAt = nowNs();
+    }
+
     if (task->getAffinity() == Task::Affinity::MAIN) {
-        workers[0]->m_taskQueue.push(task);
+        // Only the main thread runs them, and it never parks
+        m_mainTasks[static_cast<u32>(task->getPriority())].push(std::move(task));
+        return;
+    }
+
+    if (task->getPriority() == Task::Priority::IDLE) {
+        pushIdle(std::move(task));
+        return;
+    }
+
+    TaskWorker* worker = getCurrentWorker();
+    if (worker != nullptr) {
+        Task* queued = task.get();
+        queued->heldSelf = std::move(task);
+        worker->m_deque.push(queued);
+        notifyWork();
     }
     else {
-        m_pushCycle = ((m_pushCycle + 1) % (m_totalWorkers - 1));
-        u32 at = 1 + m_pushCycle;
-        BE_ASSERT(at > 0 && at < m_totalWorkers);
-        workers[at]->m_taskQueue.push(task);
-        //LOG(EngineLog, BE_LOG_VERBOSE) << "pushed: " << task << " to " << getWorker(at);
+        pushShared(std::move(task));
     }
 }
 
@@ -209,58 +450,164 @@ void GeneralTaskManager::waitTask(TaskPtr& task)
         throw std::domain_error("Only the main thread may wait for a task!");
     }
 
-    int k = 1;
     while (!task->isFinished()) {
-        executeWorkersWork(k++);
+        executeMain();
+    }
+}
+
+void GeneralTaskManager::runPendingTask()
+{
+    if (std::this_thread::get_id() == mainThread) {
+        executeMain();
+        return;
+    }
+
+    TaskWorker* worker = getCurrentWorker();
+    TaskPtr task = worker != nullptr ? worker->nextTask() : nullptr;
+    if (task != nullptr) {
+        worker->process(task);
+    }
+    else {
+        std::this_thread::yield();
     }
 }
 
 void GeneralTaskManager::executeMain()
 {
-    TaskPtr task = workers[0]->nextTask();
+    // Anything may be holding up what the main thread waits for, idle tasks included
+    TaskPtr task;
+    if (!popMain(task, Task::Priority::IDLE)) {
+        task = workers[0]->nextTask();
+    }
+
     if (task != nullptr) {
         workers[0]->process(task);
     }
     else {
-        executeWorkersWork(0);
+        workers[0]->beginIdle();
+        std::this_thread::yield();
+        workers[0]->endIdle();
     }
 }
 
-void GeneralTaskManager::executeWorkersWork(int i)
+bool GeneralTaskManager::popMain(TaskPtr& task, Task::Priority lowest)
 {
-    TaskPtr task;
-    int startedAt = clampToWorkers(i);
-    i = clampToWorkers(i);
-    do {
-        task = workers[i]->nextTask();
-        if (task != nullptr) {
-            break;
+    for (u32 i = 0; i <= static_cast<u32>(lowest); ++i) {
+        if (m_mainTasks[i].tryPop(task)) {
+            return true;
         }
-        i = clampToWorkers(i++);
-    } while (i != startedAt);
+    }
+    return false;
+}
 
-    if (task == nullptr) {
-        std::this_thread::yield();
+TaskWorker* GeneralTaskManager::getCurrentWorker()
+{
+    if (t_currentWorker != nullptr && t_currentWorker->m_manager == this) {
+        return t_currentWorker;
+    }
+    if (std::this_thread::get_id() == mainThread) {
+        return workers[0];
+    }
+    return nullptr;
+}
+
+void GeneralTaskManager::requeue(TaskPtr task)
+{
+    // Back to the end of the line, so it doesn't starve the tasks below it in the deque
+    if (m_configuration.m_CollectStats) {
+        task->queuedAt = nowNs();
+    }
+
+    if (task->getAffinity() == Task::Affinity::MAIN) {
+        m_mainTasks[static_cast<u32>(task->getPriority())].push(std::move(task));
+    }
+    else if (task->getPriority() == Task::Priority::IDLE) {
+        pushIdle(std::move(task));
     }
     else {
-        workers[0]->process(task);
+        pushShared(std::move(task));
     }
 }
 
-TaskWorker* GeneralTaskManager::getWorker(u32 index)
+void GeneralTaskManager::pushShared(TaskPtr task)
 {
-    return workers[clampToWorkers(index)];
+    {
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        if (task->getPriority() == Task::Priority::CRITICAL) {
+            m_sharedTasks.emplace_front(std::move(task));
+        }
+        else {
+            m_sharedTasks.emplace_back(std::move(task));
+        }
+        m_sharedCount.fetch_add(1, std::memory_order_release);
+    }
+    notifyWork();
 }
 
-void GeneralTaskManager::incFinishedFrameRequired()
+bool GeneralTaskManager::popShared(TaskPtr& task)
 {
-    std::lock_guard<std::mutex> lock(addTaskMutex);
-    ++finishedRequiredTasks;
+    if (m_sharedCount.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_sharedMutex);
+    if (m_sharedTasks.empty()) {
+        return false;
+    }
+    task = std::move(m_sharedTasks.front());
+    m_sharedTasks.pop_front();
+    m_sharedCount.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void GeneralTaskManager::pushIdle(TaskPtr task)
+{
+    // Counted first, a worker seeing the count before the task only misses it this time
+    m_idleCount.fetch_add(1, std::memory_order_release);
+    m_idleTasks.push(std::move(task));
+    notifyWork();
+}
+
+bool GeneralTaskManager::popIdle(TaskPtr& task)
+{
+    if (m_idleCount.load(std::memory_order_acquire) == 0 || !m_idleTasks.tryPop(task)) {
+        return false;
+    }
+    m_idleCount.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void GeneralTaskManager::notifyWork()
+{
+    // Both seq_cst: either the parking worker sees the new epoch, or we see it parked
+    m_workEpoch.fetch_add(1);
+    if (m_parkedWorkers.load() > 0) {
+        // A worker between checking the epoch and waiting holds the lock,
+        // taking it here makes sure the notification can't fall in between
+        { std::lock_guard<std::mutex> lock(m_parkMutex); }
+        m_parkCondition.notify_one();
+    }
+}
+
+void GeneralTaskManager::notifyAllWorkers()
+{
+    m_workEpoch.fetch_add(1);
+    { std::lock_guard<std::mutex> lock(m_parkMutex); }
+    m_parkCondition.notify_all();
 }
 
-u32 GeneralTaskManager::clampToWorkers(u32 value)
+void GeneralTaskManager::park(TaskWorker* worker, u64 epoch)
 {
-    return value = 1 + (value % (workers.size() - 1));
-    ;
+    BE_PROFILE_FUNCTION();
+    std::unique_lock<std::mutex> lock(m_parkMutex);
+    m_parkedWorkers.fetch_add(1);
+    m_parkCondition.wait(lock, [this, worker, epoch]() { return m_workEpoch.load() != epoch || !worker->m_working; });
+    m_parkedWorkers.fetch_sub(1);
+}
+
+void GeneralTaskManager::incFinishedFrameRequired()
+{
+    std::lock_guard<std::mutex> lock(addTaskMutex);
+    ++finishedRequiredTasks;
 }
 }
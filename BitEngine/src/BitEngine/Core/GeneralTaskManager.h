@@ -1,31 +1,62 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <map>
 #include <memory>
 
 #include "BitEngine/Common/ThreadSafeQueue.h"
+#include "BitEngine/Common/WorkStealingDeque.h"
 #include "BitEngine/Core/Messenger.h"
 #include "BitEngine/Core/TaskManager.h"
 
 namespace BitEngine {
 
+class EngineConfiguration;
 class GeneralTaskManager;
 
+class TaskManagerConfiguration {
+public:
+    // Threads running background tasks, besides the main thread
+    // 0 uses one thread for each CPU the process may run on, minus the main thread
+    u32 m_WorkerCount = 0;
+
+    // Pin each worker to its own CPU. CPUs are handed out one NUMA node at a time,
+    // so workers fill the first node before spilling into the next one, and idle workers
+    // steal from workers of their own node first.
+    bool m_PinThreads = false;
+
+    // Per frame counters of each worker (getFrameStats). Timing tasks reads the clock
+    // twice per task, turn it off to shave that from very small tasks.
+    bool m_CollectStats = true;
+
+    // Time update() spends on normal and idle main tasks each frame, in milliseconds.
+    // Critical main tasks always run, and one normal task runs per frame even over the budget
+    // so they keep moving. Whatever doesn't fit waits for the next frame.
+    // Tasks run while waiting for another task (waitTask, frame required tasks) don't count.
+    double m_MainTaskBudgetMs = 2.0;
+};
+
+/**
+ * A thread running background tasks.
+ * Each worker owns a work stealing deque: tasks added from the worker thread are pushed
+ * and popped there without locks, idle workers steal from the other deques.
+ * Worker 0 is the main thread, it owns the deque used by tasks added from the main thread
+ * and is the only one running main tasks.
+ * Workers that find no work park until a new task is added.
+ * Workers steal from the workers on their own NUMA node first.
+ */
 class TaskWorker {
     friend class GeneralTaskManager;
 
 public:
     TaskWorker(GeneralTaskManager* _manager, Task::Affinity _affinity, u32 id);
+    ~TaskWorker();
 
-    void stop()
-    {
-        m_working = false;
-        m_taskQueue.clear();
-    }
+    void stop();
 
-    // Return true if did some work on a task
+    // Run tasks until stopped
     void work();
 
     // Wait thread to finish
@@ -33,62 +64,146 @@ public:
 
 private:
     TaskPtr nextTask();
+    TaskPtr stealTask();
     void start();
-    void process(TaskPtr task);
+    void process(const TaskPtr& task);
+
+    // Idle time is counted from the moment no task was found
+    void beginIdle();
+    void endIdle();
 
-    bool m_working;
+    bool collectsStats() const;
+
+    std::atomic<bool> m_working;
     u32 m_threadId;
+    s32 m_cpu; // CPU the thread is pinned to, -1 if not pinned
+    u32 m_node; // NUMA node of m_cpu
+    std::vector<u32> m_stealOrder; // other workers, same node first
     Task::Affinity m_affinity;
     GeneralTaskManager* m_manager;
 
     std::thread m_thread;
-    ThreadSafeQueue<TaskPtr> m_taskQueue;
+
+    // The task reference is kept in Task::heldSelf while it is in the deque,
+    // so pushing and taking tasks doesn't allocate or touch the reference count
+    WorkStealingDeque<Task*> m_deque;
+
+    // Written by the worker thread, taken by the main thread when the frame ends
+    struct Counters {
+        std::atomic<u32> executed{ 0 };
+        std::atomic<u32> stolen{ 0 };
+        std::atomic<u64> idleNs{ 0 };
+        std::atomic<u64> latencyNs{ 0 };
+        std::atomic<u64> maxLatencyNs{ 0 };
+        // When the worker became idle, 0 while working.
+        // The main thread moves it to the frame end, so a worker parked for the whole frame
+        // still shows as idle.
+        std::atomic<u64> idleSince{ 0 };
+    };
+    alignas(64) Counters m_counters;
 };
 
 class BE_API GeneralTaskManager : public TaskManager {
 public:
     GeneralTaskManager();
+    explicit GeneralTaskManager(const TaskManagerConfiguration& configuration);
     ~GeneralTaskManager() { shutdown(); }
 
     void init() override;
     void update() override;
     void shutdown() override;
 
+    using TaskManager::addTask;
     void addTask(TaskPtr task) override;
     void scheduleToNextFrame(TaskPtr task) override;
     void waitTask(TaskPtr& task) override;
+    void runPendingTask() override;
 
     const std::vector<TaskPtr>& getTasks() const override { return scheduledTasks; }
 
+    // Worker 0 is the main thread
+    u32 getWorkerCount() const override { return m_totalWorkers - 1; }
+
+    const TaskFrameStats& getFrameStats() const override { return m_frameStats; }
+
     void verifyMainThread() const override
     {
         BE_ASSERT(std::this_thread::get_id() == mainThread);
     }
 
+    // Reads the "TaskManager" section: Workers (0 for automatic), PinThreads, CollectStats
+    // and MainTaskBudgetMs
+    static TaskManagerConfiguration loadConfiguration(EngineConfiguration& engineConfig);
+
 private:
     friend class TaskWorker;
-    TaskWorker* getWorker(u32 index);
     void prepareNextFrame();
+    void collectFrameStats();
 
     void executeMain();
-    void executeWorkersWork(int i);
+
+    // Main task of priority up to lowest, the most urgent first
+    bool popMain(TaskPtr& task, Task::Priority lowest);
+
+    // Worker of this manager running on the calling thread, nullptr for other threads
+    TaskWorker* getCurrentWorker();
+
+    // Queue a task that is ready to run
+    void enqueue(TaskPtr task);
+
+    // Add again a repeating task, it already counts for the frame
+    void requeue(TaskPtr task);
+
+    // Queue shared by all workers, for tasks added from threads that are not workers
+    // and for requeued tasks
+    void pushShared(TaskPtr task);
+    bool popShared(TaskPtr& task);
+
+    // Background tasks with idle priority, taken when there is nothing else to do
+    void pushIdle(TaskPtr task);
+    bool popIdle(TaskPtr& task);
+
+    // Wake a parked worker after adding work
+    void notifyWork();
+    void notifyAllWorkers();
+
+    // Sleep until notifyWork is called after epoch was read, or until the worker is stopped
+    void park(TaskWorker* worker, u64 epoch);
 
     void incFinishedFrameRequired();
 
-    u32 clampToWorkers(u32 value);
+    // Pick the CPU of each worker and the order they steal from each other
+    void placeWorkers();
 
     std::vector<TaskWorker*> workers;
+    TaskManagerConfiguration m_configuration;
 
     u32 requiredTasksFrame;
     u32 m_totalWorkers;
-    u32 m_pushCycle;
 
     std::mutex addTaskMutex;
     std::mutex nextFrameTasksMutex;
     std::vector<TaskPtr> scheduledTasks;
 
+    ThreadSafeQueue<TaskPtr> m_mainTasks[static_cast<u32>(Task::Priority::COUNT)];
+
+    ThreadSafeQueue<TaskPtr> m_idleTasks;
+    std::atomic<u32> m_idleCount; // checked before taking the lock
+
+    std::mutex m_sharedMutex;
+    std::deque<TaskPtr> m_sharedTasks;
+    std::atomic<u32> m_sharedCount; // checked before taking the lock
+
+    std::mutex m_parkMutex;
+    std::condition_variable m_parkCondition;
+    std::atomic<u32> m_parkedWorkers;
+    std::atomic<u64> m_workEpoch; // incremented every time work is added
+
     const std::thread::id mainThread;
 
     u32 finishedRequiredTasks;
+
+    TaskFrameStats m_frameStats;
+    u64 m_frameStart;
 };
 }
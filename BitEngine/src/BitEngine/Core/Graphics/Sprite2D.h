@@ -30,12 +30,13 @@ public:
 template <>
 class BE_API ComponentHolder<Sprite2DComponent> : public BaseComponentHolder {
 public:
-    ComponentHolder()
-        : BaseComponentHolder(sizeof(Sprite2DComponent))
+    ComponentHolder(StorageMode mode = StorageMode::STABLE)
+        : BaseComponentHolder(sizeof(Sprite2DComponent), 128, mode)
     {
     }
 
     Messenger<MsgComponentCreated<Sprite2DComponent> > componentCreatedSignal;
+    Messenger<MsgComponentsCreated<Sprite2DComponent> > componentsCreatedSignal;
     Messenger<MsgComponentDestroyed<Sprite2DComponent> > componentDestroyedSignal;
 
     bool init() override
@@ -1,25 +1,43 @@
 #pragma once
 
+#include <algorithm>
 #include <set>
 #include <vector>
 #include <functional>
 #include <map>
 #include <memory>
+#include <type_traits>
 #include <typeindex>
 #include <cstring>
 
-#include "BitEngine/Common/Vector.h"
+#include "BitEngine/Common/Delegate.h"
 
 #include "BitEngine/Core/Assert.h"
 #include "BitEngine/Common/TypeDefinition.h"
 
+// Define to get a profiler event for every emit() call
+// #define BE_PROFILE_MESSENGER
+
+#ifdef BE_PROFILE_MESSENGER
+#define BE_MESSENGER_PROFILE() BE_PROFILE_FUNCTION()
+#else
+#define BE_MESSENGER_PROFILE()
+#endif
+
 namespace BitEngine {
 
-template <typename EventType, ptrsize MaxSubs = 4, ptrsize MaxQueued = 4>
+/**
+ * Calls every subscriber when a message is emitted.
+ * Subscribers are Delegates: emitting to a member function or a small lambda is one indirect
+ * call each, without allocations. Any number of subscribers, they are called in the order
+ * they subscribed.
+ * Subscribers may subscribe and unsubscribe while being called: the changes apply when emit
+ * returns, a new subscriber gets the next messages, a removed one isn't called again.
+ * Not thread safe, subscribe and emit from the thread owning the messenger.
+ */
+template <typename EventType>
 class BE_API Messenger : public NonCopyable, NonAssignable {
 private:
-    using call_type = std::function<void(const EventType&)>;
-
     template <class Handler>
     using member_func_t = void (Handler::*)(const EventType&);
 
@@ -27,37 +45,63 @@ private:
     typedef u32 SubsHandle;
 
 public:
+    using Callback = Delegate<void(const EventType&)>;
+
     Messenger()
         : handles(0)
+        , m_emitting(0)
+        , m_removedWhileEmitting(false)
+    {
+    }
+
+    // Callback calling Method on handler, Method is resolved at compile time:
+    // Messenger<Msg>::bind<Handler, &Handler::onMessage>(this)
+    template <typename Handler, member_func_t<Handler> Method>
+    static Callback bind(Handler* handler)
     {
+        return Callback::template bind<Handler, Method>(handler);
+    }
+
+    template <typename Handler, member_func_t<Handler> Method>
+    SubsHandle subscribe(Handler* handler)
+    {
+        return subscribe(bind<Handler, Method>(handler));
     }
 
     template <typename Handler>
     SubsHandle subscribe(member_func_t<Handler> func, Handler* handler)
     {
-        auto f = [handler, func](const EventType& ev) -> void { (handler->*func)(ev); };
-        return subscribe(f);
+        return subscribe(Callback::bind(handler, func));
     }
 
     /**
     * Subscriber a handler to an EventType.
-    * The handler method should follow the signature: void (const EventType&)
+    * The handler should follow the signature: void (const EventType&)
     */
-    SubsHandle subscribe(call_type callable)
+    SubsHandle subscribe(Callback callable)
     {
         SubsHandle handle = ++handles;
-        m_subscribers.emplace_back(callback_handle{ CallbackWrapper(callable), handle });
+        // Growing m_subscribers during emit would move the subscriber being called
+        std::vector<callback_handle>& target = m_emitting != 0 ? m_addedWhileEmitting : m_subscribers;
+        target.emplace_back(callback_handle{ std::move(callable), handle });
         return handle;
     }
 
     void unsubscribe(SubsHandle handle)
     {
-        for (auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
-            if (it->handle == handle) {
-                m_subscribers.erase(it);
-                break;
+        if (m_emitting != 0) {
+            // Only mark it, it may be the subscriber being called
+            for (callback_handle& subscriber : m_subscribers) {
+                if (subscriber.handle == handle) {
+                    subscriber.handle = REMOVED_HANDLE;
+                    m_removedWhileEmitting = true;
+                    return;
+                }
             }
+            removeSubscriber(m_addedWhileEmitting, handle);
+            return;
         }
+        removeSubscriber(m_subscribers, handle);
     }
 
     /**
@@ -65,14 +109,21 @@ public:
     */
     void emit(const EventType& event)
     {
-        BE_PROFILE_FUNCTION();
-        for (auto& receiver : m_subscribers) {
-            receiver.callback(event);
+        BE_MESSENGER_PROFILE();
+        ++m_emitting;
+        for (const callback_handle& receiver : m_subscribers) {
+            if (receiver.handle != REMOVED_HANDLE) {
+                receiver.callback(event);
+            }
+        }
+        if (--m_emitting == 0 && (m_removedWhileEmitting || !m_addedWhileEmitting.empty())) {
+            applyChangesMadeWhileEmitting();
         }
     }
 
     /**
     * Emit a message that is deferred until a dispatch() call.
+    * Same thread only, events posted from other threads go through an EventBus.
     */
     void enqueue(const EventType& event)
     {
@@ -81,37 +132,56 @@ public:
 
     /**
     * Dispatch all enqueued messages in the order that they were enqueued.
+    * Messages enqueued by the subscribers meanwhile wait for the next dispatch().
     */
     void dispatch()
     {
-        for (const EventType& data : m_enqueuedEventData) {
+        m_dispatchingEventData.swap(m_enqueuedEventData);
+        for (const EventType& data : m_dispatchingEventData) {
             emit(data);
         }
+        m_dispatchingEventData.clear();
     }
 
 private:
     struct callback_handle {
-        call_type callback;
+        Callback callback;
         SubsHandle handle;
     };
 
-    TightFixedVector<callback_handle, MaxSubs> m_subscribers;
-    TightFixedVector<EventType, MaxQueued> m_enqueuedEventData;
-    u32 handles;
+    // Handles start at 1
+    static constexpr SubsHandle REMOVED_HANDLE = 0;
 
-    struct CallbackWrapper {
-        CallbackWrapper(const call_type& callable)
-            : m_callable(callable)
-        {
+    static void removeSubscriber(std::vector<callback_handle>& subscribers, SubsHandle handle)
+    {
+        for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+            if (it->handle == handle) {
+                subscribers.erase(it);
+                break;
+            }
         }
+    }
 
-        void operator()(const EventType& msg)
-        {
-            m_callable(msg);
+    void applyChangesMadeWhileEmitting()
+    {
+        if (m_removedWhileEmitting) {
+            auto removed = [](const callback_handle& s) { return s.handle == REMOVED_HANDLE; };
+            m_subscribers.erase(std::remove_if(m_subscribers.begin(), m_subscribers.end(), removed), m_subscribers.end());
+            m_removedWhileEmitting = false;
+        }
+        for (callback_handle& subscriber : m_addedWhileEmitting) {
+            m_subscribers.emplace_back(std::move(subscriber));
         }
+        m_addedWhileEmitting.clear();
+    }
 
-        call_type m_callable;
-    };
+    std::vector<callback_handle> m_subscribers;
+    std::vector<callback_handle> m_addedWhileEmitting;
+    std::vector<EventType> m_enqueuedEventData;
+    std::vector<EventType> m_dispatchingEventData; // keeps its memory between dispatches
+    u32 handles;
+    u32 m_emitting; // emit calls running, a subscriber may emit again
+    bool m_removedWhileEmitting;
 
 public:
     class ScopedSubscription {
@@ -122,10 +192,10 @@ public:
         {
             handle = messenger.subscribe(func, handler);
         }
-        ScopedSubscription(Messenger<EventType>& msg, call_type call)
+        ScopedSubscription(Messenger<EventType>& msg, Callback call)
             : messenger(msg)
         {
-            handle = messenger.subscribe(call);
+            handle = messenger.subscribe(std::move(call));
         }
         ScopedSubscription(Messenger<EventType>& msg, u32 h)
             : messenger(msg)
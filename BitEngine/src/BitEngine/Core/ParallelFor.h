@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "BitEngine/Common/TypeDefinition.h"
+#include "BitEngine/Core/TaskManager.h"
+#include "BitEngine/Core/TaskPool.h"
+
+namespace BitEngine {
+
+/**
+ * Shared state of a parallelForRange call.
+ * Chunks are claimed with an atomic counter, so the calling thread and any number
+ * of helper tasks can work on the same range.
+ * Chunk sizes adapt to the remaining work: each claim takes a share of what is left for
+ * every thread, never less than grainSize, so the first chunks are big and there are many
+ * small ones at the end to even out threads that started late or got slowed down.
+ * Chunks always start at a multiple of grainSize.
+ * The range function is only touched after a chunk was claimed, so helper tasks that
+ * start after the range is done never access the (already gone) caller stack.
+ */
+class ParallelRangeJob {
+public:
+    typedef void (*RangeFunc)(void* context, u32 first, u32 last);
+
+    ParallelRangeJob(u32 size, u32 grainSize, u32 threads, RangeFunc func, void* context)
+        : m_size(size)
+        , m_grainSize(grainSize)
+        , m_threads(std::max(threads, 1u))
+        , m_func(func)
+        , m_context(context)
+        , m_next(0)
+        , m_finished(0)
+    {
+    }
+
+    // Chunks of grainSize, the most chunks a call may be split in
+    u32 getMaxChunkCount() const { return (m_size + m_grainSize - 1) / m_grainSize; }
+
+    // Run chunks until there are none left to claim
+    void work()
+    {
+        u32 first = m_next.load(std::memory_order_relaxed);
+        while (first < m_size) {
+            const u32 last = first + chunkSize(m_size - first);
+            if (!m_next.compare_exchange_weak(first, last, std::memory_order_relaxed)) {
+                continue; // first was updated with the new value
+            }
+
+            const u32 end = std::min(last, m_size);
+            m_func(m_context, first, end);
+            m_finished.fetch_add(end - first, std::memory_order_release);
+            first = m_next.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool isDone() const
+    {
+        return m_finished.load(std::memory_order_acquire) == m_size;
+    }
+
+private:
+    u32 chunkSize(u32 remaining) const
+    {
+        const u32 share = remaining / (m_threads * 2);
+        return std::max(share - share % m_grainSize, m_grainSize);
+    }
+
+    const u32 m_size;
+    const u32 m_grainSize;
+    const u32 m_threads;
+    const RangeFunc m_func;
+    void* const m_context;
+    std::atomic<u32> m_next;
+    std::atomic<u32> m_finished; // elements done
+};
+
+class ParallelRangeTask : public Task {
+public:
+    ParallelRangeTask(std::shared_ptr<ParallelRangeJob> job)
+        : Task(TaskMode::NONE, Affinity::BACKGROUND)
+        , m_job(job)
+    {
+    }
+
+private:
+    void run() override
+    {
+        m_job->work();
+    }
+
+    std::shared_ptr<ParallelRangeJob> m_job;
+};
+
+/**
+ * Split [0, size) in chunks of at least grainSize and call f(first, last) for each chunk.
+ * Chunks run on the task manager workers and on the calling thread.
+ * Returns only after all chunks finished, the calling thread runs other queued tasks
+ * while waiting for the last ones.
+ * Without a task manager, or when there is a single chunk, f is called once on the calling thread.
+ */
+template <typename Func>
+void parallelForRange(TaskManager* taskManager, u32 size, u32 grainSize, Func&& f)
+{
+    if (size == 0) {
+        return;
+    }
+
+    grainSize = std::max(grainSize, 1u);
+    if (taskManager == nullptr || size <= grainSize || taskManager->getWorkerCount() == 0) {
+        f(0u, size);
+        return;
+    }
+
+    typedef typename std::remove_reference<Func>::type FuncType;
+    const u32 threads = taskManager->getWorkerCount() + 1;
+    auto job = makeTask<ParallelRangeJob>(size, grainSize, threads, [](void* context, u32 first, u32 last) { (*static_cast<FuncType*>(context))(first, last); }, &f);
+
+    // The calling thread also works, so one chunk is left for it
+    const u32 helpers = std::min(job->getMaxChunkCount() - 1, taskManager->getWorkerCount());
+    for (u32 i = 0; i < helpers; ++i) {
+        taskManager->addTask(makeTask<ParallelRangeTask>(job));
+    }
+
+    // Other threads may still be running chunks, help with the queued work meanwhile,
+    // on the main thread that includes the MAIN tasks
+    job->work();
+    while (!job->isDone()) {
+        taskManager->runPendingTask();
+    }
+}
+
+/**
+ * Call f(i) for every i in [begin, end), in parallel.
+ * grainSize is the least number of indices a task runs, keep it large enough that a chunk
+ * takes a few microseconds.
+ * f is called concurrently and must only write data owned by its index.
+ */
+template <typename Func>
+void parallelFor(TaskManager* taskManager, u32 begin, u32 end, u32 grainSize, Func&& f)
+{
+    if (end <= begin) {
+        return;
+    }
+
+    parallelForRange(taskManager, end - begin, grainSize, [begin, &f](u32 first, u32 last) {
+        for (u32 i = begin + first; i < begin + last; ++i) {
+            f(i);
+        }
+    });
+}
+
+/**
+ * Reduce [begin, end) in parallel.
+ * rangeFunc(first, last, partial) folds the indices [first, last) into partial and returns it,
+ * it's called for each chunk with identity as partial.
+ * combine(a, b) merges two partial results. Chunks finish in any order, so combine must be
+ * associative and commutative (floating point sums may differ in the last bits between runs).
+ * T must be copyable, identity must not change the result when combined.
+ */
+template <typename T, typename RangeFunc, typename Combine>
+T parallelReduce(TaskManager* taskManager, u32 begin, u32 end, u32 grainSize, const T& identity, RangeFunc&& rangeFunc, Combine&& combine)
+{
+    if (end <= begin) {
+        return identity;
+    }
+
+    T result = identity;
+    std::mutex resultMutex;
+    parallelForRange(taskManager, end - begin, grainSize, [&](u32 first, u32 last) {
+        T partial = rangeFunc(begin + first, begin + last, identity);
+        std::lock_guard<std::mutex> lock(resultMutex);
+        result = combine(result, partial);
+    });
+    return result;
+}
+}
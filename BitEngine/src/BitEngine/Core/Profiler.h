@@ -21,13 +21,14 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <thread>
 
-#include "BitEngine/Common/ThreadSafeQueue.h"
+#include "BitEngine/Common/RingQueue.h"
 
 namespace BitEngine {
 
@@ -41,12 +42,14 @@ namespace Profiling {
         long long start, end;
     };
 
+    // Every thread writes, only the writer thread reads
+    using ProfileQueue = BlockingQueue<MpscRingQueue<ProfileResult> >;
+
     class ChromeProfilerWriter {
     public:
-        ChromeProfilerWriter(ThreadSafeQueue<ProfileResult>* dataQueue, const std::string& filepath = "profiling.json")
+        ChromeProfilerWriter(ProfileQueue* dataQueue, const std::string& filepath = "profiling.json")
             : queue(dataQueue)
             , m_profileCount(0)
-            , active(1)
         {
 
             m_outputStream.open(filepath);
@@ -83,20 +86,15 @@ namespace Profiling {
             ProfileResult data;
             WriteHeader();
 
+            // Returns false once stopped and everything was written
             int cacheFlush = 0;
-            while (active) {
-                while (active && queue->pop(data)) {
-                    writeProfile(data);
-
-                    if (++cacheFlush > 20) {
-                        m_outputStream.flush();
-                        cacheFlush = 0;
-                    }
-                }
-            }
-
-            while (queue->tryPop(data)) {
+            while (queue->pop(data)) {
                 writeProfile(data);
+
+                if (++cacheFlush > 20) {
+                    m_outputStream.flush();
+                    cacheFlush = 0;
+                }
             }
 
             WriteFooter();
@@ -106,7 +104,7 @@ namespace Profiling {
 
         void stop()
         {
-            active = false;
+            queue->release();
         }
 
         void WriteHeader()
@@ -122,26 +120,36 @@ namespace Profiling {
         }
 
     private:
-        ThreadSafeQueue<ProfileResult>* queue;
+        ProfileQueue* queue;
         std::ofstream m_outputStream;
         int m_profileCount;
-        volatile bool active = true;
     };
 
     class ChromeProfiler {
     public:
         ChromeProfiler()
+            : queue(QUEUE_CAPACITY)
+            , dropped(0)
         {
         }
 
+        // Lock free, when the writer can't keep up the result is dropped and counted
         void writeProfile(const ProfileResult& result)
         {
-            queue.push(result);
+            if (!queue.push(result)) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        uint32_t getDroppedCount() const
+        {
+            return dropped.load(std::memory_order_relaxed);
         }
 
         void BeginSession(const std::string& name)
         {
             m_session.name = name;
+            queue.reopen();
             writer = new ChromeProfilerWriter(&queue);
             thread = std::thread(&ChromeProfilerWriter::work, writer);
         }
@@ -149,7 +157,6 @@ namespace Profiling {
         void EndSession()
         {
             writer->stop();
-            queue.notify();
             thread.join();
             delete writer;
         }
@@ -161,7 +168,10 @@ namespace Profiling {
             std::string name;
         };
 
-        ThreadSafeQueue<ProfileResult> queue;
+        static constexpr uint32_t QUEUE_CAPACITY = 1 << 14;
+
+        ProfileQueue queue;
+        std::atomic<uint32_t> dropped;
         ProfilingSession m_session;
         std::thread thread;
         ChromeProfilerWriter* writer;
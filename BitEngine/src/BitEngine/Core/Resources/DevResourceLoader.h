@@ -11,7 +11,7 @@
 
 #include "BitEngine/Core/Math.h"
 #include "BitEngine/Core/IO/File.h"
-#include "BitEngine/Common/ThreadSafeQueue.h"
+#include "BitEngine/Common/RingQueue.h"
 
 namespace BitEngine {
 class BaseResource;
@@ -107,6 +107,7 @@ public:
     FolderFileManager(TaskManager* tm, MemoryArena& _arena)
         : taskManager(tm)
         , arena(_arena)
+        , loadingFiles(MAX_FILES)
     {
     }
     ~FolderFileManager()
@@ -118,21 +119,20 @@ public:
     {
         BE_PROFILE_FUNCTION();
         std::pair<File*, FileLoadTask> task;
+        while (loadingFiles.tryPop(task)) {
+            stillLoading.emplace_back(std::move(task));
+        }
 
-        std::vector<std::pair<File*, FileLoadTask> > retry;
-
-        if (loadingFiles.tryPop(task)) {
-            auto& dr = task.second->getData();
+        // Files still loading are kept here, they never go back to the queue
+        for (ptrsize i = 0; i < stillLoading.size();) {
+            auto& dr = stillLoading[i].second->getData();
             if (dr.loadState == ResourceLoader::DataRequest::LoadState::LS_LOADING) {
-                retry.emplace_back(task);
-            }
-            else {
-                finishedLoading(task.first->getMeta());
+                ++i;
+                continue;
             }
-        }
-
-        for (auto& it : retry) {
-            loadingFiles.push(it);
+            finishedLoading(stillLoading[i].first->getMeta());
+            stillLoading[i] = std::move(stillLoading.back());
+            stillLoading.pop_back();
         }
     }
 
@@ -171,7 +171,10 @@ public:
                 taskManager->addTask(task);
                 it.first->second = task;
 
-                loadingFiles.push({ found, task });
+                // Each file is pushed once and the queue fits all of them, there is always space
+                if (!loadingFiles.push(found, task)) {
+                    BE_INVALID_PATH("Loading files queue is full");
+                }
                 return { task, found };
             }
             else {
@@ -219,8 +222,11 @@ private:
     MemoryArena& arena;
     TaskManager* taskManager;
 
-    ResourceIndexer<File, 1024> files;
-    ThreadSafeQueue<std::pair<File*, FileLoadTask> > loadingFiles;
+    static constexpr u32 MAX_FILES = 1024;
+
+    ResourceIndexer<File, MAX_FILES> files;
+    MpscRingQueue<std::pair<File*, FileLoadTask> > loadingFiles;
+    std::vector<std::pair<File*, FileLoadTask> > stillLoading; // taken from loadingFiles by update()
 
     std::mutex waitingTasksMutex;
     std::map<ResourceMeta*, FileLoadTask> waitingData; // the resources that are waiting the raw data to be loaded
@@ -1,13 +1,19 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "BitEngine/Core/Assert.h"
 
 namespace BitEngine {
 
 class Task;
+class TaskGraph;
+class TaskWorker;
+class GeneralTaskManager;
 
 typedef std::shared_ptr<Task> TaskPtr;
 
@@ -20,7 +26,18 @@ struct MsgTaskCompleted {
     std::shared_ptr<Task> m_task;
 };
 
-class Task {
+/**
+ * Unit of work run by a TaskManager.
+ * Dependencies are tracked with an atomic counter of unfinished dependencies and a list of
+ * successors: a task added while it still has dependencies is parked by the task manager,
+ * and the worker finishing its last dependency queues it. Nothing is polled.
+ * Tasks must be owned by a shared_ptr (std::make_shared) to be used as dependencies.
+ */
+class Task : public std::enable_shared_from_this<Task> {
+    friend class TaskGraph;
+    friend class TaskWorker;
+    friend class GeneralTaskManager;
+
 public:
     enum class TaskMode {
         NONE = 0x0,
@@ -39,25 +56,53 @@ public:
         BACKGROUND = 1,
     };
 
+    // Order tasks of the same affinity are taken in
+    enum class Priority {
+        CRITICAL = 0, // needed this frame, main tasks run even over the frame budget
+        NORMAL = 1,
+        IDLE = 2, // streaming and other work that can wait, only runs when nothing else is queued
+                  // or, for main tasks, with the frame budget left
+        COUNT
+    };
+
     Task(TaskMode _flags, Affinity _affinity)
         : flags(_flags)
         , affinity(_affinity)
         , remainingWork(1)
+        , pendingDependencies(NOT_SUBMITTED)
+        , releasedSuccessors(0)
+        , queuedAt(0)
+        , priority(Priority::NORMAL)
     {
     }
     virtual ~Task() {}
 
     TaskMode getFlags() const { return flags; }
     Affinity getAffinity() const { return affinity; }
+    Priority getPriority() const { return priority; }
+
+    // Must be called before the task is added to the task manager
+    void setPriority(Priority p)
+    {
+        priority = p;
+    }
 
     void execute()
     {
         run();
+
+        // Ready to be added again
+        pendingDependencies = NOT_SUBMITTED;
+
         if (isRepeating()) {
             remainingWork = 1;
         }
         else {
+            // Successors that registered before this point are released by the task manager,
+            // the ones registering after see the task finished and don't wait for it
+            std::lock_guard<std::mutex> lock(successorsMutex);
             remainingWork = 0;
+            releasedSuccessors = static_cast<u32>(successors.size());
         }
     }
 
@@ -66,25 +111,17 @@ public:
         return remainingWork == 0;
     }
 
+    // All dependencies finished
     bool isReady()
     {
-        if (remainingWork > 1) {
-            int remaining = 0;
-            for (TaskPtr& t : waitingTasks) {
-                if (!t->isFinished()) {
-                    ++remaining;
-                }
-            }
-            remainingWork = 1 + remaining;
-        }
-
-        return remainingWork <= 1;
+        return (pendingDependencies & ~NOT_SUBMITTED) == 0;
     }
 
+    // This task will only run after task finishes
+    // Must be called before this task is added to the task manager
     void addDependency(TaskPtr task)
     {
-        ++remainingWork;
-        waitingTasks.emplace_back(task);
+        addDependency(task, false);
     }
 
     bool isRepeating()
@@ -121,11 +158,87 @@ protected:
 private:
     virtual void run() = 0;
 
+    // Set in pendingDependencies until the task is added to the task manager,
+    // so it can't be queued by its dependencies before that
+    static constexpr u32 NOT_SUBMITTED = 1u << 31;
+
+    // keep: the dependency is kept for the next runs of task (TaskGraph)
+    void addDependency(const TaskPtr& task, bool keep)
+    {
+        BE_ASSERT(!weak_from_this().expired());
+        waitingTasks.emplace_back(task);
+
+        std::lock_guard<std::mutex> lock(task->successorsMutex);
+        if (!task->isFinished()) {
+            task->successors.emplace_back(Successor{ weak_from_this(), keep });
+            ++pendingDependencies;
+        }
+        else if (keep) {
+            task->successors.emplace_back(Successor{ weak_from_this(), keep });
+        }
+    }
+
+    // Called when the task is added, returns true if it can be queued now.
+    // Otherwise the task keeps itself alive until its last dependency releases it.
+    bool submit(TaskPtr& self)
+    {
+        heldSelf = self;
+        const u32 before = pendingDependencies.fetch_sub(NOT_SUBMITTED, std::memory_order_acq_rel);
+        BE_ASSERT((before & NOT_SUBMITTED) != 0); // added twice before running
+        if (before == NOT_SUBMITTED) {
+            heldSelf.reset();
+            return true;
+        }
+        return false;
+    }
+
+    // Called by the task manager after execute(), f receives each successor that became ready
+    template <typename Func>
+    void releaseSuccessors(Func&& f)
+    {
+        std::lock_guard<std::mutex> lock(successorsMutex);
+        for (u32 i = 0; i < releasedSuccessors; ++i) {
+            TaskPtr successor = successors[i].task.lock();
+            if (successor != nullptr && successor->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                f(std::move(successor->heldSelf));
+            }
+        }
+
+        // One time dependencies are done
+        auto end = std::remove_if(successors.begin(), successors.begin() + releasedSuccessors, [](const Successor& s) { return !s.keep; });
+        successors.erase(end, successors.begin() + releasedSuccessors);
+        releasedSuccessors = 0;
+    }
+
+    // Start a new run with the given number of unfinished dependencies, used by TaskGraph
+    void reset(u32 dependencies)
+    {
+        remainingWork = 1;
+        pendingDependencies = NOT_SUBMITTED + dependencies;
+    }
+
     TaskMode flags;
     Affinity affinity;
     std::vector<TaskPtr> waitingTasks; // tasks this task must wait before it can run
     std::atomic<u32> remainingWork;
 
+    std::atomic<u32> pendingDependencies; // unfinished dependencies, plus NOT_SUBMITTED
+    // Keeps the task alive while only raw pointers to it exist: parked waiting for
+    // dependencies, or queued in a worker deque
+    TaskPtr heldSelf;
+
+    struct Successor {
+        std::weak_ptr<Task> task;
+        bool keep; // wait for this task again on the next run
+    };
+
+    std::mutex successorsMutex;
+    std::vector<Successor> successors; // tasks waiting for this one
+    u32 releasedSuccessors; // successors to release after the current run
+
+    u64 queuedAt; // when it was last queued to run, for the task manager stats
+    Priority priority;
+
     template <typename T>
     static constexpr typename std::underlying_type<T>::type enum_value(T val)
     {
@@ -0,0 +1,51 @@
+#include "BitEngine/Core/TaskGraph.h"
+
+namespace BitEngine {
+
+void TaskGraph::add(TaskPtr task)
+{
+    BE_ASSERT(!task->isRepeating());
+    BE_ASSERT(m_indices.find(task.get()) == m_indices.end());
+    m_indices.emplace(task.get(), static_cast<u32>(m_tasks.size()));
+    m_tasks.emplace_back(std::move(task));
+    m_dependencyCounts.emplace_back(0);
+}
+
+void TaskGraph::addDependency(const TaskPtr& task, const TaskPtr& dependency)
+{
+    BE_ASSERT(m_indices.find(dependency.get()) != m_indices.end());
+    auto it = m_indices.find(task.get());
+    BE_ASSERT(it != m_indices.end());
+
+    task->addDependency(dependency, true);
+    ++m_dependencyCounts[it->second];
+}
+
+void TaskGraph::submit(TaskManager* taskManager)
+{
+    BE_PROFILE_FUNCTION();
+    BE_ASSERT(isFinished());
+
+    // Reset everything first, a node may finish before the rest is added
+    for (u32 i = 0; i < m_tasks.size(); ++i) {
+        m_tasks[i]->reset(m_dependencyCounts[i]);
+    }
+    for (const TaskPtr& task : m_tasks) {
+        taskManager->addTask(task);
+    }
+    m_submitted = true;
+}
+
+bool TaskGraph::isFinished() const
+{
+    if (!m_submitted) {
+        return true;
+    }
+    for (const TaskPtr& task : m_tasks) {
+        if (!task->isFinished()) {
+            return false;
+        }
+    }
+    return true;
+}
+}
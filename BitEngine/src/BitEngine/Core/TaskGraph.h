@@ -0,0 +1,40 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "BitEngine/Core/TaskManager.h"
+
+namespace BitEngine {
+
+/**
+ * A set of tasks and the dependencies between them, built once and submitted again every frame.
+ * Each submission resets the dependency counters of every node and adds them all to the task
+ * manager: nodes without dependencies start right away, the others are queued by the worker
+ * that finishes their last dependency. Nothing is rebuilt or allocated between submissions.
+ * Only dependencies added through the graph are waited on again in later submissions.
+ */
+class BE_API TaskGraph {
+public:
+    // Add a node, tasks must not be repeating
+    void add(TaskPtr task);
+
+    // task only runs after dependency finished, both must be nodes of the graph
+    void addDependency(const TaskPtr& task, const TaskPtr& dependency);
+
+    // Start a new run of every node
+    // The previous run must be finished
+    void submit(TaskManager* taskManager);
+
+    // Every node of the last submission finished, true before the first one
+    bool isFinished() const;
+
+    u32 size() const { return static_cast<u32>(m_tasks.size()); }
+
+private:
+    std::vector<TaskPtr> m_tasks;
+    std::vector<u32> m_dependencyCounts; // per node, dependencies inside the graph
+    std::unordered_map<const Task*, u32> m_indices;
+    bool m_submitted = false;
+};
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "BitEngine/Core/Task.h"
+#include "BitEngine/Core/TaskPool.h"
 #include "BitEngine/Core/Messenger.h"
 
 namespace BitEngine {
@@ -13,6 +15,24 @@ struct MsgFrameStart {
 struct MsgFrameEnd {
 };
 
+// What a worker did during a frame
+struct TaskWorkerStats {
+    u32 tasksExecuted = 0;
+    u32 tasksStolen = 0; // taken from another worker deque
+    u32 queueDepth = 0; // tasks left in the worker deque when the frame ended
+    double idleMs = 0; // looking for work or parked
+    double averageLatencyMs = 0; // from being queued to starting to run
+    double maxLatencyMs = 0;
+};
+
+struct TaskFrameStats {
+    u64 frame = 0;
+    double frameMs = 0;
+    u32 mainQueueDepth = 0; // main tasks waiting when the frame ended
+    u32 sharedQueueDepth = 0; // tasks added from other threads waiting when the frame ended
+    std::vector<TaskWorkerStats> workers; // worker 0 is the main thread
+};
+
 class TaskManager {
 public:
     TaskManager() {}
@@ -23,12 +43,33 @@ public:
     virtual void shutdown() = 0;
 
     virtual void addTask(std::shared_ptr<Task> task) = 0;
+
+    // Run f in a pooled LambdaTask, returns the task so it can be waited for or used as a dependency
+    // f signature: void()
+    template <typename Func, typename = typename std::enable_if<!std::is_convertible<Func, TaskPtr>::value>::type>
+    TaskPtr addTask(Func&& f, Task::Affinity affinity = Task::Affinity::BACKGROUND)
+    {
+        TaskPtr task = makeLambdaTask(std::forward<Func>(f), affinity);
+        addTask(task);
+        return task;
+    }
     virtual void scheduleToNextFrame(std::shared_ptr<Task> task) = 0;
 
     virtual void waitTask(std::shared_ptr<Task>& task) = 0;
 
+    // Run one queued task on the calling thread, or yield when there is none.
+    // For threads waiting on work done by other tasks, so they help instead of stalling
+    // the tasks only they can run.
+    virtual void runPendingTask() { std::this_thread::yield(); }
+
     virtual const std::vector<TaskPtr>& getTasks() const = 0;
 
+    // Number of threads running background tasks
+    virtual u32 getWorkerCount() const = 0;
+
+    // Counters of the last finished frame, a frame ends on update()
+    virtual const TaskFrameStats& getFrameStats() const = 0;
+
     virtual void verifyMainThread() const = 0;
 
 private:
@@ -0,0 +1,191 @@
+#include "BitEngine/Core/TaskPool.h"
+
+#include <mutex>
+#include <new>
+
+namespace BitEngine {
+namespace TaskPool {
+
+    namespace {
+        // 128, 256, 512 and 1024 bytes
+        const u32 SIZE_CLASSES = 4;
+        const size_t MIN_BLOCK_SIZE = MAX_BLOCK_SIZE >> (SIZE_CLASSES - 1);
+
+        // Blocks moved at once between a thread cache and the shared pool
+        const u32 BATCH_SIZE = 64;
+
+        // Free blocks are linked through their own memory
+        struct FreeBlock {
+            FreeBlock* next;
+            FreeBlock* nextBatch; // only in the first block of a batch
+            u32 count; // blocks in the batch, only in the first block
+        };
+
+        u32 sizeClass(size_t size)
+        {
+            u32 c = 0;
+            size_t classSize = MIN_BLOCK_SIZE;
+            while (classSize < size) {
+                classSize <<= 1;
+                ++c;
+            }
+            return c;
+        }
+
+        size_t classSize(u32 c)
+        {
+            return MIN_BLOCK_SIZE << c;
+        }
+
+        // Batches of free blocks shared by all threads. Tasks are often created on one
+        // thread and destroyed on another, the blocks flow back through here.
+        class SharedPool {
+        public:
+            ~SharedPool()
+            {
+                for (FreeBlock* batch : m_batches) {
+                    while (batch != nullptr) {
+                        FreeBlock* nextBatch = batch->nextBatch;
+                        while (batch != nullptr) {
+                            FreeBlock* next = batch->next;
+                            ::operator delete(batch);
+                            batch = next;
+                        }
+                        batch = nextBatch;
+                    }
+                }
+            }
+
+            void push(u32 c, FreeBlock* batch)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                batch->nextBatch = m_batches[c];
+                m_batches[c] = batch;
+            }
+
+            FreeBlock* pop(u32 c)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                FreeBlock* batch = m_batches[c];
+                if (batch != nullptr) {
+                    m_batches[c] = batch->nextBatch;
+                }
+                return batch;
+            }
+
+        private:
+            std::mutex m_mutex;
+            FreeBlock* m_batches[SIZE_CLASSES] = {};
+        };
+
+        SharedPool& getSharedPool()
+        {
+            static SharedPool pool;
+            return pool;
+        }
+
+        struct BlockCache {
+            BlockCache();
+            ~BlockCache();
+
+            FreeBlock* blocks[SIZE_CLASSES] = {};
+            u32 counts[SIZE_CLASSES] = {};
+        };
+
+        // Null before the first use and after the thread cache is destroyed, blocks
+        // freed by other thread_local destructors then go back to the system
+        thread_local BlockCache* t_cache = nullptr;
+
+        BlockCache::BlockCache()
+        {
+            getSharedPool(); // created first, so it's destroyed after the main thread cache
+            t_cache = this;
+        }
+
+        BlockCache::~BlockCache()
+        {
+            t_cache = nullptr;
+            for (u32 c = 0; c < SIZE_CLASSES; ++c) {
+                if (blocks[c] != nullptr) {
+                    blocks[c]->count = counts[c];
+                    getSharedPool().push(c, blocks[c]);
+                }
+            }
+        }
+
+        BlockCache* getCache()
+        {
+            thread_local BlockCache cache;
+            return t_cache;
+        }
+    }
+
+    void* allocate(size_t size)
+    {
+        if (size > MAX_BLOCK_SIZE) {
+            return ::operator new(size);
+        }
+
+        const u32 c = sizeClass(size);
+        BlockCache* cache = getCache();
+        if (cache == nullptr) {
+            return ::operator new(classSize(c));
+        }
+
+        if (cache->blocks[c] == nullptr) {
+            FreeBlock* batch = getSharedPool().pop(c);
+            if (batch == nullptr) {
+                return ::operator new(classSize(c));
+            }
+            cache->blocks[c] = batch;
+            cache->counts[c] = batch->count;
+        }
+
+        FreeBlock* block = cache->blocks[c];
+        cache->blocks[c] = block->next;
+        --cache->counts[c];
+        return block;
+    }
+
+    void deallocate(void* ptr, size_t size)
+    {
+        BlockCache* cache = size <= MAX_BLOCK_SIZE ? getCache() : nullptr;
+        if (cache == nullptr) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        const u32 c = sizeClass(size);
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        block->next = cache->blocks[c];
+        cache->blocks[c] = block;
+        ++cache->counts[c];
+
+        // Keep up to two batches, give one to the other threads
+        if (cache->counts[c] >= BATCH_SIZE * 2) {
+            FreeBlock* batch = cache->blocks[c];
+            FreeBlock* last = batch;
+            for (u32 i = 1; i < BATCH_SIZE; ++i) {
+                last = last->next;
+            }
+            cache->blocks[c] = last->next;
+            cache->counts[c] -= BATCH_SIZE;
+            last->next = nullptr;
+            batch->count = BATCH_SIZE;
+            getSharedPool().push(c, batch);
+        }
+    }
+
+    u32 getCachedBlocks()
+    {
+        BlockCache* cache = getCache();
+        u32 count = 0;
+        if (cache != nullptr) {
+            for (const u32 c : cache->counts) {
+                count += c;
+            }
+        }
+        return count;
+    }
+}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "BitEngine/Core/Task.h"
+#include "BitEngine/Core/api.h"
+
+namespace BitEngine {
+
+/**
+ * Memory for short lived tasks.
+ * Blocks are cached per thread by size class (up to MAX_BLOCK_SIZE bytes), so once a thread
+ * created a few tasks, new ones reuse the memory of finished ones instead of calling malloc.
+ * A block may be freed on any thread, it goes to the cache of the thread freeing it, and full
+ * caches hand batches of blocks to a shared pool the other threads refill from.
+ * The memory is kept until exit. Bigger sizes go straight to operator new.
+ */
+namespace TaskPool {
+    constexpr size_t MAX_BLOCK_SIZE = 1024;
+
+    BE_API void* allocate(size_t size);
+    BE_API void deallocate(void* ptr, size_t size);
+
+    // Blocks cached by the calling thread
+    BE_API u32 getCachedBlocks();
+
+    template <typename T>
+    class Allocator {
+    public:
+        typedef T value_type;
+
+        Allocator() = default;
+        template <typename U>
+        Allocator(const Allocator<U>&)
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            static_assert(alignof(T) <= alignof(std::max_align_t), "TaskPool can't align over-aligned types");
+            return static_cast<T*>(TaskPool::allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, size_t n)
+        {
+            TaskPool::deallocate(ptr, n * sizeof(T));
+        }
+
+        template <typename U>
+        bool operator==(const Allocator<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const Allocator<U>&) const { return false; }
+    };
+}
+
+// std::make_shared using the task pool, the object and its reference count share a block
+template <typename T, typename... Args>
+std::shared_ptr<T> makeTask(Args&&... args)
+{
+    return std::allocate_shared<T>(TaskPool::Allocator<T>(), std::forward<Args>(args)...);
+}
+
+/**
+ * Task running a callable, stored inside the task itself.
+ * Created with makeTask, a lambda task is a single pooled block.
+ * f signature: void()
+ */
+template <typename Func>
+class LambdaTask : public Task {
+public:
+    LambdaTask(Func&& f, TaskMode mode, Affinity affinity)
+        : Task(mode, affinity)
+        , m_func(std::move(f))
+    {
+    }
+
+    LambdaTask(const Func& f, TaskMode mode, Affinity affinity)
+        : Task(mode, affinity)
+        , m_func(f)
+    {
+    }
+
+private:
+    void run() override
+    {
+        m_func();
+    }
+
+    Func m_func;
+};
+
+template <typename Func>
+TaskPtr makeLambdaTask(Func&& f, Task::Affinity affinity = Task::Affinity::BACKGROUND, Task::TaskMode mode = Task::TaskMode::NONE)
+{
+    return makeTask<LambdaTask<typename std::decay<Func>::type> >(std::forward<Func>(f), mode, affinity);
+}
+}
@@ -0,0 +1,50 @@
+#include "BitEngine/Core/TaskSequence.h"
+
+namespace BitEngine {
+
+TaskSequence::TaskSequence(TaskManager* taskManager, Task::Priority priority)
+    : m_taskManager(taskManager)
+    , m_priority(priority)
+    , m_state(makeTask<State>())
+{
+}
+
+TaskSequence& TaskSequence::after(TaskPtr task)
+{
+    BE_ASSERT(task != nullptr);
+    m_waitFor.emplace_back(std::move(task));
+    return *this;
+}
+
+void TaskSequence::addStep(TaskPtr step)
+{
+    step->setPriority(m_priority);
+    if (!m_steps.empty()) {
+        step->addDependency(m_steps.back());
+    }
+    for (TaskPtr& task : m_waitFor) {
+        step->addDependency(task);
+    }
+    m_waitFor.clear();
+    m_steps.emplace_back(std::move(step));
+}
+
+TaskPtr TaskSequence::submit()
+{
+    BE_PROFILE_FUNCTION();
+
+    // Waiting at the end, the last step is the one that waits
+    if (!m_waitFor.empty() || m_steps.empty()) {
+        then(Task::Affinity::BACKGROUND, []() {});
+    }
+
+    // Later steps are parked until the step before them finishes
+    for (TaskPtr& step : m_steps) {
+        m_taskManager->addTask(step);
+    }
+
+    TaskPtr last = m_steps.back();
+    m_steps.clear();
+    return last;
+}
+}
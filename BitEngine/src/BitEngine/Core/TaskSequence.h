@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "BitEngine/Core/TaskManager.h"
+#include "BitEngine/Core/TaskPool.h"
+
+namespace BitEngine {
+
+/**
+ * Work done in steps that alternate between threads, written in the order it runs:
+ *
+ *     TaskSequence(taskManager)
+ *         .after(fileTask)
+ *         .then(Task::Affinity::BACKGROUND, [=]() { return decode(); })
+ *         .then(Task::Affinity::MAIN, [=]() { createBuffers(); })
+ *         .then(Task::Affinity::BACKGROUND, [=]() { copyPixels(); })
+ *         .then(Task::Affinity::MAIN, [=]() { upload(); })
+ *         .submit();
+ *
+ * Each step is a task depending on the step before it, all are added by submit(). A step
+ * starts as soon as the previous one and the tasks given to after() finished, on a thread
+ * matching its affinity. Nothing is polled and no task is requeued.
+ * A step returning false stops the sequence, the steps after it do nothing.
+ * State shared between steps must be captured by the step functions, usually in a shared_ptr.
+ * Every step gets the priority of the sequence, streaming loaders use Task::Priority::IDLE.
+ */
+class BE_API TaskSequence {
+public:
+    explicit TaskSequence(TaskManager* taskManager, Task::Priority priority = Task::Priority::NORMAL);
+
+    // The next step also waits for task
+    TaskSequence& after(TaskPtr task);
+
+    // Add a step running f on a thread with the given affinity
+    // f signature: void() or bool(), returning false stops the sequence
+    template <typename Func>
+    TaskSequence& then(Task::Affinity affinity, Func&& f)
+    {
+        std::shared_ptr<State> state = m_state;
+        addStep(makeLambdaTask([state, f = std::forward<Func>(f)]() mutable {
+            if (state->stopped.load(std::memory_order_relaxed)) {
+                return;
+            }
+            if constexpr (std::is_same<decltype(f()), bool>::value) {
+                if (!f()) {
+                    state->stopped.store(true, std::memory_order_relaxed);
+                }
+            }
+            else {
+                f();
+            }
+        },
+            affinity));
+        return *this;
+    }
+
+    // Add every step to the task manager, returns the last one
+    // The sequence can't be changed after this
+    TaskPtr submit();
+
+private:
+    struct State {
+        std::atomic<bool> stopped{ false };
+    };
+
+    void addStep(TaskPtr step);
+
+    TaskManager* m_taskManager;
+    Task::Priority m_priority;
+    std::shared_ptr<State> m_state;
+    std::vector<TaskPtr> m_steps;
+    std::vector<TaskPtr> m_waitFor; // dependencies of the next step
+};
+}
@@ -0,0 +1,346 @@
+#include "BitEngine/Core/TransformKernels.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BE_TRANSFORM_KERNELS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BE_TRANSFORM_KERNELS_SSE2
+#endif
+
+namespace BitEngine {
+namespace TransformKernels {
+
+    // Each Lanes type implements the same set of operations over WIDTH floats (F) or u32 (I),
+    // so every kernel is written once and instantiated for the SIMD width and for the scalar tail.
+    struct ScalarLanes {
+        typedef float F;
+        typedef u32 I;
+        static constexpr u32 WIDTH = 1;
+
+        static F load(const float* p) { return *p; }
+        static void store(float* p, F v) { *p = v; }
+        static F set(float v) { return v; }
+        static F add(F a, F b) { return a + b; }
+        static F sub(F a, F b) { return a - b; }
+        static F mul(F a, F b) { return a * b; }
+
+        static I iset(u32 v) { return v; }
+        static I iand(I a, I b) { return a & b; }
+        static I iandnot(I a, I b) { return ~a & b; }
+        static I ior(I a, I b) { return a | b; }
+        static I ixor(I a, I b) { return a ^ b; }
+        static I iadd(I a, I b) { return a + b; }
+        static I isub(I a, I b) { return a - b; }
+        static I ishl29(I a) { return a << 29; }
+        static I isZero(I a) { return a == 0 ? ~0u : 0u; }
+
+        static I bits(F a)
+        {
+            I r;
+            memcpy(&r, &a, sizeof(r));
+            return r;
+        }
+        static F fromBits(I a)
+        {
+            F r;
+            memcpy(&r, &a, sizeof(r));
+            return r;
+        }
+        static I truncToInt(F a) { return static_cast<u32>(static_cast<s32>(a)); }
+        static F intToFloat(I a) { return static_cast<float>(static_cast<s32>(a)); }
+    };
+
+#if defined(BE_TRANSFORM_KERNELS_AVX2)
+    struct AVX2Lanes {
+        typedef __m256 F;
+        typedef __m256i I;
+        static constexpr u32 WIDTH = 8;
+
+        static F load(const float* p) { return _mm256_loadu_ps(p); }
+        static void store(float* p, F v) { _mm256_storeu_ps(p, v); }
+        static F set(float v) { return _mm256_set1_ps(v); }
+        static F add(F a, F b) { return _mm256_add_ps(a, b); }
+        static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+        static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+
+        static I iset(u32 v) { return _mm256_set1_epi32(static_cast<s32>(v)); }
+        static I iand(I a, I b) { return _mm256_and_si256(a, b); }
+        static I iandnot(I a, I b) { return _mm256_andnot_si256(a, b); }
+        static I ior(I a, I b) { return _mm256_or_si256(a, b); }
+        static I ixor(I a, I b) { return _mm256_xor_si256(a, b); }
+        static I iadd(I a, I b) { return _mm256_add_epi32(a, b); }
+        static I isub(I a, I b) { return _mm256_sub_epi32(a, b); }
+        static I ishl29(I a) { return _mm256_slli_epi32(a, 29); }
+        static I isZero(I a) { return _mm256_cmpeq_epi32(a, _mm256_setzero_si256()); }
+
+        static I bits(F a) { return _mm256_castps_si256(a); }
+        static F fromBits(I a) { return _mm256_castsi256_ps(a); }
+        static I truncToInt(F a) { return _mm256_cvttps_epi32(a); }
+        static F intToFloat(I a) { return _mm256_cvtepi32_ps(a); }
+    };
+    typedef AVX2Lanes Lanes;
+    static const char* INSTRUCTION_SET = "AVX2";
+#elif defined(BE_TRANSFORM_KERNELS_SSE2)
+    struct SSE2Lanes {
+        typedef __m128 F;
+        typedef __m128i I;
+        static constexpr u32 WIDTH = 4;
+
+        static F load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, F v) { _mm_storeu_ps(p, v); }
+        static F set(float v) { return _mm_set1_ps(v); }
+        static F add(F a, F b) { return _mm_add_ps(a, b); }
+        static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+        static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+
+        static I iset(u32 v) { return _mm_set1_epi32(static_cast<s32>(v)); }
+        static I iand(I a, I b) { return _mm_and_si128(a, b); }
+        static I iandnot(I a, I b) { return _mm_andnot_si128(a, b); }
+        static I ior(I a, I b) { return _mm_or_si128(a, b); }
+        static I ixor(I a, I b) { return _mm_xor_si128(a, b); }
+        static I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+        static I isub(I a, I b) { return _mm_sub_epi32(a, b); }
+        static I ishl29(I a) { return _mm_slli_epi32(a, 29); }
+        static I isZero(I a) { return _mm_cmpeq_epi32(a, _mm_setzero_si128()); }
+
+        static I bits(F a) { return _mm_castps_si128(a); }
+        static F fromBits(I a) { return _mm_castsi128_ps(a); }
+        static I truncToInt(F a) { return _mm_cvttps_epi32(a); }
+        static F intToFloat(I a) { return _mm_cvtepi32_ps(a); }
+    };
+    typedef SSE2Lanes Lanes;
+    static const char* INSTRUCTION_SET = "SSE2";
+#else
+    typedef ScalarLanes Lanes;
+    static const char* INSTRUCTION_SET = "Scalar";
+#endif
+
+    static const u32 SIGN_BIT = 0x80000000u;
+
+    template <typename L>
+    inline typename L::F negate(typename L::F a)
+    {
+        return L::fromBits(L::ixor(L::bits(a), L::iset(SIGN_BIT)));
+    }
+
+    // mask lanes are all ones or all zeros
+    template <typename L>
+    inline typename L::F select(typename L::I mask, typename L::F a, typename L::F b)
+    {
+        return L::fromBits(L::ior(L::iand(mask, L::bits(a)), L::iandnot(mask, L::bits(b))));
+    }
+
+    // Cephes sinf/cosf: reduce to [-pi/4, pi/4] and evaluate both polynomials,
+    // the octant picks which one is the sine and the signs.
+    template <typename L>
+    inline void sinCosLanes(typename L::F x, typename L::F& outSin, typename L::F& outCos)
+    {
+        typedef typename L::F F;
+        typedef typename L::I I;
+
+        const I xBits = L::bits(x);
+        I sinSign = L::iand(xBits, L::iset(SIGN_BIT));
+        const F ax = L::fromBits(L::iandnot(L::iset(SIGN_BIT), xBits));
+
+        // Octant, rounded up to even
+        I j = L::truncToInt(L::mul(ax, L::set(1.27323954473516f))); // 4 / pi
+        j = L::iand(L::iadd(j, L::iset(1)), L::iset(~1u));
+        const F y = L::intToFloat(j);
+
+        sinSign = L::ixor(sinSign, L::ishl29(L::iand(j, L::iset(4))));
+        const I cosSign = L::ishl29(L::iandnot(L::isub(j, L::iset(2)), L::iset(4)));
+        const I sinPoly = L::isZero(L::iand(j, L::iset(2)));
+
+        // x - y * pi / 4, with pi / 4 split in three parts for precision
+        F z = L::sub(ax, L::mul(y, L::set(0.78515625f)));
+        z = L::sub(z, L::mul(y, L::set(2.4187564849853515625e-4f)));
+        z = L::sub(z, L::mul(y, L::set(3.77489497744594108e-8f)));
+        const F z2 = L::mul(z, z);
+
+        F c = L::set(2.443315711809948e-5f);
+        c = L::add(L::mul(c, z2), L::set(-1.388731625493765e-3f));
+        c = L::add(L::mul(c, z2), L::set(4.166664568298827e-2f));
+        c = L::mul(L::mul(c, z2), z2);
+        c = L::sub(c, L::mul(z2, L::set(0.5f)));
+        c = L::add(c, L::set(1.0f));
+
+        F s = L::set(-1.9515295891e-4f);
+        s = L::add(L::mul(s, z2), L::set(8.3321608736e-3f));
+        s = L::add(L::mul(s, z2), L::set(-1.6666654611e-1f));
+        s = L::mul(L::mul(s, z2), z);
+        s = L::add(s, z);
+
+        outSin = L::fromBits(L::ixor(L::bits(select<L>(sinPoly, s, c)), sinSign));
+        outCos = L::fromBits(L::ixor(L::bits(select<L>(sinPoly, c, s)), cosSign));
+    }
+
+    template <typename L>
+    inline void sinCosBlock(const float* angles, float* outSin, float* outCos, u32 i)
+    {
+        typename L::F s, c;
+        sinCosLanes<L>(L::load(angles + i), s, c);
+        L::store(outSin + i, s);
+        L::store(outCos + i, c);
+    }
+
+    template <typename L>
+    inline void composeLocal2DBlock(const Transform2DBatch& in, u32 i, float* const* out)
+    {
+        typename L::F s, c;
+        sinCosLanes<L>(L::load(in.rotation + i), s, c);
+        const typename L::F sx = L::load(in.scaleX + i);
+        const typename L::F sy = L::load(in.scaleY + i);
+
+        alignas(32) float m[4][L::WIDTH];
+        L::store(m[0], L::mul(sx, c));
+        L::store(m[1], L::mul(negate<L>(sx), s));
+        L::store(m[2], L::mul(sy, s));
+        L::store(m[3], L::mul(sy, c));
+
+        for (u32 l = 0; l < L::WIDTH; ++l) {
+            float* o = out[i + l];
+            o[0] = m[0][l];
+            o[1] = m[1][l];
+            o[2] = 0.0f;
+            o[3] = m[2][l];
+            o[4] = m[3][l];
+            o[5] = 0.0f;
+            o[6] = in.positionX[i + l];
+            o[7] = in.positionY[i + l];
+            o[8] = 1.0f;
+        }
+    }
+
+    template <typename L>
+    inline void composeLocal3DBlock(const Transform3DBatch& in, u32 i, float* const* out)
+    {
+        typedef typename L::F F;
+        const F qx = L::load(in.rotationX + i);
+        const F qy = L::load(in.rotationY + i);
+        const F qz = L::load(in.rotationZ + i);
+        const F qw = L::load(in.rotationW + i);
+        const F one = L::set(1.0f);
+        const F two = L::set(2.0f);
+
+        const F xx = L::mul(qx, qx);
+        const F yy = L::mul(qy, qy);
+        const F zz = L::mul(qz, qz);
+        const F xy = L::mul(qx, qy);
+        const F xz = L::mul(qx, qz);
+        const F yz = L::mul(qy, qz);
+        const F wx = L::mul(qw, qx);
+        const F wy = L::mul(qw, qy);
+        const F wz = L::mul(qw, qz);
+
+        // Rotation columns scaled, as mat4_cast(q) * scale(s)
+        const F sx = L::load(in.scaleX + i);
+        const F sy = L::load(in.scaleY + i);
+        const F sz = L::load(in.scaleZ + i);
+        const F c00 = L::mul(L::sub(one, L::mul(two, L::add(yy, zz))), sx);
+        const F c01 = L::mul(L::mul(two, L::add(xy, wz)), sx);
+        const F c02 = L::mul(L::mul(two, L::sub(xz, wy)), sx);
+        const F c10 = L::mul(L::mul(two, L::sub(xy, wz)), sy);
+        const F c11 = L::mul(L::sub(one, L::mul(two, L::add(xx, zz))), sy);
+        const F c12 = L::mul(L::mul(two, L::add(yz, wx)), sy);
+        const F c20 = L::mul(L::mul(two, L::add(xz, wy)), sz);
+        const F c21 = L::mul(L::mul(two, L::sub(yz, wx)), sz);
+        const F c22 = L::mul(L::sub(one, L::mul(two, L::add(xx, yy))), sz);
+
+        // Translation is applied first: last column is (R * S) * p
+        const F px = L::load(in.positionX + i);
+        const F py = L::load(in.positionY + i);
+        const F pz = L::load(in.positionZ + i);
+
+        alignas(32) float m[12][L::WIDTH];
+        L::store(m[0], c00);
+        L::store(m[1], c01);
+        L::store(m[2], c02);
+        L::store(m[3], c10);
+        L::store(m[4], c11);
+        L::store(m[5], c12);
+        L::store(m[6], c20);
+        L::store(m[7], c21);
+        L::store(m[8], c22);
+        L::store(m[9], L::add(L::add(L::mul(c00, px), L::mul(c10, py)), L::mul(c20, pz)));
+        L::store(m[10], L::add(L::add(L::mul(c01, px), L::mul(c11, py)), L::mul(c21, pz)));
+        L::store(m[11], L::add(L::add(L::mul(c02, px), L::mul(c12, py)), L::mul(c22, pz)));
+
+        for (u32 l = 0; l < L::WIDTH; ++l) {
+            float* o = out[i + l];
+            for (u32 col = 0; col < 4; ++col) {
+                o[col * 4 + 0] = m[col * 3 + 0][l];
+                o[col * 4 + 1] = m[col * 3 + 1][l];
+                o[col * 4 + 2] = m[col * 3 + 2][l];
+                o[col * 4 + 3] = 0.0f;
+            }
+            o[15] = 1.0f;
+        }
+    }
+
+    const char* getInstructionSet()
+    {
+        return INSTRUCTION_SET;
+    }
+
+    void sinCos(const float* angles, float* outSin, float* outCos, u32 count)
+    {
+        u32 i = 0;
+        for (; i + Lanes::WIDTH <= count; i += Lanes::WIDTH) {
+            sinCosBlock<Lanes>(angles, outSin, outCos, i);
+        }
+        for (; i < count; ++i) {
+            sinCosBlock<ScalarLanes>(angles, outSin, outCos, i);
+        }
+    }
+
+    void composeLocal2D(const Transform2DBatch& in, u32 count, float* const* out)
+    {
+        u32 i = 0;
+        for (; i + Lanes::WIDTH <= count; i += Lanes::WIDTH) {
+            composeLocal2DBlock<Lanes>(in, i, out);
+        }
+        for (; i < count; ++i) {
+            composeLocal2DBlock<ScalarLanes>(in, i, out);
+        }
+    }
+
+    void composeLocal3D(const Transform3DBatch& in, u32 count, float* const* out)
+    {
+        u32 i = 0;
+        for (; i + Lanes::WIDTH <= count; i += Lanes::WIDTH) {
+            composeLocal3DBlock<Lanes>(in, i, out);
+        }
+        for (; i < count; ++i) {
+            composeLocal3DBlock<ScalarLanes>(in, i, out);
+        }
+    }
+
+    void multiply4x4(const float* a, const float* b, float* out)
+    {
+#if defined(BE_TRANSFORM_KERNELS_AVX2) || defined(BE_TRANSFORM_KERNELS_SSE2)
+        // Column j of out is a * column j of b, one column of a per register
+        const __m128 a0 = _mm_loadu_ps(a);
+        const __m128 a1 = _mm_loadu_ps(a + 4);
+        const __m128 a2 = _mm_loadu_ps(a + 8);
+        const __m128 a3 = _mm_loadu_ps(a + 12);
+        for (u32 j = 0; j < 4; ++j) {
+            const float* bj = b + j * 4;
+            __m128 col = _mm_mul_ps(a0, _mm_set1_ps(bj[0]));
+            col = _mm_add_ps(col, _mm_mul_ps(a1, _mm_set1_ps(bj[1])));
+            col = _mm_add_ps(col, _mm_mul_ps(a2, _mm_set1_ps(bj[2])));
+            col = _mm_add_ps(col, _mm_mul_ps(a3, _mm_set1_ps(bj[3])));
+            _mm_storeu_ps(out + j * 4, col);
+        }
+#else
+        for (u32 j = 0; j < 4; ++j) {
+            for (u32 r = 0; r < 4; ++r) {
+                out[j * 4 + r] = a[r] * b[j * 4] + a[4 + r] * b[j * 4 + 1] + a[8 + r] * b[j * 4 + 2] + a[12 + r] * b[j * 4 + 3];
+            }
+        }
+#endif
+    }
+}
+}
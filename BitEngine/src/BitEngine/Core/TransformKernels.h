@@ -0,0 +1,55 @@
+#pragma once
+
+#include "BitEngine/Common/TypeDefinition.h"
+#include "BitEngine/Core/api.h"
+
+namespace BitEngine {
+
+/**
+ * Batch kernels to build transform matrices for many transforms at once.
+ * Inputs are structure of arrays, so each instruction works on several transforms:
+ * 8 with AVX2 (when built with AVX2 enabled), 4 with SSE2, 1 on other targets.
+ * Matrices are column major, with the same layout as glm::mat3/glm::mat4.
+ */
+namespace TransformKernels {
+
+    // Name of the instruction set used by the kernels
+    BE_API const char* getInstructionSet();
+
+    // outSin[i] = sin(angles[i]), outCos[i] = cos(angles[i])
+    // Max error is around 1 ulp for angles in [-8192, 8192], precision degrades after that.
+    BE_API void sinCos(const float* angles, float* outSin, float* outCos, u32 count);
+
+    struct Transform2DBatch {
+        const float* positionX;
+        const float* positionY;
+        const float* rotation; // radians
+        const float* scaleX;
+        const float* scaleY;
+    };
+
+    // Local 3x3 matrix of each transform, same result as Transform2DProcessor::CalculateLocalModelMatrix
+    // out[i] points to the 9 floats of the i-th matrix
+    BE_API void composeLocal2D(const Transform2DBatch& in, u32 count, float* const* out);
+
+    struct Transform3DBatch {
+        const float* positionX;
+        const float* positionY;
+        const float* positionZ;
+        const float* scaleX;
+        const float* scaleY;
+        const float* scaleZ;
+        const float* rotationX; // unit quaternion
+        const float* rotationY;
+        const float* rotationZ;
+        const float* rotationW;
+    };
+
+    // Local 4x4 matrix of each transform: rotation * scale * translation, as Transform3DProcessor
+    // out[i] points to the 16 floats of the i-th matrix
+    BE_API void composeLocal3D(const Transform3DBatch& in, u32 count, float* const* out);
+
+    // out = a * b for 4x4 matrices, out may not alias a or b
+    BE_API void multiply4x4(const float* a, const float* b, float* out);
+}
+}
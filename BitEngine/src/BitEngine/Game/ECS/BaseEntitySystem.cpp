@@ -1,16 +1,36 @@
 #include "BitEngine/Game/ECS/BaseEntitySystem.h"
 
+#include <algorithm>
+#include <atomic>
+
 #include "BitEngine/Game/ECS/ComponentProcessor.h"
+#include "BitEngine/Game/ECS/EntityCommandBuffer.h"
 #include "BitEngine/Core/Assert.h"
 
 namespace BitEngine {
 ComponentType BaseComponent::componentTypeCounter(0);
 
+static std::atomic<u64> entitySystemInstances(0);
+
+BaseEntitySystem::BaseEntitySystem()
+    : m_groupOfType(BE_MAX_COMPONENT_TYPES, NO_GROUP)
+    , m_instanceID(++entitySystemInstances)
+{
+    m_initialized = false;
+    m_entities.emplace_back(0); // First entity is invalid.
+    m_componentMasks.emplace_back();
+}
+
+BaseEntitySystem::~BaseEntitySystem()
+{
+    for (ThreadCommandBuffer& t : m_commandBuffers) {
+        delete t.buffer;
+    }
+}
+
 bool BaseEntitySystem::Init()
 {
     bool initOk = true;
-    m_objBitField = new ObjBitField(static_cast<u16>(m_holders.size()));
-    m_objBitField->push();
 
     for (auto& h : m_holders) {
         initOk &= h.second->init();
@@ -21,24 +41,51 @@ bool BaseEntitySystem::Init()
 }
 
 EntityHandle BaseEntitySystem::createEntity()
+{
+    EntityHandle newHandle = allocateEntity();
+
+    Messenger<MsgEntityCreated>::emit({ newHandle });
+
+    return newHandle;
+}
+
+void BaseEntitySystem::createEntities(u32 count, EntityHandle* out)
+{
+    BE_PROFILE_FUNCTION();
+    reserveEntities(count);
+    for (u32 i = 0; i < count; ++i) {
+        out[i] = allocateEntity();
+    }
+
+    Messenger<MsgEntitiesCreated>::emit({ out, count });
+}
+
+EntityHandle BaseEntitySystem::allocateEntity()
 {
     EntityHandle newHandle;
     if (m_freeEntities.empty()) {
-        newHandle = m_entities.size();
+        BE_ASSERT(m_entities.size() <= BE_ENTITY_INDEX_MASK);
+        newHandle = makeEntityHandle(m_entities.size(), 0);
         m_entities.emplace_back(newHandle);
-        m_objBitField->push();
+        m_componentMasks.emplace_back();
     }
     else {
         newHandle = m_freeEntities.back();
-        m_entities[newHandle] = newHandle;
-        m_objBitField->unsetAll(newHandle);
+        m_freeEntities.pop_back();
+        m_entities[getEntityIndex(newHandle)] = newHandle;
+        m_componentMasks[getEntityIndex(newHandle)].clear();
     }
 
-    Messenger<MsgEntityCreated>::emit({ newHandle });
-
     return newHandle;
 }
 
+void BaseEntitySystem::reserveEntities(u32 count)
+{
+    const u32 needed = count > m_freeEntities.size() ? count - m_freeEntities.size() : 0;
+    m_entities.reserve(m_entities.size() + needed);
+    m_componentMasks.reserve(m_componentMasks.size() + needed);
+}
+
 void BaseEntitySystem::destroyEntity(EntityHandle entity)
 {
     BE_ASSERT(hasEntity(entity));
@@ -49,34 +96,172 @@ void BaseEntitySystem::destroyEntity(EntityHandle entity)
 bool BaseEntitySystem::addComponent(EntityHandle entity, ComponentType type)
 {
     BE_ASSERT(hasEntity(entity));
-    m_objBitField->set(entity, type);
+    m_componentMasks[getEntityIndex(entity)].set(type);
     return true;
 }
 
 bool BaseEntitySystem::removeComponent(EntityHandle entity, ComponentType type, ComponentHandle handle)
 {
     BE_ASSERT(hasEntity(entity));
+    const u32 group = m_groupOfType[type];
+    if (group != NO_GROUP) {
+        leaveGroup(*m_groups[group], entity);
+    }
+
     auto holder = m_holders[type];
     holder->sendDestroyMessage(entity, handle);
     holder->releaseComponentID(handle);
+    m_componentMasks[getEntityIndex(entity)].unset(type);
     return true;
 }
 
+bool BaseEntitySystem::createGroup(const ComponentType* types, u32 count)
+{
+    std::unique_ptr<ComponentGroup> group(new ComponentGroup());
+    group->size = 0;
+    for (u32 i = 0; i < count; ++i) {
+        const ComponentType type = types[i];
+        auto it = m_holders.find(type);
+        if (it == m_holders.end()) {
+            LOG(EngineLog, BE_LOG_ERROR) << "Can't group component type " << type << ", it isn't registered";
+            return false;
+        }
+        if (it->second->getStorageMode() != BaseComponentHolder::StorageMode::PACKED) {
+            LOG(EngineLog, BE_LOG_ERROR) << "Can't group component type " << type << ", its holder doesn't use PACKED storage";
+            return false;
+        }
+        if (m_groupOfType[type] != NO_GROUP || group->mask.test(type)) {
+            LOG(EngineLog, BE_LOG_ERROR) << "Component type " << type << " already belongs to a group";
+            return false;
+        }
+        if (!group->holders.empty() && it->second->getComponentsPerPool() != group->holders[0]->getComponentsPerPool()) {
+            LOG(EngineLog, BE_LOG_ERROR) << "Can't group component type " << type << ", holders of a group must use the same pool size";
+            return false;
+        }
+        group->mask.set(type);
+        group->holders.emplace_back(it->second);
+    }
+    if (group->holders.empty()) {
+        return false;
+    }
+
+    // Entities that already have every type. An entity joining the group swaps with the first
+    // slot after the group, that slot was already visited.
+    BaseComponentHolder* first = group->holders[0];
+    for (u32 slot = 0; slot < first->getNumValidComponents(); ++slot) {
+        const EntityHandle entity = first->getEntityForComponent(first->getPackedHandles()[slot]);
+        joinGroup(*group, entity);
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        m_groupOfType[types[i]] = static_cast<u32>(m_groups.size());
+    }
+    m_groups.emplace_back(std::move(group));
+    return true;
+}
+
+const ComponentGroup* BaseEntitySystem::getGroup(const ComponentTypeMask& mask) const
+{
+    for (const std::unique_ptr<ComponentGroup>& group : m_groups) {
+        if (group->mask == mask) {
+            return group.get();
+        }
+    }
+    return nullptr;
+}
+
+void BaseEntitySystem::joinGroup(ComponentGroup& group, EntityHandle entity)
+{
+    if (!m_componentMasks[getEntityIndex(entity)].containsAll(group.mask) || isInGroup(group, entity)) {
+        return;
+    }
+
+    for (BaseComponentHolder* holder : group.holders) {
+        holder->swapPackedSlots(holder->getPackedSlot(holder->getComponentForAliveEntity(entity)), group.size);
+    }
+    ++group.size;
+}
+
+void BaseEntitySystem::leaveGroup(ComponentGroup& group, EntityHandle entity)
+{
+    if (!m_componentMasks[getEntityIndex(entity)].containsAll(group.mask) || !isInGroup(group, entity)) {
+        return;
+    }
+
+    // The last entity of the group takes its place
+    --group.size;
+    for (BaseComponentHolder* holder : group.holders) {
+        holder->swapPackedSlots(holder->getPackedSlot(holder->getComponentForAliveEntity(entity)), group.size);
+    }
+}
+
+EntityCommandBuffer& BaseEntitySystem::getCommandBuffer()
+{
+    // Most calls come from the same thread for the same entity system, avoid the lock for those
+    struct Cache {
+        u64 instance;
+        EntityCommandBuffer* buffer;
+    };
+    static thread_local Cache cache = { 0, nullptr };
+    if (cache.instance == m_instanceID) {
+        return *cache.buffer;
+    }
+
+    std::lock_guard<std::mutex> lock(m_commandBuffersMutex);
+    const std::thread::id thread = std::this_thread::get_id();
+    EntityCommandBuffer* buffer = nullptr;
+    for (ThreadCommandBuffer& t : m_commandBuffers) {
+        if (t.thread == thread) {
+            buffer = t.buffer;
+            break;
+        }
+    }
+
+    if (buffer == nullptr) {
+        buffer = new EntityCommandBuffer();
+        m_commandBuffers.emplace_back(ThreadCommandBuffer{ thread, buffer });
+    }
+
+    cache = Cache{ m_instanceID, buffer };
+    return *buffer;
+}
+
 void BaseEntitySystem::destroyPending()
 {
     BE_PROFILE_FUNCTION();
+    // Buffers are played back in the order threads first used them.
+    // Not locked while playing back, listeners may need their own buffer.
+    std::vector<ThreadCommandBuffer> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_commandBuffersMutex);
+        buffers = m_commandBuffers;
+    }
+    for (ThreadCommandBuffer& t : buffers) {
+        t.buffer->playback(*this);
+    }
+
     for (EntityHandle entity : m_toBeDestroyed) {
+        if (!hasEntity(entity)) {
+            continue; // destroyed more than once
+        }
+
+        for (std::unique_ptr<ComponentGroup>& group : m_groups) {
+            leaveGroup(*group, entity);
+        }
+
+        const u32 index = getEntityIndex(entity);
         for (auto& h : m_holders) {
-            if (m_objBitField->test(entity, h.first)) {
+            if (m_componentMasks[index].test(h.first)) {
                 h.second->releaseComponentForEntity(entity);
             }
         }
-        m_objBitField->unsetAll(entity);
+        m_componentMasks[index].clear();
 
-        m_entities[entity] = 0;
-        m_freeEntities.emplace_back(entity);
+        // The next entity using this index gets a new generation
+        m_entities[index] = 0;
+        m_freeEntities.emplace_back(makeEntityHandle(index, getEntityGeneration(entity) + 1));
     }
 
-    m_freeEntities.clear();
+    m_toBeDestroyed.clear();
 }
 }
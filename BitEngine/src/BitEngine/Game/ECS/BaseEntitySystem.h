@@ -1,22 +1,29 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
-#include "BitEngine/Common/BitFieldVector.h"
 #include "BitEngine/Game/ECS/Component.h"
 #include "BitEngine/Game/ECS/ComponentProcessor.h"
 #include "BitEngine/Core/Logger.h"
 
 namespace BitEngine {
 
-class BE_API BaseEntitySystem : public Messenger<MsgEntityCreated>, public Messenger<MsgEntityDestroyed> {
+class EntityCommandBuffer;
+
+// Components of the entities having every type of the group are kept in the first size
+// slots of each PACKED holder, slot i of every holder belonging to the same entity
+struct ComponentGroup {
+    ComponentTypeMask mask;
+    std::vector<BaseComponentHolder*> holders;
+    u32 size;
+};
+
+class BE_API BaseEntitySystem : public Messenger<MsgEntityCreated>, public Messenger<MsgEntitiesCreated>, public Messenger<MsgEntityDestroyed> {
 public:
-    BaseEntitySystem()
-    {
-        m_initialized = false;
-        m_objBitField = nullptr;
-        m_entities.emplace_back(0); // First entity is invalid.
-    }
+    BaseEntitySystem();
+    ~BaseEntitySystem();
 
     // After this call, no more component types are allowed to be registered
     // return true if initialized correctly.
@@ -26,6 +33,14 @@ public:
     // @return The entity handle
     EntityHandle createEntity();
 
+    // Creates count entities at once
+    // Sends a single MsgEntitiesCreated instead of one MsgEntityCreated per entity
+    // @param out Receives the count entity handles
+    void createEntities(u32 count, EntityHandle* out);
+
+    // Make room for count more entities
+    void reserveEntities(u32 count);
+
     // Destroy the entity
     // All components inside this entity will be destroyed too
     // @param entity Entity to be destroyed
@@ -43,6 +58,14 @@ public:
     // @return true if component was found and removed
     bool removeComponent(EntityHandle entity, ComponentType type, ComponentHandle handle);
 
+    // Check if the entity is alive, O(1).
+    // Handles of destroyed entities are never alive again, even after their index is reused.
+    inline bool hasEntity(EntityHandle entity) const
+    {
+        const u32 index = getEntityIndex(entity);
+        return entity != 0 && index < m_entities.size() && m_entities[index] == entity;
+    }
+
     // Check if given component type is valid inside this BaseEntitySystem
     // @param type The type to check
     // @return true if it is valid
@@ -71,16 +94,38 @@ public:
         return nullptr;
     }
 
+    // Group the given component types, see EntitySystem::createGroup
+    // @return false when a type isn't registered, its holder isn't PACKED or it's already grouped
+    bool createGroup(const ComponentType* types, u32 count);
+
+    // @return The group with exactly the types in mask, nullptr if there is none
+    const ComponentGroup* getGroup(const ComponentTypeMask& mask) const;
+
+    // Must be called once the component of given type was created for the entity,
+    // moves the entity into the group of that type when it has all the group types.
+    void onComponentAdded(EntityHandle entity, ComponentType type)
+    {
+        const u32 group = m_groupOfType[type];
+        if (group != NO_GROUP) {
+            joinGroup(*m_groups[group], entity);
+        }
+    }
+
     // Should be called once the Update() is finished, after all Processors have
     // finished execution for this frame.
-    // Releases all memory used by destroyed components/entities
+    // Plays back all command buffers, then releases all memory used by destroyed components/entities
     void destroyPending();
 
+    // Get the command buffer of the calling thread.
+    // Structural changes recorded there are applied by the next destroyPending().
+    // Safe to call from any thread, and while iterating components.
+    EntityCommandBuffer& getCommandBuffer();
+
 protected:
     // Verify if entity has the component type
     bool hasComponent(EntityHandle entity, ComponentType type)
     {
-        return m_objBitField->test(entity, type);
+        return m_componentMasks[getEntityIndex(entity)].test(type);
     }
 
     // Shut down entity system
@@ -89,8 +134,6 @@ protected:
         for (auto& h : m_holders) {
             delete h.second;
         }
-
-        delete m_objBitField;
     }
 
     // Register a component holder for given component type
@@ -100,6 +143,11 @@ protected:
             return false;
         }
 
+        if (type >= BE_MAX_COMPONENT_TYPES) {
+            LOG(EngineLog, BE_LOG_ERROR) << "Component type " << type << " is over the limit of " << BE_MAX_COMPONENT_TYPES << " types, define BE_MAX_COMPONENT_TYPES with a bigger value";
+            return false;
+        }
+
         auto it = m_holders.find(type);
         if (it != m_holders.end()) {
             LOG(EngineLog, BE_LOG_ERROR) << "There is another component holder already registered for the type " << type;
@@ -110,20 +158,41 @@ protected:
         return true;
     }
 
-    // TODO: Make this a DebugAssert?
-    inline bool hasEntity(EntityHandle entity) const
+    // Creates a new entity without sending messages
+    EntityHandle allocateEntity();
+
+    static constexpr u32 NO_GROUP = ~0u;
+
+    bool isInGroup(const ComponentGroup& group, EntityHandle entity) const
     {
-        return m_entities.size() > entity && m_entities[entity] == entity;
+        const BaseComponentHolder* first = group.holders[0];
+        return first->getPackedSlot(first->getComponentForAliveEntity(entity)) < group.size;
     }
 
+    // Both expect every component of the entity to exist, with its type set in the entity mask
+    void joinGroup(ComponentGroup& group, EntityHandle entity);
+    void leaveGroup(ComponentGroup& group, EntityHandle entity);
+
     // Member variables
-    std::vector<EntityHandle> m_entities;
-    std::vector<EntityHandle> m_freeEntities;
+    std::vector<EntityHandle> m_entities; // given entity index get the handle of the alive entity, 0 if there is none
+    std::vector<EntityHandle> m_freeEntities; // handles to be given to new entities, with their next generation
     std::vector<EntityHandle> m_toBeDestroyed;
-    ObjBitField* m_objBitField;
+    std::vector<ComponentTypeMask> m_componentMasks; // given entity index get the types of the components it has
 
 private:
+    struct ThreadCommandBuffer {
+        std::thread::id thread;
+        EntityCommandBuffer* buffer;
+    };
+
     std::unordered_map<ComponentType, BaseComponentHolder*> m_holders;
+    std::vector<std::unique_ptr<ComponentGroup> > m_groups;
+    std::vector<u32> m_groupOfType; // given component type get its group, NO_GROUP if there is none
+
+    // Identifies this instance in the thread local command buffer cache
+    const u64 m_instanceID;
+    std::mutex m_commandBuffersMutex;
+    std::vector<ThreadCommandBuffer> m_commandBuffers;
 
     bool m_initialized;
 };
@@ -4,7 +4,6 @@ namespace BitEngine {
 
 Camera2DComponent::Camera2DComponent()
     : m_zoom(1.0f)
-    , changed(true)
 {
 }
 
@@ -12,7 +11,7 @@ void Camera2DComponent::setLookAt(const glm::vec3& pos)
 {
     m_lookAt = pos;
 
-    changed = true;
+    markChanged();
 }
 
 glm::vec3 Camera2DComponent::getLookAt() const
@@ -27,14 +26,14 @@ void Camera2DComponent::setView(int width, int height)
 
     m_orthoMatrix = glm::ortho(0.0f, (float)width, 0.0f, (float)height);
 
-    changed = true;
+    markChanged();
 }
 
 void Camera2DComponent::setZoom(float z)
 {
     m_zoom = z;
 
-    changed = true;
+    markChanged();
 }
 
 float Camera2DComponent::getZoom() const
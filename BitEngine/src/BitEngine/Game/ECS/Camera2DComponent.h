@@ -6,7 +6,8 @@
 namespace BitEngine {
 
 class BE_API Camera2DComponent
-    : public Component<Camera2DComponent> {
+    : public Component<Camera2DComponent>,
+      public ChangeTrackedComponent {
 public:
     Camera2DComponent();
 
@@ -43,7 +44,5 @@ public:
 
     glm::mat4 m_cameraMatrix;
     glm::mat4 m_orthoMatrix;
-
-    bool changed;
 };
 }
@@ -4,6 +4,7 @@ namespace BitEngine {
 
 Camera2DProcessor::Camera2DProcessor(EntitySystem* es)
     : ComponentProcessor(es)
+    , m_lastChangeVersion(0)
 {
 }
 
@@ -22,14 +23,12 @@ void Camera2DProcessor::recalculateMatrix(Camera2DComponent& c)
 void Camera2DProcessor::Process()
 {
     BE_PROFILE_FUNCTION();
-    //ComponentHandle handle, GameLogicComponent& l
-    // ComponentRef<Camera2DComponent>& camera
-    getES()->forAll<Camera2DComponent>(
-        [](ComponentHandle handle, Camera2DComponent& camera) {
-            if (camera.changed) {
-                recalculateMatrix(camera);
-                camera.changed = false;
-            }
-        });
+    ComponentHolder<Camera2DComponent>* holder = getES()->getHolder<Camera2DComponent>();
+    const u32 since = m_lastChangeVersion;
+    m_lastChangeVersion = holder->advanceChangeVersion();
+
+    holder->forEachChangedComponent(since, [](ComponentHandle handle, Camera2DComponent* camera) {
+        recalculateMatrix(*camera);
+    });
 }
 }
@@ -22,5 +22,6 @@ private: // Methods
     static void recalculateMatrix(Camera2DComponent& c);
 
 private:
+    u32 m_lastChangeVersion; // cameras changed after this version are recalculated next
 };
 }
\ No newline at end of file
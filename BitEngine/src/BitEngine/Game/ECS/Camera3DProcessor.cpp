@@ -18,7 +18,7 @@ void Camera3DProcessor::recalculateViewMatrix(Camera3DComponent& c, const glm::m
 void Camera3DProcessor::Process()
 {
     BE_PROFILE_FUNCTION();
-    getES()->forEach<Camera3DComponent, Transform3DComponent>(
+    getES()->view<Camera3DComponent, Transform3DComponent>().each(
         [this](ComponentRef<Camera3DComponent>&& camera, ComponentRef<Transform3DComponent>&& transform) {
             recalculateViewMatrix(*camera, transform3DProcessor->getGlobalTransformFor(getComponentHandle(transform)));
         });
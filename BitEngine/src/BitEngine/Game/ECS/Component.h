@@ -1,8 +1,15 @@
 #pragma once
 
 #include "BitEngine/Core/api.h"
+#include "BitEngine/Common/ComponentMask.h"
 #include "BitEngine/Common/TypeDefinition.h"
 
+// Max number of component types, a multiple of 64.
+// Every entity keeps a mask of this many bits.
+#ifndef BE_MAX_COMPONENT_TYPES
+#define BE_MAX_COMPONENT_TYPES 128
+#endif
+
 namespace BitEngine {
 
 class BaseComponentHolder;
@@ -15,6 +22,28 @@ typedef u16* GlobalComponentID;
 const u32 BE_NO_COMPONENT_HANDLE = 0;
 const u32 BE_NO_COMPONENT_TYPE = ~0;
 
+// Entity handles keep the entity index in the low bits and a generation in the high bits.
+// The generation changes every time an index is reused, so handles of destroyed entities
+// don't become valid again when their index is given to a new entity.
+const u32 BE_ENTITY_INDEX_BITS = 22;
+const u32 BE_ENTITY_INDEX_MASK = (1u << BE_ENTITY_INDEX_BITS) - 1;
+const u32 BE_ENTITY_GENERATION_MASK = ~0u >> BE_ENTITY_INDEX_BITS;
+
+inline u32 getEntityIndex(EntityHandle entity)
+{
+    return entity & BE_ENTITY_INDEX_MASK;
+}
+
+inline u32 getEntityGeneration(EntityHandle entity)
+{
+    return entity >> BE_ENTITY_INDEX_BITS;
+}
+
+inline EntityHandle makeEntityHandle(u32 index, u32 generation)
+{
+    return ((generation & BE_ENTITY_GENERATION_MASK) << BE_ENTITY_INDEX_BITS) | index;
+}
+
 class BE_API BaseComponent {
     friend class BaseComponentHolder;
 
@@ -25,6 +54,42 @@ protected:
     static ComponentType componentTypeCounter;
 };
 
+/**
+ * Base for components that flag their own changes on their holder, see BaseComponentHolder::markChanged.
+ * The holder binds the component once it is constructed in its slot. Copies are not bound.
+ */
+class BE_API ChangeTrackedComponent {
+    friend class BaseComponentHolder;
+
+public:
+    ChangeTrackedComponent()
+        : m_changeHolder(nullptr)
+        , m_changeHandle(BE_NO_COMPONENT_HANDLE)
+    {
+    }
+
+    ChangeTrackedComponent(const ChangeTrackedComponent&)
+        : m_changeHolder(nullptr)
+        , m_changeHandle(BE_NO_COMPONENT_HANDLE)
+    {
+    }
+
+    // Keeps the binding, the component was changed
+    ChangeTrackedComponent& operator=(const ChangeTrackedComponent&)
+    {
+        markChanged();
+        return *this;
+    }
+
+protected:
+    // Flag this component as changed, does nothing while not bound to a holder
+    void markChanged();
+
+private:
+    BaseComponentHolder* m_changeHolder;
+    ComponentHandle m_changeHandle;
+};
+
 template <typename T>
 class BE_API Component : public BaseComponent {
 public:
@@ -39,4 +104,15 @@ public:
         return *getGlobalComponentID();
     }
 };
+
+typedef ComponentMask<BE_MAX_COMPONENT_TYPES> ComponentTypeMask;
+
+// Mask with the bits of all given component types
+template <typename... CompClass>
+ComponentTypeMask getComponentMask()
+{
+    ComponentTypeMask mask;
+    (mask.set(CompClass::getComponentType()), ...);
+    return mask;
+}
 }
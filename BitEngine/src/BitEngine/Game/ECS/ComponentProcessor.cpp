@@ -3,18 +3,34 @@
 
 namespace BitEngine {
 
-BaseComponentHolder::BaseComponentHolder(u32 componentSize, u32 nCompPerPool /*= 100*/)
+void ChangeTrackedComponent::markChanged()
+{
+    if (m_changeHolder != nullptr) {
+        m_changeHolder->markChanged(m_changeHandle);
+    }
+}
+
+BaseComponentHolder::BaseComponentHolder(u32 componentSize, u32 nCompPerPool /*= 100*/, StorageMode mode /*= StorageMode::STABLE*/)
     : m_componentSize(componentSize)
     , m_nComponentsPerPool(nCompPerPool)
+    , m_storageMode(mode)
     , m_IDcapacity(nCompPerPool)
     , m_byComponent(nCompPerPool)
     , m_IDcurrent(1)
     , m_workingComponents(0)
     , m_pools()
     , m_byEntity(128, 0)
+    , m_changeVersion(1)
+    , m_changedAt(nCompPerPool, 0)
 {
     m_pools.emplace_back(new char[m_componentSize * m_nComponentsPerPool]); // init first pool
+    m_blockChangedAt.emplace_back(0);
     m_freeSorted = true;
+
+    if (m_storageMode == StorageMode::PACKED) {
+        m_denseByHandle.resize(nCompPerPool, 0);
+        m_handleByDense.resize(nCompPerPool, 0);
+    }
 }
 
 BaseComponentHolder::~BaseComponentHolder()
@@ -28,26 +44,76 @@ BaseComponentHolder::~BaseComponentHolder()
 // Returns the released component
 void BaseComponentHolder::releaseComponentForEntity(EntityHandle entity)
 {
-    ComponentHandle comp = m_byEntity[entity];
+    ComponentHandle comp = m_byEntity[getEntityIndex(entity)];
+
+    // Listeners may still access the component, so notify before it is released
+    sendDestroyMessage(entity, comp);
 
     releaseComponentID(comp);
+}
 
-    sendDestroyMessage(entity, comp);
+void BaseComponentHolder::releaseComponentID(ComponentHandle componentID)
+{
+    if (!m_freeIDs.empty()) {
+        if (m_freeIDs.back() > componentID)
+            m_freeSorted = false;
+    }
+
+    m_freeIDs.emplace_back(componentID);
+
+    destroyComponent(getComponent(componentID));
+
+    m_byEntity[getEntityIndex(m_byComponent[componentID])] = BE_NO_COMPONENT_HANDLE;
+    m_byComponent[componentID] = 0;
+
+    --m_workingComponents;
+
+    if (m_storageMode == StorageMode::PACKED) {
+        // Swap remove: move the last component into the hole
+        const u32 hole = m_denseByHandle[componentID];
+        const u32 last = m_workingComponents;
+        if (hole != last) {
+            const ComponentHandle moved = m_handleByDense[last];
+            relocateComponent(getSlot(hole), getSlot(last));
+            m_handleByDense[hole] = moved;
+            m_denseByHandle[moved] = hole;
+        }
+        m_denseByHandle[componentID] = 0;
+    }
 }
 
-void* BaseComponentHolder::getComponent(ComponentHandle componentID)
+void BaseComponentHolder::swapPackedSlots(u32 a, u32 b)
 {
-    char* ptr = m_pools[componentID / m_nComponentsPerPool];
-    return ptr + (componentID % m_nComponentsPerPool) * m_componentSize;
+    BE_ASSERT(m_storageMode == StorageMode::PACKED);
+    if (a == b) {
+        return;
+    }
+
+    if (m_swapSlot == nullptr) {
+        m_swapSlot.reset(new char[m_componentSize]);
+    }
+    relocateComponent(m_swapSlot.get(), getSlot(a));
+    relocateComponent(getSlot(a), getSlot(b));
+    relocateComponent(getSlot(b), m_swapSlot.get());
+
+    const ComponentHandle atA = m_handleByDense[a];
+    const ComponentHandle atB = m_handleByDense[b];
+    m_handleByDense[a] = atB;
+    m_handleByDense[b] = atA;
+    m_denseByHandle[atB] = a;
+    m_denseByHandle[atA] = b;
 }
 
 ComponentHandle BaseComponentHolder::getComponentForEntity(EntityHandle entity)
 {
-    if (entity >= m_byEntity.size()) {
+    const u32 index = getEntityIndex(entity);
+    if (index >= m_byEntity.size()) {
         return BE_NO_COMPONENT_HANDLE;
     }
 
-    return m_byEntity[entity];
+    // The index may belong to a newer entity
+    const ComponentHandle component = m_byEntity[index];
+    return m_byComponent[component] == entity ? component : BE_NO_COMPONENT_HANDLE;
 }
 
 const std::vector<ComponentHandle>& BaseComponentHolder::getFreeIDs()
@@ -67,18 +133,51 @@ void BaseComponentHolder::resize(u32 componentId)
     while (m_IDcapacity <= componentId) {
         m_pools.emplace_back(new char[m_componentSize * m_nComponentsPerPool]);
         m_byComponent.resize(m_byComponent.size() + m_nComponentsPerPool, 0);
+        m_changedAt.resize(m_changedAt.size() + m_nComponentsPerPool, 0);
+        m_blockChangedAt.emplace_back(0);
+        if (m_storageMode == StorageMode::PACKED) {
+            m_denseByHandle.resize(m_denseByHandle.size() + m_nComponentsPerPool, 0);
+            m_handleByDense.resize(m_handleByDense.size() + m_nComponentsPerPool, 0);
+        }
         m_IDcapacity += m_nComponentsPerPool;
     }
 }
 
+void BaseComponentHolder::reserve(u32 count)
+{
+    // Released ids are reused first
+    if (count > m_freeIDs.size()) {
+        resize(m_IDcurrent + (count - m_freeIDs.size()));
+    }
+}
+
+void BaseComponentHolder::createComponents(const EntityHandle* entities, u32 count, ComponentHandle* outHandles)
+{
+    BE_PROFILE_FUNCTION();
+    reserve(count);
+
+    u32 maxIndex = 0;
+    for (u32 i = 0; i < count; ++i) {
+        maxIndex = std::max(maxIndex, getEntityIndex(entities[i]));
+    }
+    if (maxIndex >= m_byEntity.size()) {
+        m_byEntity.resize(maxIndex + 1, 0);
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        outHandles[i] = newComponentID(entities[i]);
+    }
+}
+
 u32 BaseComponentHolder::newComponentID(EntityHandle entity)
 {
     BE_PROFILE_FUNCTION();
     ComponentHandle id = BE_NO_COMPONENT_HANDLE;
 
     // resize vector
-    if (entity >= m_byEntity.size()) {
-        m_byEntity.resize(entity + 128, 0);
+    const u32 index = getEntityIndex(entity);
+    if (index >= m_byEntity.size()) {
+        m_byEntity.resize(index + 128, 0);
     }
 
     // find the new ID
@@ -94,10 +193,17 @@ u32 BaseComponentHolder::newComponentID(EntityHandle entity)
         m_freeIDs.pop_back();
     }
 
-    m_byEntity[entity] = id;
+    m_byEntity[index] = id;
     m_byComponent[id] = entity;
 
+    if (m_storageMode == StorageMode::PACKED) {
+        // New components are always appended to the packed storage
+        m_denseByHandle[id] = m_workingComponents;
+        m_handleByDense[m_workingComponents] = id;
+    }
+
     ++m_workingComponents;
+    markChanged(id);
 
     return id;
 }
@@ -2,6 +2,12 @@
 
 #include <unordered_map>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <new>
+#include <type_traits>
 
 #include "BitEngine/Core/api.h"
 #include "BitEngine/Common/TypeDefinition.h"
@@ -21,6 +27,14 @@ struct MsgComponentCreated {
     ComponentHandle component;
 };
 
+// Sent once for all components created by EntitySystem::createEntities
+template <typename CompClass>
+struct MsgComponentsCreated {
+    const EntityHandle* entities;
+    const ComponentHandle* components;
+    u32 count;
+};
+
 template <typename CompClass>
 struct MsgComponentDestroyed {
     EntityHandle entity;
@@ -31,6 +45,12 @@ struct MsgEntityCreated {
     EntityHandle entity;
 };
 
+// Sent once for all entities created by BaseEntitySystem::createEntities
+struct MsgEntitiesCreated {
+    const EntityHandle* entities;
+    u32 count;
+};
+
 struct MsgEntityDestroyed {
     EntityHandle entity;
 };
@@ -64,22 +84,49 @@ class BaseComponentHolder {
     friend class BaseEntitySystem;
 
 public:
-    BaseComponentHolder(u32 componentSize, u32 nCompPerPool = 128);
+    enum class StorageMode {
+        // Component memory is indexed by the component handle, pointers are stable.
+        // Released components leave holes that iteration has to skip.
+        STABLE,
+        // Sparse set: live components are kept contiguous, removal moves the last
+        // component into the hole. Handles are still stable, but component pointers
+        // are only valid until the next removal.
+        PACKED,
+    };
+
+    BaseComponentHolder(u32 componentSize, u32 nCompPerPool = 128, StorageMode mode = StorageMode::STABLE);
     virtual ~BaseComponentHolder();
 
     virtual bool init() = 0;
 
+    StorageMode getStorageMode() const { return m_storageMode; }
+
     // Returns the released component
     void releaseComponentForEntity(EntityHandle entity);
 
     // Returns the component pointer
-    void* getComponent(ComponentHandle componentID);
+    inline void* getComponent(ComponentHandle componentID)
+    {
+        if (m_storageMode == StorageMode::PACKED) {
+            // Released handles point to slot 0, which holds another entity component
+            return m_byComponent[componentID] == 0 ? nullptr : getSlot(m_denseByHandle[componentID]);
+        }
+        return getSlot(componentID);
+    }
 
     // Returns the component handle for given entity
     // BE_NO_COMPONENT_HANDLE if there is no such entity/component
     ComponentHandle getComponentForEntity(EntityHandle entity);
 
-    inline EntityHandle getEntityForComponent(ComponentHandle component)
+    // Same as getComponentForEntity without validating the entity generation.
+    // For entities known to be alive and to have this component, like during iteration.
+    inline ComponentHandle getComponentForAliveEntity(EntityHandle entity) const
+    {
+        return m_byEntity[getEntityIndex(entity)];
+    }
+
+    // Returns 0 if the component was released
+    inline EntityHandle getEntityForComponent(ComponentHandle component) const
     {
         return m_byComponent[component];
     }
@@ -99,9 +146,114 @@ public:
         return m_workingComponents;
     }
 
+    // Calls f(ComponentHandle) for every valid component.
+    // STABLE: in handle order. Released components have no entity, so there is no need to walk the free list.
+    // PACKED: in storage order.
+    template <typename Func>
+    void forEachValidID(Func&& f) const
+    {
+        if (m_storageMode == StorageMode::PACKED) {
+            const ComponentHandle* handles = m_handleByDense.data();
+            for (u32 i = 0; i < m_workingComponents; ++i) {
+                f(handles[i]);
+            }
+            return;
+        }
+
+        const EntityHandle* byComponent = m_byComponent.data();
+        for (ComponentHandle id = 1; id < m_IDcurrent; ++id) {
+            if (byComponent[id] != 0) {
+                f(id);
+            }
+        }
+    }
+
+    // Calls f(ComponentHandle, void* component) for every valid component.
+    // In PACKED mode components are visited linearly, one pool at a time.
+    template <typename Func>
+    void forEachValidComponent(Func&& f)
+    {
+        forEachValidComponentInRange(0, getIterationRangeSize(), f);
+    }
+
+    // Number of storage slots visited by forEachValidComponent.
+    // STABLE: one slot per handle ever used, some of them may be released.
+    // PACKED: the number of valid components.
+    inline u32 getIterationRangeSize() const
+    {
+        return m_storageMode == StorageMode::PACKED ? m_workingComponents : m_IDcurrent;
+    }
+
+    // Same as forEachValidComponent, but only visits slots in [first, last).
+    // Disjoint ranges visit disjoint components, so they can be processed by different threads.
+    template <typename Func>
+    void forEachValidComponentInRange(u32 first, u32 last, Func&& f)
+    {
+        if (m_storageMode == StorageMode::PACKED) {
+            const ComponentHandle* handles = m_handleByDense.data();
+            last = std::min(last, m_workingComponents);
+            while (first < last) {
+                char* pool = m_pools[first / m_nComponentsPerPool];
+                const u32 poolFirst = first % m_nComponentsPerPool;
+                const u32 count = std::min(m_nComponentsPerPool - poolFirst, last - first);
+                for (u32 i = 0; i < count; ++i) {
+                    f(handles[first + i], pool + (poolFirst + i) * m_componentSize);
+                }
+                first += count;
+            }
+            return;
+        }
+
+        // Handle 0 is never used, released handles have no entity
+        const EntityHandle* byComponent = m_byComponent.data();
+        last = std::min(last, m_IDcurrent);
+        for (ComponentHandle id = std::max(first, 1u); id < last; ++id) {
+            if (byComponent[id] != 0) {
+                f(id, getSlot(id));
+            }
+        }
+    }
+
+    // Grouping, PACKED only, see EntitySystem::createGroup
+
+    // Storage slot of a component
+    inline u32 getPackedSlot(ComponentHandle componentID) const
+    {
+        return m_denseByHandle[componentID];
+    }
+
+    // Component handles in storage order
+    inline const ComponentHandle* getPackedHandles() const
+    {
+        return m_handleByDense.data();
+    }
+
+    // Component in the given storage slot
+    inline void* getPackedComponent(u32 slot)
+    {
+        return getSlot(slot);
+    }
+
+    // Exchange the components in two storage slots, their handles don't change
+    void swapPackedSlots(u32 a, u32 b);
+
+    inline u32 getComponentSize() const
+    {
+        return m_componentSize;
+    }
+
+    // Storage is allocated in pools of this many components, each pool is contiguous
+    inline u32 getComponentsPerPool() const
+    {
+        return m_nComponentsPerPool;
+    }
+
     // Resize to be able to contain up to given component id
     void resize(u32 id);
 
+    // Make room for count more components
+    void reserve(u32 count);
+
     template <typename CompClass>
     ComponentHandle createComponent(EntityHandle entity, CompClass*& outPtr)
     {
@@ -110,30 +262,141 @@ public:
         return id;
     }
 
+    // Create one component for each entity, storage grows only once.
+    // Component handles are written to outHandles, component memory is not initialized.
+    void createComponents(const EntityHandle* entities, u32 count, ComponentHandle* outHandles);
+
+    // Must be called once a new component is constructed in its slot
+    template <typename CompClass>
+    void onComponentConstructed(ComponentHandle componentID, CompClass* component)
+    {
+        if constexpr (std::is_base_of<ChangeTrackedComponent, CompClass>::value) {
+            component->m_changeHolder = this;
+            component->m_changeHandle = componentID;
+        }
+    }
+
+    // Change tracking
+    // Every component keeps the change version of its last change, and every block of
+    // getChangeBlockSize() handles keeps the latest version of its components.
+    // Blocks without changes are skipped without touching their components, so unchanged
+    // components cost nothing to queries.
+    // New components are always flagged as changed.
+    //
+    // A consumer keeps the version returned by advanceChangeVersion and passes it to the next query:
+    //     const u32 since = m_lastVersion;
+    //     m_lastVersion = holder->advanceChangeVersion();
+    //     holder->forEachChangedSince(since, ...);
+
+    // Flag the component as changed in the current change version.
+    // Can be called by several threads at once, as long as they flag different components.
+    inline void markChanged(ComponentHandle componentID)
+    {
+        const u32 version = m_changeVersion;
+        m_changedAt[componentID] = version;
+
+        std::atomic<u32>& block = m_blockChangedAt[componentID / m_nComponentsPerPool];
+        if (block.load(std::memory_order_relaxed) != version) {
+            block.store(version, std::memory_order_relaxed);
+        }
+    }
+
+    // Components flagged from now on are stamped with this version
+    inline u32 getChangeVersion() const
+    {
+        return m_changeVersion;
+    }
+
+    // Close the current change version and return it.
+    // Components flagged after this call are only visible to queries since the returned version.
+    inline u32 advanceChangeVersion()
+    {
+        return m_changeVersion++;
+    }
+
+    inline u32 getChangeBlockSize() const
+    {
+        return m_nComponentsPerPool;
+    }
+
+    // Number of change blocks visited by forEachChangedSince
+    inline u32 getChangeBlockCount() const
+    {
+        return (m_IDcurrent + m_nComponentsPerPool - 1) / m_nComponentsPerPool;
+    }
+
+    // Calls f(ComponentHandle, void* component) for every valid component changed after the given version.
+    template <typename Func>
+    void forEachChangedSince(u32 version, Func&& f)
+    {
+        forEachChangedSinceInRange(version, 0, getChangeBlockCount(), f);
+    }
+
+    // Same as forEachChangedSince, but only visits the change blocks in [firstBlock, lastBlock).
+    // Disjoint ranges visit disjoint components, so they can be processed by different threads.
+    template <typename Func>
+    void forEachChangedSinceInRange(u32 version, u32 firstBlock, u32 lastBlock, Func&& f)
+    {
+        const EntityHandle* byComponent = m_byComponent.data();
+        const u32* changedAt = m_changedAt.data();
+        lastBlock = std::min(lastBlock, getChangeBlockCount());
+        for (u32 block = firstBlock; block < lastBlock; ++block) {
+            if (m_blockChangedAt[block].load(std::memory_order_relaxed) <= version) {
+                continue;
+            }
+
+            const ComponentHandle first = std::max(block * m_nComponentsPerPool, 1u);
+            const ComponentHandle last = std::min((block + 1) * m_nComponentsPerPool, m_IDcurrent);
+            for (ComponentHandle id = first; id < last; ++id) {
+                // Released handles have no entity
+                if (changedAt[id] > version && byComponent[id] != 0) {
+                    f(id, getComponent(id));
+                }
+            }
+        }
+    }
+
 protected:
     virtual void sendDestroyMessage(EntityHandle entity, ComponentHandle component) = 0;
 
-    u32 newComponentID(EntityHandle entity);
+    // Called when a component is released, before anything is moved into its slot.
+    // Holders of components with a destructor must override this.
+    virtual void destroyComponent(void* component)
+    {
+    }
 
-private:
-    inline void releaseComponentID(ComponentHandle componentID)
+    // Used by PACKED holders to fill holes.
+    // Move dst from src, src is not used anymore after this call.
+    // Holders of components that can't be moved with memcpy must override this.
+    virtual void relocateComponent(void* dst, void* src)
     {
-        if (!m_freeIDs.empty()) {
-            if (m_freeIDs.back() > componentID)
-                m_freeSorted = false;
-        }
+        memcpy(dst, src, m_componentSize);
+    }
 
-        m_freeIDs.emplace_back(componentID);
+    u32 newComponentID(EntityHandle entity);
 
-        m_byEntity[m_byComponent[componentID]] = BE_NO_COMPONENT_HANDLE;
-        m_byComponent[componentID] = 0;
+    inline void* getSlot(u32 slot)
+    {
+        return m_pools[slot / m_nComponentsPerPool] + (slot % m_nComponentsPerPool) * m_componentSize;
+    }
 
-        --m_workingComponents;
+    // Keep the change tracking binding of a relocated component
+    template <typename CompClass>
+    static void moveChangeTracking(CompClass* dst, CompClass* src)
+    {
+        if constexpr (std::is_base_of<ChangeTrackedComponent, CompClass>::value) {
+            dst->m_changeHolder = src->m_changeHolder;
+            dst->m_changeHandle = src->m_changeHandle;
+        }
     }
 
+private:
+    void releaseComponentID(ComponentHandle componentID);
+
 protected:
     const u32 m_componentSize;
     const u32 m_nComponentsPerPool;
+    const StorageMode m_storageMode;
 
     u32 m_IDcapacity;
     u32 m_IDcurrent;
@@ -141,8 +404,15 @@ protected:
     std::vector<char*> m_pools;
     std::vector<ComponentHandle> m_freeIDs;
     std::vector<EntityHandle> m_byComponent; // given component get the entity
-    std::vector<ComponentHandle> m_byEntity; // given entity get the component
+    std::vector<ComponentHandle> m_byEntity; // given entity index get the component
+    std::vector<u32> m_denseByHandle; // PACKED only: given component get the storage slot
+    std::vector<ComponentHandle> m_handleByDense; // PACKED only: given storage slot get the component
+    std::unique_ptr<char[]> m_swapSlot; // PACKED only: temporary storage for swapPackedSlots
     bool m_freeSorted;
+
+    u32 m_changeVersion;
+    std::vector<u32> m_changedAt; // given component get the change version of its last change
+    std::deque<std::atomic<u32> > m_blockChangedAt; // given handle block get the latest change version
 };
 
 template <typename CompClass>
@@ -155,6 +425,11 @@ public:
     {
     }
 
+    ComponentHolder(StorageMode mode, u32 componentSize = sizeof(CompClass))
+        : BaseComponentHolder(componentSize, 128, mode)
+    {
+    }
+
     virtual bool init() override { return true; }
 
     CompClass* getComponent(ComponentHandle componentID)
@@ -162,7 +437,22 @@ public:
         return static_cast<CompClass*>(BaseComponentHolder::getComponent(componentID));
     }
 
+    // Calls f(ComponentHandle, CompClass*) for every valid component
+    template <typename Func>
+    void forEachComponent(Func&& f)
+    {
+        forEachValidComponent([&f](ComponentHandle id, void* comp) { f(id, static_cast<CompClass*>(comp)); });
+    }
+
+    // Calls f(ComponentHandle, CompClass*) for every valid component changed after the given version
+    template <typename Func>
+    void forEachChangedComponent(u32 version, Func&& f)
+    {
+        forEachChangedSince(version, [&f](ComponentHandle id, void* comp) { f(id, static_cast<CompClass*>(comp)); });
+    }
+
     Messenger<MsgComponentCreated<CompClass> > componentCreatedSignal;
+    Messenger<MsgComponentsCreated<CompClass> > componentsCreatedSignal;
     Messenger<MsgComponentDestroyed<CompClass> > componentDestroyedSignal;
 
 protected:
@@ -176,6 +466,19 @@ protected:
     {
         componentDestroyedSignal.emit(MsgComponentDestroyed<CompClass>{ entity, component });
     }
+
+    void destroyComponent(void* component) override
+    {
+        static_cast<CompClass*>(component)->~CompClass();
+    }
+
+    void relocateComponent(void* dst, void* src) override
+    {
+        CompClass* from = static_cast<CompClass*>(src);
+        CompClass* to = new (dst) CompClass(std::move(*from));
+        moveChangeTracking(to, from);
+        from->~CompClass();
+    }
 };
 
 template <typename CompClass>
@@ -242,6 +545,11 @@ public:
         return m_componentID;
     }
 
+    EntityHandle getEntity() const
+    {
+        return m_entity;
+    }
+
     CompClass& ref()
     {
         return *m_component;
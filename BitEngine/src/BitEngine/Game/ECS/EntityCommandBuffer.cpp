@@ -0,0 +1,124 @@
+#include "BitEngine/Game/ECS/EntityCommandBuffer.h"
+
+#include <algorithm>
+
+namespace BitEngine {
+
+static u32 alignUp(u32 value, u32 alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+EntityCommandBuffer::EntityCommandBuffer()
+    : m_currentBlock(0)
+    , m_commandCount(0)
+    , m_createCount(0)
+{
+}
+
+EntityCommandBuffer::~EntityCommandBuffer()
+{
+    clear();
+    for (Block& block : m_blocks) {
+        operator delete[](block.memory, std::align_val_t(COMMAND_ALIGNMENT));
+    }
+}
+
+DeferredEntity EntityCommandBuffer::createEntity()
+{
+    u32* index = allocCommand<u32>(&applyCreateEntity, nullptr);
+    *index = m_createCount++;
+    return DeferredEntity{ *index };
+}
+
+void EntityCommandBuffer::destroyEntity(EntityHandle entity)
+{
+    CommandTarget* target = allocCommand<CommandTarget>(&applyDestroyEntity, nullptr);
+    *target = CommandTarget{ entity, NO_DEFERRED };
+}
+
+void* EntityCommandBuffer::allocCommand(ApplyFunc apply, DiscardFunc discard, u32 dataSize)
+{
+    const u32 dataOffset = alignUp(sizeof(Command), COMMAND_ALIGNMENT);
+    const u32 size = alignUp(dataOffset + dataSize, COMMAND_ALIGNMENT);
+
+    // Find a block with enough space, blocks from previous playbacks are reused
+    while (m_currentBlock < m_blocks.size() && m_blocks[m_currentBlock].capacity - m_blocks[m_currentBlock].used < size) {
+        ++m_currentBlock;
+    }
+
+    if (m_currentBlock == m_blocks.size()) {
+        const u32 capacity = std::max(BLOCK_SIZE, size);
+        m_blocks.emplace_back(Block{ static_cast<char*>(operator new[](capacity, std::align_val_t(COMMAND_ALIGNMENT))), capacity, 0 });
+    }
+
+    Block& block = m_blocks[m_currentBlock];
+    char* memory = block.memory + block.used;
+    block.used += size;
+    ++m_commandCount;
+
+    Command* command = reinterpret_cast<Command*>(memory);
+    command->apply = apply;
+    command->discard = discard;
+    command->size = size;
+
+    return memory + dataOffset;
+}
+
+void EntityCommandBuffer::playback(BaseEntitySystem& es)
+{
+    BE_PROFILE_FUNCTION();
+    if (empty()) {
+        return;
+    }
+
+    // Grow storage once for the whole batch instead of once per command
+    es.reserveEntities(m_createCount);
+    for (ComponentType type = 0; type < m_addsByType.size(); ++type) {
+        if (m_addsByType[type] != 0) {
+            es.getHolder(type)->reserve(m_addsByType[type]);
+        }
+    }
+    m_created.resize(m_createCount);
+
+    const u32 dataOffset = alignUp(sizeof(Command), COMMAND_ALIGNMENT);
+    forEachCommand([&](Command* command) {
+        command->apply(es, *this, reinterpret_cast<char*>(command) + dataOffset);
+        command->discard = nullptr; // data was consumed
+    });
+
+    clear();
+}
+
+void EntityCommandBuffer::clear()
+{
+    const u32 dataOffset = alignUp(sizeof(Command), COMMAND_ALIGNMENT);
+    forEachCommand([&](Command* command) {
+        if (command->discard != nullptr) {
+            command->discard(reinterpret_cast<char*>(command) + dataOffset);
+        }
+    });
+
+    for (Block& block : m_blocks) {
+        block.used = 0;
+    }
+    m_currentBlock = 0;
+    m_commandCount = 0;
+    m_createCount = 0;
+    std::fill(m_addsByType.begin(), m_addsByType.end(), 0);
+}
+
+void EntityCommandBuffer::applyCreateEntity(BaseEntitySystem& es, EntityCommandBuffer& buffer, void* data)
+{
+    const u32 index = *static_cast<u32*>(data);
+    if (index >= buffer.m_created.size()) {
+        buffer.m_created.resize(index + 1); // recorded during playback
+    }
+    buffer.m_created[index] = es.createEntity();
+}
+
+void EntityCommandBuffer::applyDestroyEntity(BaseEntitySystem& es, EntityCommandBuffer& buffer, void* data)
+{
+    es.destroyEntity(buffer.resolve(*static_cast<CommandTarget*>(data)));
+}
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "BitEngine/Game/ECS/BaseEntitySystem.h"
+#include "BitEngine/Game/ECS/ComponentProcessor.h"
+
+namespace BitEngine {
+
+// Entity created by an EntityCommandBuffer.
+// It only becomes a real entity when the buffer is played back.
+struct DeferredEntity {
+    u32 index;
+};
+
+/**
+ * Records structural changes (create/destroy entities, add/remove components) to be applied later.
+ * Nothing is touched while recording, so it is safe to record from worker threads or while iterating,
+ * as long as each thread uses its own buffer (see BaseEntitySystem::getCommandBuffer).
+ * Components are constructed into the buffer memory when recorded, and moved into their holder on playback.
+ * Memory is kept between playbacks, so recording doesn't allocate once the buffer warmed up.
+ */
+class BE_API EntityCommandBuffer {
+public:
+    EntityCommandBuffer();
+    ~EntityCommandBuffer();
+
+    EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+    EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+
+    DeferredEntity createEntity();
+
+    void destroyEntity(EntityHandle entity);
+
+    template <typename CompClass, typename... Args>
+    void addComponent(EntityHandle entity, Args&&... args)
+    {
+        recordAddComponent<CompClass>(CommandTarget{ entity, NO_DEFERRED }, std::forward<Args>(args)...);
+    }
+
+    template <typename CompClass, typename... Args>
+    void addComponent(DeferredEntity entity, Args&&... args)
+    {
+        recordAddComponent<CompClass>(CommandTarget{ 0, entity.index }, std::forward<Args>(args)...);
+    }
+
+    // The component is removed only if the entity still has one when played back
+    template <typename CompClass>
+    void removeComponent(EntityHandle entity)
+    {
+        CommandTarget* target = allocCommand<CommandTarget>(&applyRemoveComponent<CompClass>, nullptr);
+        *target = CommandTarget{ entity, NO_DEFERRED };
+    }
+
+    bool empty() const
+    {
+        return m_commandCount == 0;
+    }
+
+    // Apply all commands in recording order, then clear the buffer.
+    // Must be called from the thread that owns the entity system, with no other thread recording.
+    // Commands recorded by message listeners during playback are applied too.
+    void playback(BaseEntitySystem& es);
+
+    // Discard all commands without applying them
+    void clear();
+
+    // Get the entity created for a DeferredEntity by the last playback
+    EntityHandle getCreatedEntity(DeferredEntity entity) const
+    {
+        return m_created[entity.index];
+    }
+
+private:
+    static constexpr u32 NO_DEFERRED = ~0u;
+    static constexpr u32 BLOCK_SIZE = 16 * 1024;
+    static constexpr u32 COMMAND_ALIGNMENT = 16;
+
+    typedef void (*ApplyFunc)(BaseEntitySystem& es, EntityCommandBuffer& buffer, void* data);
+    typedef void (*DiscardFunc)(void* data);
+
+    struct alignas(COMMAND_ALIGNMENT) Command {
+        ApplyFunc apply;
+        DiscardFunc discard; // destroys data that was not applied, may be null
+        u32 size; // size of this command including data
+    };
+
+    struct CommandTarget {
+        EntityHandle entity;
+        u32 deferred;
+    };
+
+    template <typename CompClass>
+    struct AddComponentData {
+        CommandTarget target;
+        typename std::aligned_storage<sizeof(CompClass), alignof(CompClass)>::type component;
+    };
+
+    struct Block {
+        char* memory;
+        u32 capacity;
+        u32 used;
+    };
+
+    template <typename CompClass, typename... Args>
+    void recordAddComponent(CommandTarget target, Args&&... args)
+    {
+        AddComponentData<CompClass>* data = allocCommand<AddComponentData<CompClass> >(&applyAddComponent<CompClass>, &discardAddComponent<CompClass>);
+        data->target = target;
+        new (&data->component) CompClass(std::forward<Args>(args)...);
+
+        const ComponentType type = CompClass::getComponentType();
+        if (m_addsByType.size() <= type) {
+            m_addsByType.resize(type + 1, 0);
+        }
+        ++m_addsByType[type];
+    }
+
+    template <typename T>
+    T* allocCommand(ApplyFunc apply, DiscardFunc discard)
+    {
+        static_assert(alignof(T) <= COMMAND_ALIGNMENT, "Command data is over aligned");
+        return static_cast<T*>(allocCommand(apply, discard, sizeof(T)));
+    }
+
+    void* allocCommand(ApplyFunc apply, DiscardFunc discard, u32 dataSize);
+
+    EntityHandle resolve(const CommandTarget& target) const
+    {
+        return target.deferred == NO_DEFERRED ? target.entity : m_created[target.deferred];
+    }
+
+    template <typename CompClass>
+    static void applyAddComponent(BaseEntitySystem& es, EntityCommandBuffer& buffer, void* data)
+    {
+        AddComponentData<CompClass>* add = static_cast<AddComponentData<CompClass>*>(data);
+        CompClass* staged = reinterpret_cast<CompClass*>(&add->component);
+        const EntityHandle entity = buffer.resolve(add->target);
+        const ComponentType type = CompClass::getComponentType();
+
+        if (es.addComponent(entity, type)) {
+            ComponentHolder<CompClass>* holder = static_cast<ComponentHolder<CompClass>*>(es.getHolder(type));
+            CompClass* comp = nullptr;
+            const ComponentHandle compID = holder->createComponent(entity, comp);
+            new (comp) CompClass(std::move(*staged));
+            holder->onComponentConstructed(compID, comp);
+            es.onComponentAdded(entity, type);
+            holder->componentCreatedSignal.emit(MsgComponentCreated<CompClass>{ entity, compID });
+        }
+        staged->~CompClass();
+    }
+
+    template <typename CompClass>
+    static void discardAddComponent(void* data)
+    {
+        AddComponentData<CompClass>* add = static_cast<AddComponentData<CompClass>*>(data);
+        reinterpret_cast<CompClass*>(&add->component)->~CompClass();
+    }
+
+    template <typename CompClass>
+    static void applyRemoveComponent(BaseEntitySystem& es, EntityCommandBuffer& buffer, void* data)
+    {
+        const EntityHandle entity = buffer.resolve(*static_cast<CommandTarget*>(data));
+        const ComponentType type = CompClass::getComponentType();
+        const ComponentHandle compID = es.getHolder(type)->getComponentForEntity(entity);
+        if (compID != BE_NO_COMPONENT_HANDLE) {
+            es.removeComponent(entity, type, compID);
+        }
+    }
+
+    static void applyCreateEntity(BaseEntitySystem& es, EntityCommandBuffer& buffer, void* data);
+    static void applyDestroyEntity(BaseEntitySystem& es, EntityCommandBuffer& buffer, void* data);
+
+    // Calls f(Command*) for every command, in recording order.
+    // Commands recorded by f are visited too.
+    template <typename Func>
+    void forEachCommand(Func&& f)
+    {
+        for (u32 b = 0; b < m_blocks.size(); ++b) {
+            for (u32 offset = 0; offset < m_blocks[b].used;) {
+                Command* command = reinterpret_cast<Command*>(m_blocks[b].memory + offset);
+                offset += command->size;
+                f(command);
+            }
+        }
+    }
+
+    std::vector<Block> m_blocks;
+    u32 m_currentBlock;
+    u32 m_commandCount;
+
+    u32 m_createCount;
+    std::vector<u32> m_addsByType; // component type -> number of add commands, used to reserve on playback
+    std::vector<EntityHandle> m_created; // deferred index -> entity created by the last playback
+};
+}
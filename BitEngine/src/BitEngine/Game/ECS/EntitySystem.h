@@ -4,24 +4,150 @@
 #include <map>
 #include <unordered_map>
 #include <functional>
+#include <tuple>
+#include <utility>
 
 #include <algorithm>
 
 #include "BitEngine/Common/TypeDefinition.h"
 #include "BitEngine/Core/Logger.h"
+#include "BitEngine/Core/ParallelFor.h"
 
 #include "BitEngine/Game/ECS/BaseEntitySystem.h"
 #include "BitEngine/Game/ECS/ComponentProcessor.h"
+#include "BitEngine/Game/ECS/EntityCommandBuffer.h"
 
 namespace BitEngine {
 
+/**
+* Query over all entities containing Base and all Others components.
+* Holders are resolved once when the view is created, and each() takes the callable
+* as a template parameter so it can be inlined.
+* Views are cheap to create, but should not be kept across component registrations.
+*/
+template <typename Base, typename... Others>
+class EntityView {
+public:
+    EntityView(const std::vector<ComponentTypeMask>* componentMasks, ComponentHolder<Base>* base, ComponentHolder<Others>*... others)
+        : m_componentMasks(componentMasks)
+        , m_base(base)
+        , m_others(others...)
+        , m_mask(getComponentMask<Others...>())
+    {
+    }
+
+    /**
+    * Iterate over all matching entities, in Base storage order.
+    * f signature: void(ComponentRef<Base>, ComponentRef<Others>...)
+    */
+    template <typename Func>
+    void each(Func&& f)
+    {
+        eachInRange(0, getRangeSize(), f);
+    }
+
+    // Number of Base storage slots, see BaseComponentHolder::getIterationRangeSize
+    u32 getRangeSize() const
+    {
+        return m_base->getIterationRangeSize();
+    }
+
+    // Same as each(), but only for the Base storage slots in [first, last)
+    template <typename Func>
+    void eachInRange(u32 first, u32 last, Func&& f)
+    {
+        m_base->forEachValidComponentInRange(first, last, [&](ComponentHandle compID, void* comp) {
+            const EntityHandle entity = m_base->getEntityForComponent(compID);
+            if (sizeof...(Others) == 0 || (*m_componentMasks)[getEntityIndex(entity)].containsAll(m_mask)) {
+                f(ComponentRef<Base>(entity, compID, static_cast<Base*>(comp)), getRef<Others>(entity)...);
+            }
+        });
+    }
+
+private:
+    template <typename CompClass>
+    ComponentRef<CompClass> getRef(EntityHandle entity)
+    {
+        ComponentHolder<CompClass>* holder = std::get<ComponentHolder<CompClass>*>(m_others);
+        const ComponentHandle compID = holder->getComponentForAliveEntity(entity);
+        return ComponentRef<CompClass>(entity, compID, static_cast<CompClass*>(holder->getComponent(compID)));
+    }
+
+    const std::vector<ComponentTypeMask>* m_componentMasks;
+    ComponentHolder<Base>* m_base;
+    std::tuple<ComponentHolder<Others>*...> m_others;
+    ComponentTypeMask m_mask; // Others types, Base is always there
+};
+
+/**
+* Query over the entities of a group, see EntitySystem::createGroup.
+* Slot i of every holder in the group belongs to the same entity, so each() walks all the
+* component arrays linearly, one pool at a time, without looking up other holders.
+*/
+template <typename... Comps>
+class EntityGroup {
+public:
+    EntityGroup(const ComponentGroup* group, ComponentHolder<Comps>*... holders)
+        : m_group(group)
+        , m_holders(holders...)
+    {
+    }
+
+    /**
+    * Iterate over all entities in the group.
+    * f signature: void(ComponentRef<Comps>...)
+    */
+    template <typename Func>
+    void each(Func&& f)
+    {
+        eachInRange(0, getRangeSize(), f);
+    }
+
+    // Number of entities in the group
+    u32 getRangeSize() const
+    {
+        return m_group->size;
+    }
+
+    // Same as each(), but only for the group slots in [first, last)
+    template <typename Func>
+    void eachInRange(u32 first, u32 last, Func&& f)
+    {
+        const u32 poolSize = m_group->holders[0]->getComponentsPerPool();
+        last = std::min(last, m_group->size);
+        while (first < last) {
+            const u32 count = std::min(poolSize - first % poolSize, last - first);
+            eachInPool(first, count, f, std::index_sequence_for<Comps...>());
+            first += count;
+        }
+    }
+
+private:
+    template <typename Func, size_t... I>
+    void eachInPool(u32 first, u32 count, Func& f, std::index_sequence<I...>)
+    {
+        const std::tuple<Comps*...> components(static_cast<Comps*>(std::get<I>(m_holders)->getPackedComponent(first))...);
+        const ComponentHandle* handles[] = { (std::get<I>(m_holders)->getPackedHandles() + first)... };
+        const BaseComponentHolder* base = std::get<0>(m_holders);
+        for (u32 i = 0; i < count; ++i) {
+            const EntityHandle entity = base->getEntityForComponent(handles[0][i]);
+            f(ComponentRef<Comps>(entity, handles[I][i], std::get<I>(components) + i)...);
+        }
+    }
+
+    const ComponentGroup* m_group;
+    std::tuple<ComponentHolder<Comps>*...> m_holders;
+};
+
 /**
 * Entity Handle and Component Handle are fixed and won't change at anytime after creation.
+* Component pointers are also fixed, unless the holder uses StorageMode::PACKED or is grouped.
 * Type safe interface
 */
 class BE_API EntitySystem : public BaseEntitySystem {
 public:
     EntitySystem()
+        : m_taskManager(nullptr)
     {
     }
 
@@ -58,6 +184,13 @@ public:
         return registerComponent<CompClass>(new ComponentHolder<CompClass>());
     }
 
+    // Register a generic ComponentHolder using the given storage mode
+    template <typename CompClass>
+    bool registerComponent(BaseComponentHolder::StorageMode mode)
+    {
+        return registerComponent<CompClass>(new ComponentHolder<CompClass>(mode));
+    }
+
     template <typename CompClass>
     ComponentHolder<CompClass>* getHolder()
     {
@@ -82,16 +215,44 @@ public:
             ComponentHolder<CompClass>* holder = getHolder<CompClass>();
             compID = holder->createComponent(entity, comp);
             holder->initializeComponent(comp, args...);
+            holder->onComponentConstructed(compID, comp);
+            onComponentAdded(entity, type);
+            comp = static_cast<CompClass*>(holder->getComponent(compID)); // may have moved into the group
             holder->componentCreatedSignal.emit(MsgComponentCreated<CompClass>{ entity, compID });
         }
 
         return ComponentRef<CompClass>(entity, compID, comp);
     }
 
+    /**
+    * Create count entities, each one with a copy of every given prototype component.
+    * Storage is grown once for the whole batch and components are copy constructed in place.
+    * Sends one MsgEntitiesCreated and one MsgComponentsCreated<T> per component type,
+    * MsgEntityCreated and MsgComponentCreated<T> are not sent for these entities.
+    *
+    * \return The created entities
+    */
+    template <typename... CompClass>
+    std::vector<EntityHandle> createEntities(u32 count, const CompClass&... prototypes)
+    {
+        BE_PROFILE_FUNCTION();
+        std::vector<EntityHandle> entities(count);
+        if (count == 0) {
+            return entities;
+        }
+
+        BaseEntitySystem::createEntities(count, entities.data());
+
+        std::vector<ComponentHandle> components(count);
+        (addComponents<CompClass>(entities, components, prototypes), ...);
+
+        return entities;
+    }
+
     template <typename CompClass>
     bool RemoveComponent(EntityHandle entity, const ComponentRef<CompClass>& ref)
     {
-        return BaseEntitySystem::removeComponent(entity, CompClass::getComponentType(), ref.m_componentID);
+        return BaseEntitySystem::removeComponent(entity, CompClass::getComponentType(), ref.getComponentID());
     }
 
     /**
@@ -112,6 +273,91 @@ public:
         return ComponentRef<CompClass>(entity, compID, comp);
     }
 
+    /**
+    * Check if ref still references the component of its entity, O(1).
+    * Fails once the component was removed or its entity destroyed, even if the
+    * component handle or the entity index were reused since then.
+    */
+    template <typename CompClass>
+    bool isValid(const ComponentRef<CompClass>& ref) const
+    {
+        return ref.isValid() && getHolder<CompClass>()->getEntityForComponent(ref.getComponentID()) == ref.getEntity();
+    }
+
+    /**
+    * Create a view over all entities with Base and Others components.
+    * Prefer this over forEach on hot paths, see EntityView.
+    */
+    template <typename Base, typename... Others>
+    EntityView<Base, Others...> view()
+    {
+        BE_ASSERT(getHolder<Base>() != nullptr);
+        return EntityView<Base, Others...>(&m_componentMasks, getHolder<Base>(), getHolder<Others>()...);
+    }
+
+    /**
+    * Group the Comps components, like an archetype: every holder keeps the components of the
+    * entities having all Comps first, in the same order, and group<Comps...>() visits them
+    * with a linear scan over each component array.
+    * Every Comps holder must use StorageMode::PACKED, and a component type can only be in one group.
+    * Adding or removing a grouped component moves components inside their holders, so their
+    * pointers are only valid until the next structural change. Handles don't change.
+    */
+    template <typename... Comps>
+    bool createGroup()
+    {
+        const bool validHolders = ((isComponentOfTypeValid(Comps::getComponentType()) && getHolder<Comps>()->getComponentSize() == sizeof(Comps)) && ...);
+        if (!validHolders) {
+            LOG(EngineLog, BE_LOG_ERROR) << "Grouped components must be registered, with holders storing exactly the component type";
+            return false;
+        }
+
+        const ComponentType types[] = { Comps::getComponentType()... };
+        return BaseEntitySystem::createGroup(types, sizeof...(Comps));
+    }
+
+    // Query over the group created by createGroup with the same types
+    template <typename... Comps>
+    EntityGroup<Comps...> group()
+    {
+        const ComponentGroup* g = getGroup(getComponentMask<Comps...>());
+        BE_ASSERT(g != nullptr);
+        return EntityGroup<Comps...>(g, getHolder<Comps>()...);
+    }
+
+    // Task manager used by parallelForEach.
+    // Without one, parallelForEach runs everything on the calling thread.
+    void setTaskManager(TaskManager* taskManager)
+    {
+        m_taskManager = taskManager;
+    }
+
+    TaskManager* getTaskManager() const
+    {
+        return m_taskManager;
+    }
+
+    /**
+    * Parallel version of view<Base, Others...>().each(f).
+    * The Base storage is split in chunks of grainSize slots, chunks are run by the task manager
+    * workers and by the calling thread. Returns after all chunks are done.
+    *
+    * f is called concurrently, in no particular order, so it:
+    * - may read and write the components it receives, and data owned by the caller that is
+    *   indexed by their component handles (one slot per call).
+    * - may read components of other entities only if no call writes them.
+    * - must not create or destroy entities, add or remove components, or emit component messages.
+    * - must synchronize any other shared state itself.
+    */
+    template <typename Base, typename... Others, typename Func>
+    void parallelForEach(u32 grainSize, Func&& f)
+    {
+        EntityView<Base, Others...> entities = view<Base, Others...>();
+        parallelForRange(m_taskManager, entities.getRangeSize(), grainSize, [&entities, &f](u32 first, u32 last) {
+            entities.eachInRange(first, last, f);
+        });
+    }
+
     template <typename T>
     struct identity {
         typedef T&& type;
@@ -123,41 +369,20 @@ public:
     template <typename Base, typename... ContainComps>
     void forEach(typename identity<Logic<Base, ContainComps...> >::type f)
     {
-        // TODO: otimize calls of getComponentRefE with this:
-        // std::tuple<ComponentHolder<ContainComps>*... > holders = std::make_tuple{ getHolder<ContainComps>()... };
-
-        ComponentType types[] = { ContainComps::getComponentType()... };
-
         ComponentHolder<Base>* holder = getHolder<Base>();
         LOGIFNULL(EngineLog, BE_LOG_ERROR, holder);
-        const auto& freeIDs = holder->getFreeIDs(); // sorted ids
-        const auto& allComponents = holder->getAllComponents();
-        u32 curFree = 0;
 
-        u32 validComponents = holder->getNumValidComponents();
-
-        BitMask componentMask{ 0 };
-        for (ComponentType t : types) {
-            componentMask.b64 |= 1ull << t;
-        }
+        const ComponentTypeMask componentMask = getComponentMask<ContainComps...>();
 
         // loop through base components searching for matching pairs on Args types
-        u32 freeIds = freeIDs.size();
-        for (u32 compID = 1; compID <= validComponents; ++compID) {
-            const EntityHandle entity = allComponents[compID];
+        holder->forEachValidComponent([&](ComponentHandle compID, void* comp) {
+            const EntityHandle entity = holder->getEntityForComponent(compID);
 
-            if ((curFree < freeIds && freeIDs[curFree] != compID) || curFree >= freeIds) {
-                // Test to see if this entity has all needed components
-                if ((m_objBitField->getObj(entity).b64 & componentMask.b64) == componentMask.b64) {
-                    Base* comp = holder->getComponent(compID);
-                    f(ComponentRef<Base>(entity, compID, comp), getComponentRefE<ContainComps>(entity)...); // TODO: avoid getHolder<>() every time
-                }
+            // Test to see if this entity has all needed components
+            if (m_componentMasks[getEntityIndex(entity)].containsAll(componentMask)) {
+                f(ComponentRef<Base>(entity, compID, static_cast<Base*>(comp)), getComponentRefE<ContainComps>(entity)...); // TODO: avoid getHolder<>() every time
             }
-            else {
-                ++curFree;
-                ++validComponents;
-            }
-        }
+        });
     }
 
     /*template<typename Caller, typename Base, typename ... ContainComps>
@@ -186,7 +411,7 @@ public:
             if ((curFree < freeIDs.size() && freeIDs[curFree] != compID) || curFree >= freeIDs.size())
             {
                 // Test to see if this entity has all needed components
-                if ( (m_objBitField->getObj(entity).b64 & componentMask.b64) == componentMask.b64 )
+                if ( (m_objBitField->getObj(getEntityIndex(entity)).b64 & componentMask.b64) == componentMask.b64 )
                 {
                     Base* comp = holder->getComponent(compID);
 
@@ -207,20 +432,9 @@ public:
         ComponentHolder<CompClass>* holder = getHolder<CompClass>();
         BE_ASSERT(holder != nullptr);
 
-        const auto& freeIDs = holder->getFreeIDs(); // sorted ids
-        u32 curFree = 0;
-
-        u32 validComponents = holder->getNumValidComponents();
-        for (u32 compID = 1; compID <= validComponents; ++compID) {
-            if ((curFree < freeIDs.size() && freeIDs[curFree] != compID) || curFree >= freeIDs.size()) {
-                CompClass* comp = holder->getComponent(compID);
-                f(compID, *comp);
-            }
-            else {
-                ++curFree;
-                ++validComponents;
-            }
-        }
+        holder->forEachValidComponent([&](ComponentHandle compID, void* comp) {
+            f(compID, *static_cast<CompClass*>(comp));
+        });
     }
 
     template <typename Caller, typename CompClass>
@@ -229,20 +443,9 @@ public:
         ComponentHolder<CompClass>* holder = getHolder<CompClass>();
         LOGIFNULL(EngineLog, BE_LOG_ERROR, holder);
 
-        const auto& freeIDs = holder->getFreeIDs(); // sorted ids
-        u32 curFree = 0;
-
-        u32 validComponents = holder->getNumValidComponents();
-        for (u32 compID = 1; compID <= validComponents; ++compID) {
-            if ((curFree < freeIDs.size() && freeIDs[curFree] != compID) || curFree >= freeIDs.size()) {
-                CompClass* comp = holder->getComponent(compID);
-                f(caller, compID, *comp);
-            }
-            else {
-                ++curFree;
-                ++validComponents;
-            }
-        }
+        holder->forEachValidComponent([&](ComponentHandle compID, void* comp) {
+            f(caller, compID, *static_cast<CompClass*>(comp));
+        });
     }
 
     template <typename CompClass>
@@ -252,6 +455,28 @@ public:
     }
 
 private:
+    template <typename CompClass>
+    void addComponents(const std::vector<EntityHandle>& entities, std::vector<ComponentHandle>& components, const CompClass& prototype)
+    {
+        const ComponentType type = CompClass::getComponentType();
+        const u32 count = entities.size();
+        for (EntityHandle entity : entities) {
+            BaseEntitySystem::addComponent(entity, type);
+        }
+
+        ComponentHolder<CompClass>* holder = getHolder<CompClass>();
+        holder->createComponents(entities.data(), count, components.data());
+        for (u32 i = 0; i < count; ++i) {
+            CompClass* comp = new (holder->getComponent(components[i])) CompClass(prototype);
+            holder->onComponentConstructed(components[i], comp);
+        }
+        for (EntityHandle entity : entities) {
+            onComponentAdded(entity, type);
+        }
+
+        holder->componentsCreatedSignal.emit(MsgComponentsCreated<CompClass>{ entities.data(), components.data(), count });
+    }
+
     template <typename CompClass>
     ComponentRef<CompClass> getComponentRefE(EntityHandle entity)
     {
@@ -263,5 +488,7 @@ private:
 
         return ComponentRef<CompClass>(entity, compID, comp);
     }
+
+    TaskManager* m_taskManager;
 };
 }
@@ -4,8 +4,9 @@ namespace BitEngine {
 
 GameLogicProcessor::GameLogicProcessor(EntitySystem* m)
     : ComponentProcessor(m)
-    , Messenger<MsgComponentCreated<GameLogicComponent> >::ScopedSubscription(m->getHolder<GameLogicComponent>()->componentCreatedSignal, &GameLogicProcessor::onMessage, this)
-    , Messenger<MsgComponentDestroyed<GameLogicComponent> >::ScopedSubscription(m->getHolder<GameLogicComponent>()->componentDestroyedSignal, &GameLogicProcessor::onMessage, this)
+    , Messenger<MsgComponentCreated<GameLogicComponent> >::ScopedSubscription(m->getHolder<GameLogicComponent>()->componentCreatedSignal, Messenger<MsgComponentCreated<GameLogicComponent> >::bind<GameLogicProcessor, &GameLogicProcessor::onMessage>(this))
+    , Messenger<MsgComponentsCreated<GameLogicComponent> >::ScopedSubscription(m->getHolder<GameLogicComponent>()->componentsCreatedSignal, Messenger<MsgComponentsCreated<GameLogicComponent> >::bind<GameLogicProcessor, &GameLogicProcessor::onMessage>(this))
+    , Messenger<MsgComponentDestroyed<GameLogicComponent> >::ScopedSubscription(m->getHolder<GameLogicComponent>()->componentDestroyedSignal, Messenger<MsgComponentDestroyed<GameLogicComponent> >::bind<GameLogicProcessor, &GameLogicProcessor::onMessage>(this))
 {
     gameLogicHolder = getES()->getHolder<GameLogicComponent>();
 }
@@ -86,6 +87,19 @@ void GameLogicProcessor::onMessage(const MsgComponentCreated<GameLogicComponent>
     m_notInitialized.emplace_back(msg.component);
 }
 
+void GameLogicProcessor::onMessage(const MsgComponentsCreated<GameLogicComponent>& msg)
+{
+    BE_PROFILE_FUNCTION();
+    m_notInitialized.reserve(m_notInitialized.size() + msg.count);
+    for (u32 i = 0; i < msg.count; ++i) {
+        GameLogicComponent* glc = gameLogicHolder->getComponent(msg.components[i]);
+        glc->e_sys = getES();
+        glc->m_entity = msg.entities[i];
+
+        m_notInitialized.emplace_back(msg.components[i]);
+    }
+}
+
 void GameLogicProcessor::onMessage(const MsgComponentDestroyed<GameLogicComponent>& msg)
 {
     BE_PROFILE_FUNCTION();
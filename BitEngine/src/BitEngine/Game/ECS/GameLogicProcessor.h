@@ -7,6 +7,7 @@ namespace BitEngine {
 
 class BE_API GameLogicProcessor : public ComponentProcessor,
                                   public Messenger<MsgComponentCreated<GameLogicComponent> >::ScopedSubscription,
+                                  public Messenger<MsgComponentsCreated<GameLogicComponent> >::ScopedSubscription,
                                   public Messenger<MsgComponentDestroyed<GameLogicComponent> >::ScopedSubscription {
 public:
     GameLogicProcessor(EntitySystem* m);
@@ -17,6 +18,7 @@ public:
     void FrameEnd();
 
     void onMessage(const MsgComponentCreated<GameLogicComponent>& msg);
+    void onMessage(const MsgComponentsCreated<GameLogicComponent>& msg);
     void onMessage(const MsgComponentDestroyed<GameLogicComponent>& msg);
 
 private:
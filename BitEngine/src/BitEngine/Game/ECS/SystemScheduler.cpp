@@ -0,0 +1,321 @@
+#include "BitEngine/Game/ECS/SystemScheduler.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace BitEngine {
+
+/**
+ * State of a single SystemScheduler::run.
+ * Systems become ready once all their dependencies finished. Ready systems are taken by the
+ * thread calling run() and by helper tasks; a helper task exits once there is nothing ready.
+ * Helpers keep the frame alive, but only touch the scheduler after taking a system, which can
+ * only happen while run() is waiting.
+ */
+class SystemSchedulerFrame : public std::enable_shared_from_this<SystemSchedulerFrame> {
+public:
+    SystemSchedulerFrame(SystemScheduler* scheduler, TaskManager* taskManager)
+        : m_scheduler(scheduler)
+        , m_taskManager(taskManager)
+        , m_finished(0)
+    {
+        const std::vector<SystemScheduler::System>& systems = scheduler->m_systems;
+        m_pending.resize(systems.size());
+        for (u32 i = 0; i < systems.size(); ++i) {
+            m_pending[i] = systems[i].dependencies.size();
+            if (m_pending[i] == 0) {
+                pushReady(i);
+            }
+        }
+    }
+
+    // Called by the thread that started the frame, returns when all systems finished
+    void runMain()
+    {
+        // The calling thread may be busy with main thread systems, so every ready system gets a helper
+        spawnHelpers(m_ready.size());
+
+        const u32 total = m_pending.size();
+        for (;;) {
+            u32 index;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_finished == total) {
+                    return;
+                }
+                if (!popReady(index, true)) {
+                    index = total;
+                }
+            }
+
+            if (index != total) {
+                runSystem(index);
+            }
+            else {
+                // Nothing for this thread yet, help the pool (maybe with our own helpers)
+                m_taskManager->runPendingTask();
+            }
+        }
+    }
+
+    // Called by helper tasks
+    void runHelper()
+    {
+        for (;;) {
+            u32 index;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!popReady(index, false)) {
+                    return;
+                }
+            }
+            runSystem(index);
+        }
+    }
+
+private:
+    class HelperTask : public Task {
+    public:
+        HelperTask(std::shared_ptr<SystemSchedulerFrame> frame)
+            : Task(TaskMode::NONE, Affinity::BACKGROUND)
+            , m_frame(frame)
+        {
+        }
+
+    private:
+        void run() override
+        {
+            m_frame->runHelper();
+        }
+
+        std::shared_ptr<SystemSchedulerFrame> m_frame;
+    };
+
+    void runSystem(u32 index)
+    {
+        m_scheduler->runSystem(index);
+
+        u32 newReady = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (u32 successor : m_scheduler->m_systems[index].successors) {
+                if (--m_pending[successor] == 0) {
+                    newReady += pushReady(successor) ? 1 : 0;
+                }
+            }
+            ++m_finished;
+        }
+
+        // This thread keeps working, so it takes one of the new systems itself
+        if (newReady > 1) {
+            spawnHelpers(newReady - 1);
+        }
+    }
+
+    void spawnHelpers(u32 count)
+    {
+        if (m_taskManager == nullptr) {
+            return;
+        }
+
+        count = std::min(count, m_taskManager->getWorkerCount());
+        for (u32 i = 0; i < count; ++i) {
+            m_taskManager->addTask(makeTask<HelperTask>(shared_from_this()));
+        }
+    }
+
+    // Returns true if the system can be run by helpers
+    bool pushReady(u32 index)
+    {
+        if (m_scheduler->m_systems[index].mainThread) {
+            m_readyMain.emplace_back(index);
+            return false;
+        }
+        m_ready.emplace_back(index);
+        return true;
+    }
+
+    // Pop the earliest registered system, so the serial order is kept when nothing runs in parallel
+    bool popReady(u32& index, bool main)
+    {
+        std::vector<u32>* lists[] = { &m_ready, main ? &m_readyMain : nullptr };
+        std::vector<u32>* from = nullptr;
+        std::vector<u32>::iterator best;
+        for (std::vector<u32>* list : lists) {
+            if (list == nullptr || list->empty()) {
+                continue;
+            }
+            std::vector<u32>::iterator it = std::min_element(list->begin(), list->end());
+            if (from == nullptr || *it < *best) {
+                from = list;
+                best = it;
+            }
+        }
+
+        if (from == nullptr) {
+            return false;
+        }
+
+        index = *best;
+        from->erase(best);
+        return true;
+    }
+
+    SystemScheduler* const m_scheduler;
+    TaskManager* const m_taskManager;
+
+    std::mutex m_mutex;
+    std::vector<u32> m_pending; // dependencies not finished yet
+    std::vector<u32> m_ready;
+    std::vector<u32> m_readyMain;
+    u32 m_finished;
+};
+
+SystemScheduler::SystemBuilder& SystemScheduler::SystemBuilder::exclusive()
+{
+    m_scheduler->m_systems[m_index].exclusive = true;
+    m_scheduler->m_scheduleDirty = true;
+    return *this;
+}
+
+SystemScheduler::SystemBuilder& SystemScheduler::SystemBuilder::mainThread()
+{
+    m_scheduler->m_systems[m_index].mainThread = true;
+    return *this;
+}
+
+SystemScheduler::SystemScheduler(TaskManager* taskManager)
+    : m_taskManager(taskManager)
+    , m_scheduleDirty(true)
+{
+}
+
+SystemScheduler::SystemBuilder SystemScheduler::addSystem(const std::string& name, SystemFunc func)
+{
+    System system;
+    system.name = name;
+    system.func = func;
+    system.exclusive = false;
+    system.mainThread = false;
+    system.wave = 0;
+    m_systems.emplace_back(system);
+    m_scheduleDirty = true;
+
+    return SystemBuilder(this, m_systems.size() - 1);
+}
+
+void SystemScheduler::addAccess(u32 index, ComponentType type, const char* name, bool write)
+{
+    BE_ASSERT(type < BE_MAX_COMPONENT_TYPES);
+
+    System& system = m_systems[index];
+    if (write) {
+        system.writes.set(type);
+        system.writeNames.emplace_back(name);
+    }
+    else {
+        system.reads.set(type);
+        system.readNames.emplace_back(name);
+    }
+    m_scheduleDirty = true;
+}
+
+bool SystemScheduler::conflicts(const System& a, const System& b)
+{
+    if (a.exclusive || b.exclusive) {
+        return true;
+    }
+
+    return a.writes.intersects(b.reads | b.writes)
+        || b.writes.intersects(a.reads);
+}
+
+void SystemScheduler::buildSchedule()
+{
+    BE_PROFILE_FUNCTION();
+    for (System& system : m_systems) {
+        system.dependencies.clear();
+        system.successors.clear();
+        system.wave = 0;
+    }
+
+    // A system waits for every earlier system it conflicts with
+    for (u32 j = 0; j < m_systems.size(); ++j) {
+        for (u32 i = 0; i < j; ++i) {
+            if (conflicts(m_systems[i], m_systems[j])) {
+                m_systems[j].dependencies.emplace_back(i);
+                m_systems[i].successors.emplace_back(j);
+                m_systems[j].wave = std::max(m_systems[j].wave, m_systems[i].wave + 1);
+            }
+        }
+    }
+
+    m_scheduleDirty = false;
+    LOG(EngineLog, BE_LOG_VERBOSE) << "System schedule:\n"
+                                   << dumpSchedule();
+}
+
+void SystemScheduler::runSystem(u32 index)
+{
+    const System& system = m_systems[index];
+    BE_PROFILE_SCOPE(system.name.c_str());
+    system.func();
+}
+
+void SystemScheduler::run()
+{
+    BE_PROFILE_FUNCTION();
+    if (m_scheduleDirty) {
+        buildSchedule();
+    }
+
+    if (m_systems.empty()) {
+        return;
+    }
+
+    if (m_taskManager == nullptr || m_taskManager->getWorkerCount() == 0) {
+        for (u32 i = 0; i < m_systems.size(); ++i) {
+            runSystem(i);
+        }
+        return;
+    }
+
+    std::make_shared<SystemSchedulerFrame>(this, m_taskManager)->runMain();
+}
+
+std::string SystemScheduler::dumpSchedule()
+{
+    if (m_scheduleDirty) {
+        buildSchedule();
+    }
+
+    std::ostringstream out;
+    for (const System& system : m_systems) {
+        out << "[" << system.wave << "] " << system.name;
+        if (system.exclusive) {
+            out << " (exclusive)";
+        }
+        if (system.mainThread) {
+            out << " (main thread)";
+        }
+
+        out << " reads:";
+        for (const std::string& name : system.readNames) {
+            out << " " << name;
+        }
+        out << " writes:";
+        for (const std::string& name : system.writeNames) {
+            out << " " << name;
+        }
+        out << " after:";
+        for (u32 dependency : system.dependencies) {
+            out << " " << m_systems[dependency].name;
+        }
+        out << "\n";
+    }
+
+    return out.str();
+}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "BitEngine/Core/TaskManager.h"
+#include "BitEngine/Game/ECS/Component.h"
+
+namespace BitEngine {
+
+/**
+ * Runs ECS systems (processors, free functions) once per frame, in parallel when possible.
+ * Every system declares which component types it reads and which it writes.
+ * Two systems conflict when one writes a type the other reads or writes. Conflicting systems
+ * always run in registration order, other systems may run at the same time on the TaskManager workers.
+ *
+ * Systems running in parallel must not make structural changes (create/destroy entities,
+ * add/remove components), mark those systems as exclusive.
+ *
+ * Usage:
+ *   scheduler.addSystem("Spinner", [es]() { SpinnerSystem(es); })
+ *       .reads<SpinnerComponent>()
+ *       .writes<Transform2DComponent>();
+ *   ...
+ *   scheduler.run(); // every frame
+ */
+class BE_API SystemScheduler {
+public:
+    typedef std::function<void()> SystemFunc;
+
+    class SystemBuilder {
+    public:
+        SystemBuilder(SystemScheduler* scheduler, u32 index)
+            : m_scheduler(scheduler)
+            , m_index(index)
+        {
+        }
+
+        template <typename... CompClass>
+        SystemBuilder& reads()
+        {
+            const ComponentType types[] = { CompClass::getComponentType()... };
+            const char* names[] = { typeid(CompClass).name()... };
+            for (u32 i = 0; i < sizeof...(CompClass); ++i) {
+                m_scheduler->addAccess(m_index, types[i], names[i], false);
+            }
+            return *this;
+        }
+
+        template <typename... CompClass>
+        SystemBuilder& writes()
+        {
+            const ComponentType types[] = { CompClass::getComponentType()... };
+            const char* names[] = { typeid(CompClass).name()... };
+            for (u32 i = 0; i < sizeof...(CompClass); ++i) {
+                m_scheduler->addAccess(m_index, types[i], names[i], true);
+            }
+            return *this;
+        }
+
+        // Conflicts with all other systems.
+        // Use for systems that make structural changes or access unknown data.
+        SystemBuilder& exclusive();
+
+        // Always run on the thread calling SystemScheduler::run.
+        SystemBuilder& mainThread();
+
+    private:
+        SystemScheduler* m_scheduler;
+        u32 m_index;
+    };
+
+    SystemScheduler(TaskManager* taskManager = nullptr);
+
+    // Task manager used to run systems in parallel.
+    // Without one, systems run in registration order on the calling thread.
+    void setTaskManager(TaskManager* taskManager) { m_taskManager = taskManager; }
+
+    SystemBuilder addSystem(const std::string& name, SystemFunc func);
+
+    // Run all systems once, returns when all of them are done.
+    void run();
+
+    // Human readable schedule, one line per system:
+    // name, wave, accesses and the systems it waits for.
+    // Systems in the same wave can run at the same time.
+    std::string dumpSchedule();
+
+    u32 getSystemCount() const { return m_systems.size(); }
+
+private:
+    struct System {
+        std::string name;
+        SystemFunc func;
+        ComponentTypeMask reads;
+        ComponentTypeMask writes;
+        bool exclusive;
+        bool mainThread;
+        std::vector<std::string> readNames;
+        std::vector<std::string> writeNames;
+
+        // Computed by buildSchedule
+        std::vector<u32> dependencies;
+        std::vector<u32> successors;
+        u32 wave;
+    };
+
+    friend class SystemBuilder;
+    friend class SystemSchedulerFrame;
+
+    void addAccess(u32 system, ComponentType type, const char* name, bool write);
+    static bool conflicts(const System& a, const System& b);
+    void buildSchedule();
+    void runSystem(u32 index);
+
+    TaskManager* m_taskManager;
+    std::vector<System> m_systems;
+    bool m_scheduleDirty;
+};
+}
@@ -8,7 +8,6 @@ Transform2DComponent::Transform2DComponent()
     : position(0.0f, 0.0f)
     , scale(1.0f, 1.0f)
     , rotation(0.0f)
-    , m_dirty(true)
 {
 }
 
@@ -24,7 +23,7 @@ const Vec2& Transform2DComponent::getLocalPosition() const
 void Transform2DComponent::setLocalPosition(const Vec2& p)
 {
     position = p;
-    m_dirty = true;
+    markChanged();
 }
 
 const Vec2& Transform2DComponent::getLocalScale() const
@@ -35,7 +34,7 @@ const Vec2& Transform2DComponent::getLocalScale() const
 void Transform2DComponent::setLocalScale(const Vec2& s)
 {
     scale = s;
-    m_dirty = true;
+    markChanged();
 }
 
 float Transform2DComponent::getLocalRotation() const
@@ -46,6 +45,6 @@ float Transform2DComponent::getLocalRotation() const
 void Transform2DComponent::setLocalRotation(float rad)
 {
     rotation = rad;
-    m_dirty = true;
+    markChanged();
 }
 }
@@ -5,7 +5,7 @@
 
 namespace BitEngine {
 
-class BE_API Transform2DComponent : public Component<Transform2DComponent> {
+class BE_API Transform2DComponent : public Component<Transform2DComponent>, public ChangeTrackedComponent {
 public:
     Transform2DComponent();
     ~Transform2DComponent();
@@ -17,7 +17,7 @@ public:
     {
         position.x = (float)x;
         position.y = (float)y;
-        m_dirty = true;
+        markChanged();
     }
     void setLocalPosition(const Vec2& p); // sets LOCAL position
 
@@ -42,8 +42,6 @@ public:
     Vec2 position;
     Vec2 scale;
     float rotation;
-
-    bool m_dirty;
 };
 
 class BE_API SceneTransform2DComponent
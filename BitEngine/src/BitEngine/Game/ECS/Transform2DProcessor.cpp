@@ -1,14 +1,66 @@
 #include "BitEngine/Game/ECS/EntitySystem.h"
 #include "BitEngine/Game/ECS/Transform2DProcessor.h"
+#include "BitEngine/Core/TransformKernels.h"
 
 #include <algorithm>
 
 namespace BitEngine {
 
+// Transforms per parallel chunk when computing local matrices
+static const u32 LOCAL_MATRIX_GRAIN_SIZE = 1024;
+// Transforms per parallel chunk of a hierarchy level when computing global matrices
+static const u32 GLOBAL_MATRIX_GRAIN_SIZE = 512;
+
+namespace {
+    // Collects transforms to compute their local matrices with the batch kernel
+    class LocalMatrixBatch2D {
+    public:
+        static const u32 SIZE = 64;
+
+        LocalMatrixBatch2D()
+            : m_count(0)
+        {
+        }
+
+        void add(const Transform2DComponent& comp, glm::mat3& mat)
+        {
+            m_px[m_count] = comp.position.x;
+            m_py[m_count] = comp.position.y;
+            m_rotation[m_count] = comp.rotation;
+            m_sx[m_count] = comp.scale.x;
+            m_sy[m_count] = comp.scale.y;
+            m_out[m_count] = &mat[0][0];
+
+            if (++m_count == SIZE) {
+                flush();
+            }
+        }
+
+        void flush()
+        {
+            TransformKernels::composeLocal2D({ m_px, m_py, m_rotation, m_sx, m_sy }, m_count, m_out);
+            m_count = 0;
+        }
+
+    private:
+        u32 m_count;
+        alignas(32) float m_px[SIZE];
+        alignas(32) float m_py[SIZE];
+        alignas(32) float m_rotation[SIZE];
+        alignas(32) float m_sx[SIZE];
+        alignas(32) float m_sy[SIZE];
+        float* m_out[SIZE];
+    };
+}
+
 Transform2DProcessor::Transform2DProcessor(EntitySystem* m)
     : ComponentProcessor(m)
-    , Messenger<MsgComponentCreated<Transform2DComponent> >::ScopedSubscription(m->getHolder<Transform2DComponent>()->componentCreatedSignal, &Transform2DProcessor::onMessage, this)
-    , Messenger<MsgComponentDestroyed<Transform2DComponent> >::ScopedSubscription(m->getHolder<Transform2DComponent>()->componentDestroyedSignal, &Transform2DProcessor::onMessage, this)
+    , Messenger<MsgComponentCreated<Transform2DComponent> >::ScopedSubscription(m->getHolder<Transform2DComponent>()->componentCreatedSignal, Messenger<MsgComponentCreated<Transform2DComponent> >::bind<Transform2DProcessor, &Transform2DProcessor::onMessage>(this))
+    , Messenger<MsgComponentsCreated<Transform2DComponent> >::ScopedSubscription(m->getHolder<Transform2DComponent>()->componentsCreatedSignal, Messenger<MsgComponentsCreated<Transform2DComponent> >::bind<Transform2DProcessor, &Transform2DProcessor::onMessage>(this))
+    , Messenger<MsgComponentDestroyed<Transform2DComponent> >::ScopedSubscription(m->getHolder<Transform2DComponent>()->componentDestroyedSignal, Messenger<MsgComponentDestroyed<Transform2DComponent> >::bind<Transform2DProcessor, &Transform2DProcessor::onMessage>(this))
+    , Messenger<MsgComponentCreated<SceneTransform2DComponent> >::ScopedSubscription(m->getHolder<SceneTransform2DComponent>()->componentCreatedSignal, Messenger<MsgComponentCreated<SceneTransform2DComponent> >::bind<Transform2DProcessor, &Transform2DProcessor::onMessage>(this))
+    , Messenger<MsgComponentsCreated<SceneTransform2DComponent> >::ScopedSubscription(m->getHolder<SceneTransform2DComponent>()->componentsCreatedSignal, Messenger<MsgComponentsCreated<SceneTransform2DComponent> >::bind<Transform2DProcessor, &Transform2DProcessor::onMessage>(this))
+    , m_lastChangeVersion(0)
 {
 }
 
@@ -19,85 +71,113 @@ Transform2DProcessor::~Transform2DProcessor()
 void Transform2DProcessor::CalculateLocalModelMatrix(const Transform2DComponent& comp, glm::mat3& mat)
 {
     // T R S
-    float cosx = cos(comp.rotation);
-    float sinx = sin(comp.rotation);
-    mat = glm::transpose(glm::mat3(comp.scale.x * cosx, comp.scale.y * sinx, comp.position.x,
-        -comp.scale.x * sinx, comp.scale.y * cosx, comp.position.y,
-        0.0f, 0.0f, 1.0f));
+    // Same as glm::transpose(glm::mat3(sx * cos, sy * sin, px, -sx * sin, sy * cos, py, 0, 0, 1))
+    // A single transform takes the scalar path of the kernel
+    float* out = &mat[0][0];
+    TransformKernels::composeLocal2D({ &comp.position.x, &comp.position.y, &comp.rotation, &comp.scale.x, &comp.scale.y }, 1, &out);
 }
 
 void Transform2DProcessor::onMessage(const MsgComponentCreated<Transform2DComponent>& msg)
 {
-    const u32 nComponents = msg.component;
+    hierarchy.add(msg.component);
+}
 
-    if (hierarchy.size() <= nComponents) {
-        hierarchy.resize(nComponents + 1);
+void Transform2DProcessor::onMessage(const MsgComponentsCreated<Transform2DComponent>& msg)
+{
+    for (u32 i = 0; i < msg.count; ++i) {
+        hierarchy.add(msg.components[i]);
     }
 }
 
 void Transform2DProcessor::onMessage(const MsgComponentDestroyed<Transform2DComponent>& msg)
 {
     // Childs lost their parent. Let them to the previous parent root.
-    for (ComponentHandle c : hierarchy[msg.component].childs) {
-        setParentOf(c, hierarchy[msg.component].parent);
+    ComponentHolder<Transform2DComponent>* transforms = getES()->getHolder<Transform2DComponent>();
+    hierarchy.forEachChild(msg.component, [transforms](ComponentHandle c) {
+        transforms->markChanged(c);
+    });
+    hierarchy.remove(msg.component);
+}
+
+void Transform2DProcessor::onMessage(const MsgComponentCreated<SceneTransform2DComponent>& msg)
+{
+    markTransformChanged(msg.entity);
+}
+
+void Transform2DProcessor::onMessage(const MsgComponentsCreated<SceneTransform2DComponent>& msg)
+{
+    for (u32 i = 0; i < msg.count; ++i) {
+        markTransformChanged(msg.entities[i]);
+    }
+}
+
+void Transform2DProcessor::markTransformChanged(EntityHandle entity)
+{
+    ComponentHolder<Transform2DComponent>* transforms = getES()->getHolder<Transform2DComponent>();
+    const ComponentHandle t = transforms->getComponentForEntity(entity);
+    if (t != BE_NO_COMPONENT_HANDLE) {
+        transforms->markChanged(t);
     }
 }
 
 void Transform2DProcessor::setParentOf(ComponentHandle a, ComponentHandle parent)
 {
-    const ComponentHandle prevParent = hierarchy[a].parent;
-    if (prevParent == parent)
+    if (hierarchy.getParent(a) == parent)
         return;
 
-    // Remove child from previous parent
-    hierarchy[prevParent].removeChild(a);
-
-    // Set parent for given component
-    hierarchy[a].parent = parent;
-    hierarchy[a].dirty = true;
+    hierarchy.setParent(a, parent);
+    getES()->getHolder<Transform2DComponent>()->markChanged(a);
+}
 
-    // Add child for new parent
-    hierarchy[parent].addChild(a);
+SceneTransform2DComponent* Transform2DProcessor::getSceneTransform(ComponentHolder<Transform2DComponent>* transforms, ComponentHolder<SceneTransform2DComponent>* holder, ComponentHandle t)
+{
+    const ComponentHandle c = holder->getComponentForEntity(transforms->getEntityForComponent(t));
+    return c != BE_NO_COMPONENT_HANDLE ? holder->getComponent(c) : nullptr;
 }
 
 void Transform2DProcessor::Process()
 {
     BE_PROFILE_FUNCTION();
-    getES()->forEach<Transform2DComponent, SceneTransform2DComponent>(
-        [this](ComponentRef<Transform2DComponent> transform, ComponentRef<SceneTransform2DComponent> scene) {
-            if (transform->m_dirty) {
-                transform->m_dirty = false;
-                CalculateLocalModelMatrix(transform.ref(), scene->m_local);
-                hierarchy[scene.getComponentID()].dirty = true;
-            }
-        });
-
+    ComponentHolder<Transform2DComponent>* transforms = getES()->getHolder<Transform2DComponent>();
     ComponentHolder<SceneTransform2DComponent>* holder = getES()->getHolder<SceneTransform2DComponent>();
-
-    // Update globalTransform of valid components
-    getES()->forEach<Transform2DComponent, SceneTransform2DComponent>(
-        [this, holder](ComponentRef<Transform2DComponent> transform, ComponentRef<SceneTransform2DComponent> scene) {
-            const ComponentHandle c = scene.getComponentID();
-            recalcGlobalTransform(holder, scene.ref(), hierarchy[c]);
+    const u32 since = m_lastChangeVersion;
+    m_lastChangeVersion = transforms->advanceChangeVersion();
+
+    // Local matrices only touch their own component and hierarchy slot, so they can be computed in parallel
+    const u32 blockGrain = std::max(LOCAL_MATRIX_GRAIN_SIZE / transforms->getChangeBlockSize(), 1u);
+    parallelForRange(getES()->getTaskManager(), transforms->getChangeBlockCount(), blockGrain,
+        [this, transforms, holder, since](u32 first, u32 last) {
+            LocalMatrixBatch2D batch;
+            transforms->forEachChangedSinceInRange(since, first, last, [this, transforms, holder, &batch](ComponentHandle t, void* transform) {
+                SceneTransform2DComponent* scene = getSceneTransform(transforms, holder, t);
+                if (scene == nullptr) {
+                    // Marked changed again when the entity gets a scene transform
+                    return;
+                }
+                batch.add(*static_cast<Transform2DComponent*>(transform), scene->m_local);
+            });
+            batch.flush();
         });
-}
 
-void Transform2DProcessor::recalcGlobalTransform(ComponentHolder<SceneTransform2DComponent>* holder, SceneTransform2DComponent& scene, Hierarchy& t)
-{
-    if (t.dirty) {
-        if (t.parent != 0) {
-            scene.m_global = holder->getComponent(t.parent)->m_global * scene.m_local;
-        }
-        else {
-            scene.m_global = scene.m_local;
+    // Update globalTransform of changed components, their children are updated with them.
+    // Each hierarchy level runs in parallel once the level above it is done, so the parent global is always up to date.
+    m_changedSlots.clear();
+    transforms->forEachChangedSince(since, [this](ComponentHandle t, void*) {
+        m_changedSlots.emplace_back(hierarchy.getSlot(t));
+    });
+    hierarchy.parallelUpdateSubtrees(getES()->getTaskManager(), m_changedSlots, GLOBAL_MATRIX_GRAIN_SIZE, [this, transforms, holder](ComponentHandle t, ComponentHandle parent) {
+        SceneTransform2DComponent* scene = getSceneTransform(transforms, holder, t);
+        if (scene == nullptr) {
+            return;
         }
 
-        t.dirty = false;
-
-        for (const ComponentHandle c : t.childs) {
-            hierarchy[c].dirty = true;
-            recalcGlobalTransform(holder, *(holder->getComponent(c)), hierarchy[c]);
+        const SceneTransform2DComponent* parentScene = parent != 0 ? getSceneTransform(transforms, holder, parent) : nullptr;
+        if (parentScene != nullptr) {
+            scene->m_global = parentScene->m_global * scene->m_local;
         }
-    }
+        else {
+            scene->m_global = scene->m_local;
+        }
+    });
 }
 }
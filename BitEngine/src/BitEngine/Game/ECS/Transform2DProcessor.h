@@ -2,6 +2,7 @@
 
 #include "BitEngine/Game/ECS/ComponentProcessor.h"
 #include "BitEngine/Game/ECS/Transform2DComponent.h"
+#include "BitEngine/Game/ECS/TransformHierarchy.h"
 
 #include "BitEngine/Common/MathUtils.h"
 
@@ -15,7 +16,10 @@ namespace BitEngine {
 	 **/
 class BE_API Transform2DProcessor : public ComponentProcessor,
                                     public Messenger<MsgComponentCreated<Transform2DComponent> >::ScopedSubscription,
-                                    public Messenger<MsgComponentDestroyed<Transform2DComponent> >::ScopedSubscription {
+                                    public Messenger<MsgComponentsCreated<Transform2DComponent> >::ScopedSubscription,
+                                    public Messenger<MsgComponentDestroyed<Transform2DComponent> >::ScopedSubscription,
+                                    public Messenger<MsgComponentCreated<SceneTransform2DComponent> >::ScopedSubscription,
+                                    public Messenger<MsgComponentsCreated<SceneTransform2DComponent> >::ScopedSubscription {
 public:
     Transform2DProcessor(EntitySystem* es);
     ~Transform2DProcessor();
@@ -54,7 +58,10 @@ public:
 
     // Message handling
     void onMessage(const MsgComponentCreated<Transform2DComponent>& msg);
+    void onMessage(const MsgComponentsCreated<Transform2DComponent>& msg);
     void onMessage(const MsgComponentDestroyed<Transform2DComponent>& msg);
+    void onMessage(const MsgComponentCreated<SceneTransform2DComponent>& msg);
+    void onMessage(const MsgComponentsCreated<SceneTransform2DComponent>& msg);
 
 protected:
     // Calculate the local model matrix for given Transform2DComponent
@@ -64,44 +71,16 @@ protected:
 private: // Functions
     void setParentOf(ComponentHandle a, ComponentHandle parent);
 
-    // Processor
-    struct Hierarchy {
-    public:
-        Hierarchy()
-            : dirty(true)
-        {
-            //self = 0;
-            parent = 0;
-        }
-
-        void removeChild(ComponentHandle a)
-        {
-            for (ComponentHandle& h : childs) {
-                if (h == a) {
-                    h = childs.back();
-                    childs.pop_back();
-                    break;
-                }
-            }
-        }
-
-        void addChild(ComponentHandle a)
-        {
-            childs.push_back(a);
-        }
-
-        // Members
-        //ComponentHandle self;
-        ComponentHandle parent;
-        bool dirty;
-        std::vector<ComponentHandle> childs;
-    };
+    // Transforms are skipped while their entity has no scene transform, recompute it once it has one
+    void markTransformChanged(EntityHandle entity);
 
-    // TODO: Make iterative version
-    void recalcGlobalTransform(ComponentHolder<SceneTransform2DComponent>* holder, SceneTransform2DComponent& scene, Hierarchy& t);
+    // Scene transform of the entity owning the given Transform2DComponent, null if it has none
+    SceneTransform2DComponent* getSceneTransform(ComponentHolder<Transform2DComponent>* transforms, ComponentHolder<SceneTransform2DComponent>* holder, ComponentHandle t);
 
 private: // Attributes
     // Processor
-    std::vector<Hierarchy> hierarchy;
+    TransformHierarchy hierarchy; // by Transform2DComponent handle
+    std::vector<u32> m_changedSlots; // hierarchy slots of the transforms changed since the last Process
+    u32 m_lastChangeVersion; // transforms changed after this version are processed next
 };
 }
@@ -11,7 +11,6 @@ Transform3DComponent::Transform3DComponent()
     , scale(1.0f, 1.0f, 1.0f)
     , rotation()
 {
-    m_dirty = false;
 }
 
 Transform3DComponent::~Transform3DComponent()
@@ -27,7 +26,7 @@ const glm::vec3& Transform3DComponent::getPosition() const
 void Transform3DComponent::setPosition(const glm::vec3& p)
 {
     position = p;
-    m_dirty = true;
+    markChanged();
 }
 
 // Scale
@@ -39,7 +38,7 @@ const glm::vec3& Transform3DComponent::getScale() const
 void Transform3DComponent::setScale(const glm::vec3& s)
 {
     scale = s;
-    m_dirty = true;
+    markChanged();
 }
 
 // Rotation
@@ -51,6 +50,6 @@ const glm::quat& Transform3DComponent::getRotation() const
 void Transform3DComponent::setRotation(const glm::quat& quat)
 {
     rotation = quat;
-    m_dirty = true;
+    markChanged();
 }
 }
@@ -8,7 +8,7 @@
 
 namespace BitEngine {
 
-class Transform3DComponent : public Component<Transform3DComponent> {
+class Transform3DComponent : public Component<Transform3DComponent>, public ChangeTrackedComponent {
 public:
     const static glm::vec3 FORWARD;
     const static glm::vec3 UP;
@@ -25,7 +25,7 @@ public:
         position.x = (float)x;
         position.y = (float)y;
         position.z = (float)z;
-        m_dirty = true;
+        markChanged();
     }
     void setPosition(const glm::vec3& p);
 
@@ -53,7 +53,5 @@ private:
     glm::vec3 position;
     glm::vec3 scale;
     glm::quat rotation;
-
-    bool m_dirty;
 };
 }
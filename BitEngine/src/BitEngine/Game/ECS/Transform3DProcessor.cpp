@@ -1,13 +1,76 @@
 #include "BitEngine/Game/ECS/Transform3DProcessor.h"
 #include "BitEngine/Game/ECS/EntitySystem.h"
+#include "BitEngine/Core/TransformKernels.h"
 #include <algorithm>
 
 namespace BitEngine {
 
+// Transforms per parallel chunk when computing local matrices
+static const u32 LOCAL_MATRIX_GRAIN_SIZE = 1024;
+// Transforms per parallel chunk of a hierarchy level when computing global matrices
+static const u32 GLOBAL_MATRIX_GRAIN_SIZE = 512;
+
+namespace {
+    // Collects transforms to compute their local matrices with the batch kernel
+    class LocalMatrixBatch3D {
+    public:
+        static const u32 SIZE = 64;
+
+        LocalMatrixBatch3D()
+            : m_count(0)
+        {
+        }
+
+        void add(const Transform3DComponent& comp, glm::mat4& mat)
+        {
+            const glm::vec3& position = comp.getPosition();
+            const glm::vec3& scale = comp.getScale();
+            const glm::quat& rotation = comp.getRotation();
+            m_px[m_count] = position.x;
+            m_py[m_count] = position.y;
+            m_pz[m_count] = position.z;
+            m_sx[m_count] = scale.x;
+            m_sy[m_count] = scale.y;
+            m_sz[m_count] = scale.z;
+            m_qx[m_count] = rotation.x;
+            m_qy[m_count] = rotation.y;
+            m_qz[m_count] = rotation.z;
+            m_qw[m_count] = rotation.w;
+            m_out[m_count] = &mat[0][0];
+
+            if (++m_count == SIZE) {
+                flush();
+            }
+        }
+
+        void flush()
+        {
+            TransformKernels::composeLocal3D({ m_px, m_py, m_pz, m_sx, m_sy, m_sz, m_qx, m_qy, m_qz, m_qw }, m_count, m_out);
+            m_count = 0;
+        }
+
+    private:
+        u32 m_count;
+        alignas(32) float m_px[SIZE];
+        alignas(32) float m_py[SIZE];
+        alignas(32) float m_pz[SIZE];
+        alignas(32) float m_sx[SIZE];
+        alignas(32) float m_sy[SIZE];
+        alignas(32) float m_sz[SIZE];
+        alignas(32) float m_qx[SIZE];
+        alignas(32) float m_qy[SIZE];
+        alignas(32) float m_qz[SIZE];
+        alignas(32) float m_qw[SIZE];
+        float* m_out[SIZE];
+    };
+}
+
 Transform3DProcessor::Transform3DProcessor(EntitySystem* m)
     : ComponentProcessor(m)
-    , Messenger<MsgComponentCreated<Transform3DComponent> >::ScopedSubscription(m->getHolder<Transform3DComponent>()->componentCreatedSignal, &Transform3DProcessor::onMessage, this)
-    , Messenger<MsgComponentDestroyed<Transform3DComponent> >::ScopedSubscription(m->getHolder<Transform3DComponent>()->componentDestroyedSignal, &Transform3DProcessor::onMessage, this)
+    , Messenger<MsgComponentCreated<Transform3DComponent> >::ScopedSubscription(m->getHolder<Transform3DComponent>()->componentCreatedSignal, Messenger<MsgComponentCreated<Transform3DComponent> >::bind<Transform3DProcessor, &Transform3DProcessor::onMessage>(this))
+    , Messenger<MsgComponentsCreated<Transform3DComponent> >::ScopedSubscription(m->getHolder<Transform3DComponent>()->componentsCreatedSignal, Messenger<MsgComponentsCreated<Transform3DComponent> >::bind<Transform3DProcessor, &Transform3DProcessor::onMessage>(this))
+    , Messenger<MsgComponentDestroyed<Transform3DComponent> >::ScopedSubscription(m->getHolder<Transform3DComponent>()->componentDestroyedSignal, Messenger<MsgComponentDestroyed<Transform3DComponent> >::bind<Transform3DProcessor, &Transform3DProcessor::onMessage>(this))
+    , m_lastChangeVersion(0)
 {
 }
 
@@ -17,9 +80,13 @@ Transform3DProcessor::~Transform3DProcessor()
 
 void Transform3DProcessor::CalculateLocalModelMatrix(const Transform3DComponent& comp, glm::mat4& mat)
 {
-    // T R S
-    // mat = glm::translate(glm::mat4(1), comp->position) * glm::mat4_cast(comp->rotation) * glm::scale(glm::mat4(1), comp->scale);
-    mat = glm::translate(glm::mat4_cast(comp.rotation) * glm::scale(glm::mat4(1), comp.scale), comp.position);
+    // Same as glm::translate(glm::mat4_cast(comp.rotation) * glm::scale(glm::mat4(1), comp.scale), comp.position)
+    // A single transform takes the scalar path of the kernel
+    const glm::vec3& position = comp.getPosition();
+    const glm::vec3& scale = comp.getScale();
+    const glm::quat& rotation = comp.getRotation();
+    float* out = &mat[0][0];
+    TransformKernels::composeLocal3D({ &position.x, &position.y, &position.z, &scale.x, &scale.y, &scale.z, &rotation.x, &rotation.y, &rotation.z, &rotation.w }, 1, &out);
 }
 
 void Transform3DProcessor::onMessage(const MsgComponentCreated<Transform3DComponent>& msg)
@@ -29,70 +96,72 @@ void Transform3DProcessor::onMessage(const MsgComponentCreated<Transform3DCompon
     if (localTransform.size() <= nComponents) {
         localTransform.resize(nComponents + 1);
         globalTransform.resize(nComponents + 1);
-        hierarchy.resize(nComponents + 1);
+    }
+    hierarchy.add(msg.component);
+}
+
+void Transform3DProcessor::onMessage(const MsgComponentsCreated<Transform3DComponent>& msg)
+{
+    const u32 nComponents = *std::max_element(msg.components, msg.components + msg.count);
+
+    if (localTransform.size() <= nComponents) {
+        localTransform.resize(nComponents + 1);
+        globalTransform.resize(nComponents + 1);
+    }
+    for (u32 i = 0; i < msg.count; ++i) {
+        hierarchy.add(msg.components[i]);
     }
 }
 
 void Transform3DProcessor::onMessage(const MsgComponentDestroyed<Transform3DComponent>& msg)
 {
     // Childs lost their parent. Let them to the previous parent root.
-    for (ComponentHandle c : hierarchy[msg.component].childs) {
-        setParentOf(c, hierarchy[msg.component].parent);
-    }
+    ComponentHolder<Transform3DComponent>* holder = getES()->getHolder<Transform3DComponent>();
+    hierarchy.forEachChild(msg.component, [holder](ComponentHandle c) {
+        holder->markChanged(c);
+    });
+    hierarchy.remove(msg.component);
 }
 
 void Transform3DProcessor::Process()
 {
     BE_PROFILE_FUNCTION();
-    // Recalculate localTransform
-    //for (ComponentHandle c : components.getValidComponents())
-    getES()->forAll<Transform3DProcessor, Transform3DComponent>(*this,
-        [](Transform3DProcessor& self, ComponentHandle c, Transform3DComponent& transform) {
-            if (transform.m_dirty) {
-                transform.m_dirty = false;
-                CalculateLocalModelMatrix(transform, self.localTransform[c]);
-                self.hierarchy[c].dirty = true;
-            }
-        });
-
-    // Update globalTransform of valid components
-    getES()->forAll<Transform3DProcessor, Transform3DComponent>(*this,
-        [](Transform3DProcessor& self, ComponentHandle c, Transform3DComponent& transform) {
-            self.recalcGlobalTransform(c, self.hierarchy[c]);
+    ComponentHolder<Transform3DComponent>* holder = getES()->getHolder<Transform3DComponent>();
+    const u32 since = m_lastChangeVersion;
+    m_lastChangeVersion = holder->advanceChangeVersion();
+
+    // Recalculate localTransform of changed components
+    // Each call only touches its own component and slots, so this can run in parallel
+    const u32 blockGrain = std::max(LOCAL_MATRIX_GRAIN_SIZE / holder->getChangeBlockSize(), 1u);
+    parallelForRange(getES()->getTaskManager(), holder->getChangeBlockCount(), blockGrain,
+        [this, holder, since](u32 first, u32 last) {
+            LocalMatrixBatch3D batch;
+            holder->forEachChangedSinceInRange(since, first, last, [this, &batch](ComponentHandle c, void* transform) {
+                batch.add(*static_cast<Transform3DComponent*>(transform), localTransform[c]);
+            });
+            batch.flush();
         });
-}
 
-void Transform3DProcessor::recalcGlobalTransform(ComponentHandle handle, Hierarchy& t)
-{
-    if (t.dirty) {
-        if (t.parent != 0)
-            globalTransform[handle] = globalTransform[t.parent] * localTransform[handle];
+    // Update globalTransform of changed components, their children are updated with them.
+    // Each hierarchy level runs in parallel once the level above it is done, so the parent global is always up to date.
+    m_changedSlots.clear();
+    holder->forEachChangedSince(since, [this](ComponentHandle c, void*) {
+        m_changedSlots.emplace_back(hierarchy.getSlot(c));
+    });
+    hierarchy.parallelUpdateSubtrees(getES()->getTaskManager(), m_changedSlots, GLOBAL_MATRIX_GRAIN_SIZE, [this](ComponentHandle c, ComponentHandle parent) {
+        if (parent != 0)
+            TransformKernels::multiply4x4(&globalTransform[parent][0][0], &localTransform[c][0][0], &globalTransform[c][0][0]);
         else
-            globalTransform[handle] = localTransform[handle];
-
-        t.dirty = false;
-
-        for (const ComponentHandle c : t.childs) {
-            hierarchy[c].dirty = true;
-            recalcGlobalTransform(c, hierarchy[c]);
-        }
-    }
+            globalTransform[c] = localTransform[c];
+    });
 }
 
 void Transform3DProcessor::setParentOf(ComponentHandle a, ComponentHandle parent)
 {
-    const ComponentHandle prevParent = hierarchy[a].parent;
-    if (prevParent == parent)
+    if (hierarchy.getParent(a) == parent)
         return;
 
-    // Remove child from previous parent
-    hierarchy[prevParent].removeChild(a);
-
-    // Set parent for given component
-    hierarchy[a].parent = parent;
-    hierarchy[a].dirty = true;
-
-    // Add child for new parent
-    hierarchy[parent].addChild(a);
+    hierarchy.setParent(a, parent);
+    getES()->getHolder<Transform3DComponent>()->markChanged(a);
 }
 }
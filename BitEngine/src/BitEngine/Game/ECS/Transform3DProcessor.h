@@ -2,6 +2,7 @@
 
 #include "BitEngine/Game/ECS/ComponentProcessor.h"
 #include "BitEngine/Game/ECS/Transform3DComponent.h"
+#include "BitEngine/Game/ECS/TransformHierarchy.h"
 
 namespace BitEngine {
 
@@ -10,6 +11,7 @@ namespace BitEngine {
  */
 class BE_API Transform3DProcessor : public ComponentProcessor,
                                     public Messenger<MsgComponentCreated<Transform3DComponent> >::ScopedSubscription,
+                                    public Messenger<MsgComponentsCreated<Transform3DComponent> >::ScopedSubscription,
                                     public Messenger<MsgComponentDestroyed<Transform3DComponent> >::ScopedSubscription {
 public:
     Transform3DProcessor(EntitySystem* m);
@@ -36,49 +38,20 @@ public:
 
     // Message handlers
     void onMessage(const MsgComponentCreated<Transform3DComponent>& msg);
+    void onMessage(const MsgComponentsCreated<Transform3DComponent>& msg);
     void onMessage(const MsgComponentDestroyed<Transform3DComponent>& msg);
 
 private: // Functions
-    struct Hierarchy;
     static void CalculateLocalModelMatrix(const Transform3DComponent& component, glm::mat4& mat);
 
-    // TODO: Make iterative version
-    void recalcGlobalTransform(ComponentHandle handle, Hierarchy& t);
-
     void setParentOf(ComponentHandle a, ComponentHandle parent);
 
-    struct Hierarchy {
-        Hierarchy()
-            : dirty(true)
-        {
-            parent = 0;
-        }
-
-        void removeChild(ComponentHandle a)
-        {
-            for (ComponentHandle& h : childs) {
-                if (h == a) {
-                    h = childs.back();
-                    childs.pop_back();
-                    break;
-                }
-            }
-        }
-
-        void addChild(ComponentHandle a)
-        {
-            childs.push_back(a);
-        }
-
-        ComponentHandle parent;
-        bool dirty;
-        std::vector<ComponentHandle> childs;
-    };
-
 private: // Attributes
     // Processor
-    std::vector<Hierarchy> hierarchy;
+    TransformHierarchy hierarchy;
+    std::vector<u32> m_changedSlots; // hierarchy slots of the transforms changed since the last Process
     std::vector<glm::mat4> localTransform; // used only to calculate globalTransform
     std::vector<glm::mat4> globalTransform; // information used by external systems
+    u32 m_lastChangeVersion; // transforms changed after this version are processed next
 };
 }
@@ -0,0 +1,171 @@
+#include "BitEngine/Game/ECS/TransformHierarchy.h"
+
+#include "BitEngine/Core/Assert.h"
+
+namespace BitEngine {
+
+TransformHierarchy::TransformHierarchy()
+    : m_removedCount(0)
+{
+}
+
+void TransformHierarchy::add(ComponentHandle node)
+{
+    BE_ASSERT(node != 0 && !contains(node));
+    if (m_slots.size() <= node) {
+        m_slots.resize(node + 1, NO_SLOT);
+    }
+
+    m_slots[node] = static_cast<u32>(m_nodes.size());
+    m_nodes.emplace_back(Node{ node, 0, 1, 0 });
+}
+
+void TransformHierarchy::remove(ComponentHandle node)
+{
+    const u32 slot = m_slots[node];
+    const ComponentHandle parent = m_nodes[slot].parent;
+
+    // Children stay where they are, they are already inside the parent range.
+    // The node is left as a placeholder of size 1 so no subtree size changes.
+    forEachChild(node, [this, parent](ComponentHandle child) {
+        m_nodes[m_slots[child]].parent = parent;
+    });
+    for (u32 i = slot + 1; i < slot + m_nodes[slot].subtreeSize; ++i) {
+        --m_nodes[i].depth;
+    }
+    m_nodes[slot] = Node{ 0, parent, 1, m_nodes[slot].depth };
+    m_slots[node] = NO_SLOT;
+    ++m_removedCount;
+
+    if (m_removedCount * 2 > m_nodes.size()) {
+        compact();
+    }
+}
+
+void TransformHierarchy::setParent(ComponentHandle node, ComponentHandle parent)
+{
+    const u32 slot = m_slots[node];
+    const ComponentHandle prevParent = m_nodes[slot].parent;
+    if (prevParent == parent) {
+        return;
+    }
+
+    const u32 count = m_nodes[slot].subtreeSize;
+    BE_ASSERT(parent == 0 || m_slots[parent] < slot || m_slots[parent] >= slot + count);
+
+    // The subtree goes right after the last node below the new parent
+    const u32 target = (parent == 0) ? static_cast<u32>(m_nodes.size()) : m_slots[parent] + m_nodes[m_slots[parent]].subtreeSize;
+
+    u32 first, last;
+    if (target > slot) {
+        std::rotate(m_nodes.begin() + slot, m_nodes.begin() + slot + count, m_nodes.begin() + target);
+        first = slot;
+        last = target;
+    }
+    else {
+        std::rotate(m_nodes.begin() + target, m_nodes.begin() + slot, m_nodes.begin() + slot + count);
+        first = target;
+        last = slot + count;
+    }
+
+    for (u32 i = first; i < last; ++i) {
+        if (m_nodes[i].node != 0) {
+            m_slots[m_nodes[i].node] = i;
+        }
+    }
+
+    const u32 newSlot = m_slots[node];
+    const u32 depth = (parent == 0) ? 0 : m_nodes[m_slots[parent]].depth + 1;
+    m_nodes[newSlot].parent = parent;
+    addToDepth(newSlot, static_cast<s32>(depth) - static_cast<s32>(m_nodes[newSlot].depth));
+    addToAncestors(prevParent, -static_cast<s32>(count));
+    addToAncestors(parent, static_cast<s32>(count));
+}
+
+void TransformHierarchy::addToDepth(u32 slot, s32 delta)
+{
+    if (delta == 0) {
+        return;
+    }
+
+    const u32 end = slot + m_nodes[slot].subtreeSize;
+    for (u32 i = slot; i < end; ++i) {
+        m_nodes[i].depth += delta;
+    }
+}
+
+void TransformHierarchy::addToAncestors(ComponentHandle parent, s32 delta)
+{
+    while (parent != 0) {
+        Node& n = m_nodes[m_slots[parent]];
+        n.subtreeSize += delta;
+        parent = n.parent;
+    }
+}
+
+void TransformHierarchy::compact()
+{
+    // removedBefore[i] = removed nodes in [0, i)
+    std::vector<u32> removedBefore(m_nodes.size() + 1);
+    removedBefore[0] = 0;
+    for (u32 i = 0; i < m_nodes.size(); ++i) {
+        removedBefore[i + 1] = removedBefore[i] + (m_nodes[i].node == 0 ? 1 : 0);
+    }
+
+    u32 out = 0;
+    for (u32 i = 0; i < m_nodes.size(); ++i) {
+        Node n = m_nodes[i];
+        if (n.node == 0) {
+            continue;
+        }
+
+        n.subtreeSize -= removedBefore[i + n.subtreeSize] - removedBefore[i];
+        m_nodes[out] = n;
+        m_slots[n.node] = out;
+        ++out;
+    }
+
+    m_nodes.resize(out);
+    m_removedCount = 0;
+}
+
+u32 TransformHierarchy::collectLevels(std::vector<u32>& slots)
+{
+    for (std::vector<LevelNode>& level : m_levels) {
+        level.clear();
+    }
+
+    // Same walk as updateSubtrees. Parents outside the updated subtrees are already done,
+    // so levels are relative to the root of each updated subtree.
+    std::sort(slots.begin(), slots.end());
+
+    u32 levelCount = 0;
+    u32 coveredEnd = 0;
+    for (const u32 slot : slots) {
+        if (slot == NO_SLOT) {
+            break;
+        }
+        if (slot < coveredEnd) {
+            continue;
+        }
+
+        coveredEnd = slot + m_nodes[slot].subtreeSize;
+        const u32 rootDepth = m_nodes[slot].depth;
+        for (u32 i = slot; i < coveredEnd; ++i) {
+            const Node& n = m_nodes[i];
+            if (n.node == 0) {
+                continue;
+            }
+
+            const u32 level = n.depth - rootDepth;
+            if (level >= m_levels.size()) {
+                m_levels.resize(level + 1);
+            }
+            m_levels[level].emplace_back(LevelNode{ n.node, n.parent });
+            levelCount = std::max(levelCount, level + 1);
+        }
+    }
+
+    return levelCount;
+}
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "BitEngine/Core/api.h"
+#include "BitEngine/Core/ParallelFor.h"
+#include "BitEngine/Game/ECS/Component.h"
+
+namespace BitEngine {
+
+/**
+ * Parent/child relations of transform components, kept flat.
+ * Nodes are stored in a single array in depth first order: every parent comes before
+ * its children and every subtree is a contiguous range, so global transforms are
+ * computed with a linear pass instead of recursion.
+ * Reparenting moves the subtree range inside the array, nothing is rebuilt.
+ * Each node also knows its depth, so updates can run one depth level at a time in parallel.
+ * Nodes are identified by their component handle, 0 is the root of everything.
+ */
+class BE_API TransformHierarchy {
+public:
+    static constexpr u32 NO_SLOT = ~0u;
+
+    TransformHierarchy();
+
+    // Add a node without parent, at the end of the order
+    void add(ComponentHandle node);
+
+    // Remove node, its children are moved to its parent
+    void remove(ComponentHandle node);
+
+    // Make node a child of parent, 0 makes it a root
+    // parent must not be below node
+    void setParent(ComponentHandle node, ComponentHandle parent);
+
+    ComponentHandle getParent(ComponentHandle node) const
+    {
+        return m_nodes[m_slots[node]].parent;
+    }
+
+    // Number of ancestors of node, 0 for roots
+    u32 getDepth(ComponentHandle node) const
+    {
+        return m_nodes[m_slots[node]].depth;
+    }
+
+    bool contains(ComponentHandle node) const
+    {
+        return node < m_slots.size() && m_slots[node] != NO_SLOT;
+    }
+
+    // Position of node in the update order, NO_SLOT if it's not in the hierarchy
+    u32 getSlot(ComponentHandle node) const
+    {
+        return contains(node) ? m_slots[node] : NO_SLOT;
+    }
+
+    // f signature: void(ComponentHandle child)
+    template <typename Func>
+    void forEachChild(ComponentHandle node, Func&& f) const
+    {
+        const u32 slot = m_slots[node];
+        const u32 end = slot + m_nodes[slot].subtreeSize;
+        for (u32 i = slot + 1; i < end; i += m_nodes[i].subtreeSize) {
+            // Removed nodes have size 1, their children were given to node and follow them
+            if (m_nodes[i].node != 0) {
+                f(m_nodes[i].node);
+            }
+        }
+    }
+
+    /**
+     * Visit the nodes at the given slots and every node below them, once each,
+     * parents always before their children.
+     * slots is sorted in place, NO_SLOT entries are ignored.
+     * f signature: void(ComponentHandle node, ComponentHandle parent)
+     */
+    template <typename Func>
+    void updateSubtrees(std::vector<u32>& slots, Func&& f) const
+    {
+        std::sort(slots.begin(), slots.end());
+
+        u32 coveredEnd = 0;
+        for (const u32 slot : slots) {
+            if (slot == NO_SLOT) {
+                break;
+            }
+            if (slot < coveredEnd) {
+                continue; // already updated with an ancestor
+            }
+
+            coveredEnd = slot + m_nodes[slot].subtreeSize;
+            for (u32 i = slot; i < coveredEnd; ++i) {
+                const Node& n = m_nodes[i];
+                if (n.node != 0) {
+                    f(n.node, n.parent);
+                }
+            }
+        }
+    }
+
+    /**
+     * Parallel version of updateSubtrees.
+     * The visited nodes are grouped by depth, each level is split in chunks of grainSize nodes
+     * that run on the task manager workers, and a level only starts after the level above is done.
+     * f is called concurrently for nodes of the same level: it may read the data of the parent
+     * and must only write the data of the node it receives.
+     */
+    template <typename Func>
+    void parallelUpdateSubtrees(TaskManager* taskManager, std::vector<u32>& slots, u32 grainSize, Func&& f)
+    {
+        if (taskManager == nullptr || taskManager->getWorkerCount() == 0) {
+            updateSubtrees(slots, f);
+            return;
+        }
+
+        const u32 levelCount = collectLevels(slots);
+        for (u32 d = 0; d < levelCount; ++d) {
+            const std::vector<LevelNode>& level = m_levels[d];
+            parallelForRange(taskManager, static_cast<u32>(level.size()), grainSize, [&level, &f](u32 first, u32 last) {
+                for (u32 i = first; i < last; ++i) {
+                    f(level[i].node, level[i].parent);
+                }
+            });
+        }
+    }
+
+    // Number of nodes in the hierarchy
+    u32 size() const { return static_cast<u32>(m_nodes.size()) - m_removedCount; }
+
+private:
+    struct Node {
+        ComponentHandle node; // 0 for removed nodes, they are dropped on the next compact()
+        ComponentHandle parent;
+        u32 subtreeSize; // this node and all nodes below it
+        u32 depth;
+    };
+
+    struct LevelNode {
+        ComponentHandle node;
+        ComponentHandle parent;
+    };
+
+    // Add delta to the subtree size of parent and all its ancestors
+    void addToAncestors(ComponentHandle parent, s32 delta);
+
+    // Add delta to the depth of every node in the subtree range starting at slot
+    void addToDepth(u32 slot, s32 delta);
+
+    // Drop removed nodes from the order
+    void compact();
+
+    // Fill m_levels with the nodes updateSubtrees would visit, by depth relative to
+    // the updated subtree root. Returns the number of levels used.
+    u32 collectLevels(std::vector<u32>& slots);
+
+    std::vector<Node> m_nodes; // depth first order
+    std::vector<u32> m_slots; // component handle -> position in m_nodes
+    u32 m_removedCount;
+    std::vector<std::vector<LevelNode> > m_levels; // kept between updates to reuse the memory
+};
+}
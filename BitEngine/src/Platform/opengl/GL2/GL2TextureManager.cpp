@@ -7,6 +7,7 @@
 #include "BitEngine/Common/MathUtils.h"
 #include "BitEngine/Core/Logger.h"
 #include "BitEngine/Core/TaskManager.h"
+#include "BitEngine/Core/TaskSequence.h"
 #include "BitEngine/Core/Assert.h"
 
 #include "Platform/opengl/GL2/GL2TextureManager.h"
@@ -61,69 +62,92 @@ void releaseStbiData(StbiImageData& data)
     data.pixelData = nullptr;
 }
 
-class TextureUploadToGPU : public Task {
+// Steps loading a texture, run in order by a TaskSequence
+class TextureUploadToGPU {
 public:
-    TextureUploadToGPU(GL2TextureManager* tm, GL2Texture* tex, StbiImageData data)
-        : Task(Task::TaskMode::REPEATING, Task::Affinity::MAIN)
-        , state(UploadState::CREATE_BUFFERS)
-        , textureManager(tm)
+    TextureUploadToGPU(GL2TextureManager* tm, GL2Texture* tex, ResourceLoader::RawResourceTask data)
+        : textureManager(tm)
         , texture(tex)
         , pbo(0)
         , storage(0)
-        , imageData(data)
+        , textureData(data)
+        , textureID(0)
     {
-        textureID = tex->m_textureID;
     }
 
-    void run() override
+    // Background, returns false when the texture can't be loaded
+    bool decode()
     {
         BE_PROFILE_FUNCTION();
-        const u32 size = imageData.width * imageData.height * imageData.color;
-        switch (state) {
-        case UploadState::CREATE_BUFFERS: // On Main thread
-        {
-            BE_PROFILE_SCOPE("UploadState::CREATE_BUFFERS");
-            if (texture->m_textureID == textureManager->getErrorTexture()->m_textureID) {
-                glGenTextures(1, &textureID);
-                glBindTexture(GL_TEXTURE_2D, textureID);
-                GL_CHECK(glGenerateMipmap(GL_TEXTURE_2D));
-                GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-                GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
-                GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-                GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
-                GL_CHECK(glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, imageData.width, imageData.height));
-                GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
-            }
-            glGenBuffers(1, &pbo);
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
-            GL_CHECK(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW));
-            GL_CHECK(storage = (GLubyte*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-            state = UploadState::COPYING_DATA;
-            setAffinity(Task::Affinity::BACKGROUND); // Next time will be executed as a background task
-            textureManager->addRamUsage(size);
-        } break;
-
-        case UploadState::COPYING_DATA: {
-            BE_PROFILE_SCOPE("UploadState::COPYING_DATA");
-            // Copy data to buffer in background
-            std::memcpy(storage, imageData.pixelData, size);
-            state = UploadState::FINISHING;
-            releaseStbiData(imageData);
-            setAffinity(Task::Affinity::MAIN);
-        } break;
-        case UploadState::FINISHING: // ON Main thread
+        ResourceLoader::DataRequest& dr = textureData->getData();
+        if (!dr.isLoaded()) {
+            LOG(BitEngine::EngineLog, BE_LOG_ERROR) << "Resource meta " << texture->getMeta()->getNameId() << " on state: " << dr.loadState;
+            return false;
+        }
+
         {
-            BE_PROFILE_SCOPE("UploadState::FINISHING");
-            textureManager->addRamUsage(-(s32)size); // We wait until we're on main thread to avoid concurrency issues
-            bindTextureDataUsingPBO();
-            stopRepeating();
-            textureManager->addGpuUsage(size); // TODO: Reduce gpu usage on unload.
-        } break;
+            BE_PROFILE_SCOPE("stbi_load");
+            imageData.pixelData = stbi_load_from_memory((unsigned char*)dr.data, dr.size, &imageData.width, &imageData.height, &imageData.color, 0);
         }
+
+        if (imageData.pixelData == nullptr) {
+            LOG(BitEngine::EngineLog, BE_LOG_ERROR) << "stbi failed to load texture: " << texture->getMeta()->getNameId() << " reason: " << stbi_failure_reason();
+            return false;
+        }
+
+        LOG(BitEngine::EngineLog, BE_LOG_VERBOSE) << "stbi loaded texture: " << texture->getMeta()->getNameId() << " w: " << imageData.width << " h: " << imageData.height;
+        textureID = texture->m_textureID;
+        return true;
+    }
+
+    // Main thread
+    void createBuffers()
+    {
+        BE_PROFILE_FUNCTION();
+        const u32 size = getSize();
+        if (texture->m_textureID == textureManager->getErrorTexture()->m_textureID) {
+            glGenTextures(1, &textureID);
+            glBindTexture(GL_TEXTURE_2D, textureID);
+            GL_CHECK(glGenerateMipmap(GL_TEXTURE_2D));
+            GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+            GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+            GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+            GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+            GL_CHECK(glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, imageData.width, imageData.height));
+            GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+        }
+        glGenBuffers(1, &pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        GL_CHECK(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW));
+        GL_CHECK(storage = (GLubyte*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        textureManager->addRamUsage(size);
+    }
+
+    // Background
+    void copyData()
+    {
+        BE_PROFILE_FUNCTION();
+        std::memcpy(storage, imageData.pixelData, getSize());
+        releaseStbiData(imageData);
+    }
+
+    // Main thread
+    void finish()
+    {
+        BE_PROFILE_FUNCTION();
+        const u32 size = getSize();
+        textureManager->addRamUsage(-(s32)size); // We wait until we're on main thread to avoid concurrency issues
+        bindTextureDataUsingPBO();
+        textureManager->addGpuUsage(size); // TODO: Reduce gpu usage on unload.
     }
 
 private:
+    u32 getSize() const
+    {
+        return imageData.width * imageData.height * imageData.color;
+    }
+
     GLenum stbiColorToGLEnum(int color)
     {
         switch (color) {
@@ -199,62 +223,15 @@ private:
     }
 
 private:
-    enum class UploadState {
-        CREATE_BUFFERS,
-        COPYING_DATA,
-        FINISHING,
-    };
-    UploadState state;
     GL2TextureManager* textureManager;
     GL2Texture* texture;
     GLuint pbo;
     GLubyte* storage;
+    ResourceLoader::RawResourceTask textureData;
     StbiImageData imageData;
     GLuint textureID;
 };
 
-// TODO: Possibly merge this with above task as a new state?
-class RawTextureLoader : public Task {
-public:
-    RawTextureLoader(GL2TextureManager* _manager, GL2Texture* _texture, ResourceLoader::RawResourceTask data)
-        : Task(Task::TaskMode::NONE, Task::Affinity::BACKGROUND)
-        , manager(_manager)
-        , texture(_texture)
-        , textureData(data)
-    {
-    }
-
-    // Inherited via Task
-    virtual void run() override
-    {
-
-        ResourceLoader::DataRequest& dr = textureData->getData();
-        if (dr.isLoaded()) {
-            StbiImageData imgData;
-            {
-                BE_PROFILE_SCOPE("stbi_load");
-                imgData.pixelData = stbi_load_from_memory((unsigned char*)dr.data, dr.size, &imgData.width, &imgData.height, &imgData.color, 0);
-            }
-
-            if (imgData.pixelData != nullptr) {
-                LOG(BitEngine::EngineLog, BE_LOG_VERBOSE) << "stbi loaded texture: " << texture->getMeta()->getNameId() << " w: " << imgData.width << " h: " << imgData.height;
-                manager->getTaskManager()->addTask(std::make_shared<TextureUploadToGPU>(manager, texture, imgData));
-            }
-            else {
-                LOG(BitEngine::EngineLog, BE_LOG_ERROR) << "stbi failed to load texture: " << texture->getMeta()->getNameId() << " reason: " << stbi_failure_reason();
-            }
-        }
-        else {
-            LOG(BitEngine::EngineLog, BE_LOG_ERROR) << "Resource meta " << texture->getMeta()->getNameId() << " on state: " << dr.loadState;
-        }
-    }
-
-private:
-    GL2TextureManager* manager;
-    GL2Texture* texture;
-    ResourceLoader::RawResourceTask textureData;
-};
-
 //
 
 GL2TextureManager::GL2TextureManager(TaskManager* tm)
@@ -330,9 +307,16 @@ void GL2TextureManager::scheduleLoadingTasks(ResourceMeta* meta, GL2Texture* tex
     BE_PROFILE_FUNCTION();
     texture->m_loaded = GL2Texture::TextureLoadState::LOADING;
     ResourceLoader::RawResourceTask rawDataTask = loader->requestResourceData(meta);
-    TaskPtr textureLoader = std::make_shared<RawTextureLoader>(this, texture, rawDataTask);
-    textureLoader->addDependency(rawDataTask);
-    taskManager->addTask(textureLoader);
+    auto upload = std::make_shared<TextureUploadToGPU>(this, texture, rawDataTask);
+    // Streaming: the GPU steps use what is left of the frame budget, a texture may take
+    // a few frames to show up instead of making a frame slow
+    TaskSequence(taskManager, Task::Priority::IDLE)
+        .after(rawDataTask)
+        .then(Task::Affinity::BACKGROUND, [upload]() { return upload->decode(); })
+        .then(Task::Affinity::MAIN, [upload]() { upload->createBuffers(); })
+        .then(Task::Affinity::BACKGROUND, [upload]() { upload->copyData(); })
+        .then(Task::Affinity::MAIN, [upload]() { upload->finish(); })
+        .submit();
 }
 
 BaseResource* GL2TextureManager::loadResource(ResourceMeta* meta, PropertyHolder* props)
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <BitEngine/Common/TypeDefinition.h>
+#include <BitEngine/Core/Timer.h>
+
+/**
+ * Minimal benchmark registry.
+ * BE_BENCHMARK(Group, Name) { ... } registers a function that is run by benchmarks/main.cpp.
+ * Use Benchmark::measure to time the interesting part and Benchmark::report to print it.
+ */
+namespace Benchmark {
+
+struct Entry {
+    std::string name;
+    std::function<void()> run;
+};
+
+inline std::vector<Entry>& Registry()
+{
+    static std::vector<Entry> entries;
+    return entries;
+}
+
+struct Register {
+    Register(const char* name, std::function<void()> f)
+    {
+        Registry().emplace_back(Entry{ name, f });
+    }
+};
+
+// Prevents the optimizer from removing the computation that produced value
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile(""
+                 :
+                 : "g"(&value)
+                 : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Run f iterations times, returns the best time in milliseconds
+template <typename Func>
+double measure(u32 iterations, Func&& f)
+{
+    double best = 0;
+    for (u32 i = 0; i < iterations; ++i) {
+        BitEngine::Timer timer;
+        f();
+        const double elapsed = timer.timeElapsedMs<double>();
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+void report(const std::string& name, u32 elements, double ms);
+}
+
+#define BE_BENCHMARK(group, name)                                                               \
+    static void benchmark_##group##_##name();                                                   \
+    static Benchmark::Register register_##group##_##name(#group "." #name, benchmark_##group##_##name); \
+    static void benchmark_##group##_##name()
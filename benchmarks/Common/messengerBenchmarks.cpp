@@ -0,0 +1,132 @@
+#include <functional>
+#include <vector>
+
+#include <BitEngine/Core/EventBus.h>
+#include <BitEngine/Core/Messenger.h>
+
+#include "Benchmark.h"
+
+using namespace BitEngine;
+
+namespace {
+const u32 ITERATIONS = 10;
+const u32 MESSAGES = 1000000;
+
+struct MsgValue {
+    u32 value;
+};
+
+class Receiver {
+public:
+    void onMessage(const MsgValue& msg) { total += msg.value; }
+
+    u64 total = 0;
+};
+}
+
+// One subscriber, what every component creation pays per message.
+// doNotOptimize keeps the compiler from seeing through the callbacks, like it can't across
+// translation units. Emitting also used to push a profiler event, not counted here.
+BE_BENCHMARK(Messenger, Emit)
+{
+    Receiver receiver;
+
+    // What emit did before: std::function wrapping a std::function wrapping the member call
+    {
+        std::function<void(const MsgValue&)> inner = [&receiver](const MsgValue& msg) { receiver.onMessage(msg); };
+        std::function<void(const MsgValue&)> outer = [inner](const MsgValue& msg) { inner(msg); };
+        std::vector<std::function<void(const MsgValue&)> > subscribers = { outer };
+        const double ms = Benchmark::measure(ITERATIONS, [&]() {
+            for (u32 i = 0; i < MESSAGES; ++i) {
+                for (auto& s : subscribers) {
+                    s({ i });
+                }
+                Benchmark::doNotOptimize(subscribers);
+            }
+        });
+        Benchmark::report("two std::function hops", MESSAGES, ms);
+    }
+
+    {
+        Messenger<MsgValue> messenger;
+        messenger.subscribe(&Receiver::onMessage, &receiver);
+        const double ms = Benchmark::measure(ITERATIONS, [&]() {
+            for (u32 i = 0; i < MESSAGES; ++i) {
+                messenger.emit({ i });
+                Benchmark::doNotOptimize(messenger);
+            }
+        });
+        Benchmark::report("emit, member function pointer", MESSAGES, ms);
+    }
+
+    {
+        Messenger<MsgValue> messenger;
+        messenger.subscribe<Receiver, &Receiver::onMessage>(&receiver);
+        const double ms = Benchmark::measure(ITERATIONS, [&]() {
+            for (u32 i = 0; i < MESSAGES; ++i) {
+                messenger.emit({ i });
+                Benchmark::doNotOptimize(messenger);
+            }
+        });
+        Benchmark::report("emit, compile time member function", MESSAGES, ms);
+    }
+    Benchmark::doNotOptimize(receiver.total);
+}
+
+// Deferred events: post a frame worth of events, then deliver them at the sync point
+BE_BENCHMARK(Messenger, Deferred)
+{
+    Receiver receiver;
+
+    {
+        Messenger<MsgValue> messenger;
+        messenger.subscribe<Receiver, &Receiver::onMessage>(&receiver);
+        const double ms = Benchmark::measure(ITERATIONS, [&]() {
+            for (u32 i = 0; i < MESSAGES; ++i) {
+                messenger.enqueue({ i });
+            }
+            messenger.dispatch();
+        });
+        Benchmark::report("messenger enqueue + dispatch", MESSAGES, ms);
+    }
+
+    {
+        EventBus bus;
+        bus.subscribe<MsgValue>(EventBus::Callback<MsgValue>::bind<Receiver, &Receiver::onMessage>(&receiver));
+        const double ms = Benchmark::measure(ITERATIONS, [&]() {
+            for (u32 i = 0; i < MESSAGES; ++i) {
+                bus.post(MsgValue{ i });
+            }
+            bus.dispatchAll();
+        });
+        Benchmark::report("event bus post + dispatchAll", MESSAGES, ms);
+    }
+
+    {
+        EventBus bus;
+        bus.subscribeBatch<MsgValue>([&receiver](const MsgValue* events, ptrsize count) {
+            for (ptrsize i = 0; i < count; ++i) {
+                receiver.onMessage(events[i]);
+            }
+        });
+        const double ms = Benchmark::measure(ITERATIONS, [&]() {
+            for (u32 i = 0; i < MESSAGES; ++i) {
+                bus.post(MsgValue{ i });
+            }
+            bus.dispatchAll();
+        });
+        Benchmark::report("event bus post + batch subscriber", MESSAGES, ms);
+
+        const double posterMs = Benchmark::measure(ITERATIONS, [&]() {
+            {
+                EventBus::Poster poster(bus);
+                for (u32 i = 0; i < MESSAGES; ++i) {
+                    poster.post(MsgValue{ i });
+                }
+            }
+            bus.dispatchAll();
+        });
+        Benchmark::report("event bus poster + batch subscriber", MESSAGES, posterMs);
+    }
+    Benchmark::doNotOptimize(receiver.total);
+}
@@ -0,0 +1,82 @@
+#include <thread>
+#include <vector>
+
+#include <BitEngine/Common/RingQueue.h>
+#include <BitEngine/Common/TypeDefinition.h>
+#include <BitEngine/Common/ThreadSafeQueue.h>
+
+#include "Benchmark.h"
+
+using namespace BitEngine;
+
+namespace {
+const u32 ITERATIONS = 5;
+const u32 ITEMS = 200000;
+
+// Producers push ITEMS in total while the calling thread pops them all
+template <typename Queue>
+double producersToConsumer(Queue& queue, u32 producers)
+{
+    return Benchmark::measure(ITERATIONS, [&]() {
+        std::vector<std::thread> threads;
+        for (u32 p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, producers]() {
+                for (u32 i = 0; i < ITEMS / producers; ++i) {
+                    while (!queue.push(i)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        u32 value;
+        u64 sum = 0;
+        for (u32 i = 0; i < ITEMS / producers * producers;) {
+            if (queue.tryPop(value)) {
+                sum += value;
+                ++i;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+        Benchmark::doNotOptimize(sum);
+    });
+}
+
+// Same surface as the ring queues, push can't fail
+struct LockedQueue {
+    bool push(u32 value)
+    {
+        queue.push(value);
+        return true;
+    }
+    bool tryPop(u32& out) { return queue.tryPop(out); }
+
+    ThreadSafeQueue<u32> queue;
+};
+}
+
+BE_BENCHMARK(Queue, SingleProducer)
+{
+    LockedQueue locked;
+    Benchmark::report("ThreadSafeQueue", ITEMS, producersToConsumer(locked, 1));
+
+    SpscRingQueue<u32> spsc(1024);
+    Benchmark::report("SpscRingQueue", ITEMS, producersToConsumer(spsc, 1));
+
+    MpscRingQueue<u32> mpsc(1024);
+    Benchmark::report("MpscRingQueue", ITEMS, producersToConsumer(mpsc, 1));
+}
+
+BE_BENCHMARK(Queue, FourProducers)
+{
+    LockedQueue locked;
+    Benchmark::report("ThreadSafeQueue", ITEMS, producersToConsumer(locked, 4));
+
+    MpscRingQueue<u32> mpsc(1024);
+    Benchmark::report("MpscRingQueue", ITEMS, producersToConsumer(mpsc, 4));
+}
@@ -0,0 +1,284 @@
+#include <cmath>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Game/ECS/EntitySystem.h>
+
+#include "Benchmark.h"
+
+using namespace BitEngine;
+
+namespace {
+struct BenchPosition : public Component<BenchPosition> {
+    float x = 0, y = 0;
+};
+
+struct BenchVelocity : public Component<BenchVelocity> {
+    float vx = 1, vy = 2;
+};
+
+// Same shape as the Transform2DProcessor local matrix computation
+struct BenchTransform : public Component<BenchTransform> {
+    float x = 1, y = 2, rotation = 0.5f, scaleX = 1, scaleY = 1;
+    float local[9];
+};
+
+void calculateLocalMatrix(BenchTransform& t)
+{
+    const float c = cos(t.rotation);
+    const float s = sin(t.rotation);
+    t.local[0] = t.scaleX * c;
+    t.local[1] = -t.scaleX * s;
+    t.local[2] = 0;
+    t.local[3] = t.scaleY * s;
+    t.local[4] = t.scaleY * c;
+    t.local[5] = 0;
+    t.local[6] = t.x;
+    t.local[7] = t.y;
+    t.local[8] = 1;
+}
+
+// Static scenery: only a few transforms change per frame
+struct BenchDirtyTransform : public Component<BenchDirtyTransform> {
+    BenchTransform transform;
+    bool dirty = true;
+};
+
+struct BenchTrackedTransform : public Component<BenchTrackedTransform>, public ChangeTrackedComponent {
+    BenchTransform transform;
+};
+
+class BenchEntitySystem : public EntitySystem {
+public:
+    BenchEntitySystem(u32 nEntities, BaseComponentHolder::StorageMode mode = BaseComponentHolder::StorageMode::STABLE)
+    {
+        registerComponent<BenchPosition>(mode);
+        registerComponent<BenchVelocity>(mode);
+        init();
+
+        for (u32 i = 0; i < nEntities; ++i) {
+            EntityHandle entity = createEntity();
+            addComponent<BenchPosition>(entity);
+            addComponent<BenchVelocity>(entity);
+        }
+    }
+};
+
+const u32 ENTITY_COUNTS[] = { 10000, 100000, 1000000 };
+const u32 ITERATIONS = 10;
+}
+
+BE_BENCHMARK(EntitySystem, ForEachVsView)
+{
+    for (u32 count : ENTITY_COUNTS) {
+        BenchEntitySystem es(count);
+
+        const double forEachMs = Benchmark::measure(ITERATIONS, [&]() {
+            es.forEach<BenchPosition, BenchVelocity>([](ComponentRef<BenchPosition> pos, ComponentRef<BenchVelocity> vel) {
+                pos->x += vel->vx;
+                pos->y += vel->vy;
+            });
+        });
+        Benchmark::report("forEach<Position, Velocity>", count, forEachMs);
+
+        const double viewMs = Benchmark::measure(ITERATIONS, [&]() {
+            es.view<BenchPosition, BenchVelocity>().each([](ComponentRef<BenchPosition> pos, ComponentRef<BenchVelocity> vel) {
+                pos->x += vel->vx;
+                pos->y += vel->vy;
+            });
+        });
+        Benchmark::report("view<Position, Velocity>", count, viewMs);
+
+        Benchmark::doNotOptimize(es.getComponentRef<BenchPosition>(1)->x);
+    }
+}
+
+// Position and velocity were added to different entities over time, so the entities having
+// both are spread over both pools
+BE_BENCHMARK(EntitySystem, ViewVsGroup)
+{
+    for (u32 count : ENTITY_COUNTS) {
+        for (u32 grouped = 0; grouped < 2; ++grouped) {
+            BenchEntitySystem es(0, BaseComponentHolder::StorageMode::PACKED);
+            if (grouped) {
+                es.createGroup<BenchPosition, BenchVelocity>();
+            }
+            for (u32 i = 0; i < count; ++i) {
+                EntityHandle entity = es.createEntity();
+                es.addComponent<BenchPosition>(entity);
+                if (i % 2 == 0) {
+                    es.addComponent<BenchVelocity>(entity);
+                }
+            }
+            for (EntityHandle entity = 1; entity <= count; ++entity) {
+                if (entity % 2 == 0) {
+                    es.addComponent<BenchVelocity>(entity);
+                }
+            }
+
+            const double ms = Benchmark::measure(ITERATIONS, [&]() {
+                auto update = [](ComponentRef<BenchPosition> pos, ComponentRef<BenchVelocity> vel) {
+                    pos->x += vel->vx;
+                    pos->y += vel->vy;
+                };
+                if (grouped) {
+                    es.group<BenchPosition, BenchVelocity>().each(update);
+                }
+                else {
+                    es.view<BenchPosition, BenchVelocity>().each(update);
+                }
+            });
+            Benchmark::report(grouped ? "group<Position, Velocity> packed" : "view<Position, Velocity> packed", count, ms);
+
+            Benchmark::doNotOptimize(es.getComponentRef<BenchPosition>(1)->x);
+        }
+    }
+}
+
+BE_BENCHMARK(EntitySystem, ForAllVsView)
+{
+    for (u32 count : ENTITY_COUNTS) {
+        BenchEntitySystem es(count);
+
+        const double forAllMs = Benchmark::measure(ITERATIONS, [&]() {
+            es.forAll<BenchPosition>([](ComponentHandle handle, BenchPosition& pos) {
+                pos.x += 1.0f;
+            });
+        });
+        Benchmark::report("forAll<Position>", count, forAllMs);
+
+        const double viewMs = Benchmark::measure(ITERATIONS, [&]() {
+            es.view<BenchPosition>().each([](ComponentRef<BenchPosition> pos) {
+                pos->x += 1.0f;
+            });
+        });
+        Benchmark::report("view<Position>", count, viewMs);
+
+        Benchmark::doNotOptimize(es.getComponentRef<BenchPosition>(1)->x);
+    }
+}
+
+BE_BENCHMARK(EntitySystem, StableVsPackedAfterChurn)
+{
+    const char* names[] = { "view<Position> stable after churn", "view<Position> packed after churn" };
+    const BaseComponentHolder::StorageMode modes[] = { BaseComponentHolder::StorageMode::STABLE, BaseComponentHolder::StorageMode::PACKED };
+
+    for (u32 count : ENTITY_COUNTS) {
+        for (u32 m = 0; m < 2; ++m) {
+            BenchEntitySystem es(count, modes[m]);
+
+            // Despawn 3 of every 4 entities, leaving holes spread all over the pools
+            for (EntityHandle entity = 1; entity <= count; ++entity) {
+                if (entity % 4 != 0) {
+                    es.destroyEntity(entity);
+                }
+            }
+            es.destroyPending();
+
+            const double ms = Benchmark::measure(ITERATIONS, [&]() {
+                es.view<BenchPosition>().each([](ComponentRef<BenchPosition> pos) {
+                    pos->x += 1.0f;
+                });
+            });
+            Benchmark::report(names[m], es.getNumberOfValidComponents<BenchPosition>(), ms);
+
+            Benchmark::doNotOptimize(es.getComponentRef<BenchPosition>(4)->x);
+        }
+    }
+}
+
+BE_BENCHMARK(EntitySystem, ParallelLocalMatrices)
+{
+    const u32 count = 200000;
+    EntitySystem es;
+    es.registerComponent<BenchTransform>(BaseComponentHolder::StorageMode::STABLE);
+    es.init();
+    for (u32 i = 0; i < count; ++i) {
+        es.addComponent<BenchTransform>(es.createEntity());
+    }
+
+    const double serialMs = Benchmark::measure(ITERATIONS, [&]() {
+        es.view<BenchTransform>().each([](ComponentRef<BenchTransform> t) {
+            t->rotation += 0.01f;
+            calculateLocalMatrix(t.ref());
+        });
+    });
+    Benchmark::report("view<Transform> local matrices", count, serialMs);
+
+    GeneralTaskManager taskManager;
+    es.setTaskManager(&taskManager);
+    const double parallelMs = Benchmark::measure(ITERATIONS, [&]() {
+        es.parallelForEach<BenchTransform>(1024, [](ComponentRef<BenchTransform> t) {
+            t->rotation += 0.01f;
+            calculateLocalMatrix(t.ref());
+        });
+    });
+    Benchmark::report("parallelForEach<Transform> local matrices", count, parallelMs);
+
+    Benchmark::doNotOptimize(es.getComponentRef<BenchTransform>(1)->local[0]);
+}
+
+BE_BENCHMARK(EntitySystem, CreateEntitiesVsLoop)
+{
+    for (u32 count : ENTITY_COUNTS) {
+        const double loopMs = Benchmark::measure(ITERATIONS, [&]() {
+            BenchEntitySystem es(0);
+            for (u32 i = 0; i < count; ++i) {
+                EntityHandle entity = es.createEntity();
+                es.addComponent<BenchPosition>(entity);
+                es.addComponent<BenchVelocity>(entity);
+            }
+            Benchmark::doNotOptimize(es.getNumberOfValidComponents<BenchPosition>());
+        });
+        Benchmark::report("createEntity + addComponent", count, loopMs);
+
+        const double batchMs = Benchmark::measure(ITERATIONS, [&]() {
+            BenchEntitySystem es(0);
+            es.createEntities(count, BenchPosition(), BenchVelocity());
+            Benchmark::doNotOptimize(es.getNumberOfValidComponents<BenchPosition>());
+        });
+        Benchmark::report("createEntities", count, batchMs);
+    }
+}
+
+BE_BENCHMARK(EntitySystem, DirtyFlagVsChangedSince)
+{
+    for (u32 count : ENTITY_COUNTS) {
+        EntitySystem es;
+        es.registerComponent<BenchDirtyTransform>();
+        es.registerComponent<BenchTrackedTransform>();
+        es.init();
+        es.createEntities(count, BenchDirtyTransform(), BenchTrackedTransform());
+
+        // 1% of the transforms move every frame
+        const u32 moving = count / 100;
+        ComponentHolder<BenchDirtyTransform>* dirtyHolder = es.getHolder<BenchDirtyTransform>();
+        const double dirtyMs = Benchmark::measure(ITERATIONS, [&]() {
+            for (ComponentHandle c = 1; c <= moving; ++c) {
+                dirtyHolder->getComponent(c)->dirty = true;
+            }
+            es.view<BenchDirtyTransform>().each([](ComponentRef<BenchDirtyTransform> t) {
+                if (t->dirty) {
+                    t->dirty = false;
+                    calculateLocalMatrix(t->transform);
+                }
+            });
+        });
+        Benchmark::report("view<Transform> dirty flag, 1% moving", count, dirtyMs);
+
+        ComponentHolder<BenchTrackedTransform>* trackedHolder = es.getHolder<BenchTrackedTransform>();
+        u32 since = trackedHolder->advanceChangeVersion();
+        const double trackedMs = Benchmark::measure(ITERATIONS, [&]() {
+            for (ComponentHandle c = 1; c <= moving; ++c) {
+                trackedHolder->markChanged(c);
+            }
+            const u32 version = since;
+            since = trackedHolder->advanceChangeVersion();
+            trackedHolder->forEachChangedComponent(version, [](ComponentHandle c, BenchTrackedTransform* t) {
+                calculateLocalMatrix(t->transform);
+            });
+        });
+        Benchmark::report("forEachChangedComponent, 1% moving", count, trackedMs);
+
+        Benchmark::doNotOptimize(trackedHolder->getComponent(1)->transform.local[0]);
+    }
+}
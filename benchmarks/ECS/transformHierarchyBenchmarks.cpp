@@ -0,0 +1,72 @@
+#include <vector>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Core/TransformKernels.h>
+#include <BitEngine/Game/ECS/TransformHierarchy.h>
+
+#include "Benchmark.h"
+
+using namespace BitEngine;
+
+namespace {
+struct Matrix {
+    float m[16];
+};
+
+const u32 ITERATIONS = 10;
+}
+
+// Wide and shallow scene: many independent props with a few children each, all moving
+BE_BENCHMARK(TransformHierarchy, SerialVsParallelLevels)
+{
+    const u32 PROPS = 50000;
+    const u32 CHILDREN = 4;
+    const u32 count = PROPS * (CHILDREN + 1);
+
+    TransformHierarchy hierarchy;
+    std::vector<Matrix> local(count + 1), global(count + 1);
+    for (ComponentHandle h = 1; h <= count; ++h) {
+        for (u32 k = 0; k < 16; ++k) {
+            local[h].m[k] = (k % 5 == 0) ? 1.0f : 0.01f * k;
+        }
+        hierarchy.add(h);
+    }
+    for (u32 p = 0; p < PROPS; ++p) {
+        const ComponentHandle prop = 1 + p * (CHILDREN + 1);
+        for (u32 c = 1; c <= CHILDREN; ++c) {
+            hierarchy.setParent(prop + c, prop);
+        }
+    }
+
+    auto update = [&](ComponentHandle node, ComponentHandle parent) {
+        if (parent != 0) {
+            TransformKernels::multiply4x4(global[parent].m, local[node].m, global[node].m);
+        }
+        else {
+            global[node] = local[node];
+        }
+    };
+
+    std::vector<u32> slots;
+    auto changeAll = [&]() {
+        slots.clear();
+        for (ComponentHandle h = 1; h <= count; ++h) {
+            slots.emplace_back(hierarchy.getSlot(h));
+        }
+    };
+
+    const double serialMs = Benchmark::measure(ITERATIONS, [&]() {
+        changeAll();
+        hierarchy.updateSubtrees(slots, update);
+    });
+    Benchmark::report("updateSubtrees", count, serialMs);
+
+    GeneralTaskManager taskManager;
+    const double parallelMs = Benchmark::measure(ITERATIONS, [&]() {
+        changeAll();
+        hierarchy.parallelUpdateSubtrees(&taskManager, slots, 512, update);
+    });
+    Benchmark::report("parallelUpdateSubtrees", count, parallelMs);
+
+    Benchmark::doNotOptimize(global[count].m[0]);
+}
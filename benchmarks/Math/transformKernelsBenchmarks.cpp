@@ -0,0 +1,147 @@
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <BitEngine/Core/TransformKernels.h>
+
+#include "Benchmark.h"
+
+using namespace BitEngine;
+
+namespace {
+const u32 TRANSFORM_COUNT = 1000000;
+const u32 ITERATIONS = 10;
+
+struct Transforms2D {
+    Transforms2D(u32 count)
+        : px(count)
+        , py(count)
+        , rotation(count)
+        , sx(count)
+        , sy(count)
+        , local(count)
+        , out(count)
+    {
+        for (u32 i = 0; i < count; ++i) {
+            px[i] = (float)i;
+            py[i] = (float)(count - i);
+            rotation[i] = i * 0.001f;
+            sx[i] = 1.0f + (i % 7) * 0.1f;
+            sy[i] = 1.0f + (i % 5) * 0.1f;
+            out[i] = &local[i][0][0];
+        }
+    }
+
+    std::vector<float> px, py, rotation, sx, sy;
+    std::vector<glm::mat3> local;
+    std::vector<float*> out;
+};
+
+struct Transforms3D {
+    Transforms3D(u32 count)
+        : position(count)
+        , scale(count)
+        , rotation(count)
+        , local(count)
+        , global(count)
+        , out(count)
+    {
+        for (u32 i = 0; i < count; ++i) {
+            position[i] = glm::vec3((float)i, 1.0f, -(float)i);
+            scale[i] = glm::vec3(1.0f + (i % 3) * 0.5f);
+            rotation[i] = glm::angleAxis(i * 0.001f, glm::normalize(glm::vec3(1, 2, 3)));
+            out[i] = &local[i][0][0];
+        }
+        for (u32 a = 0; a < 10; ++a) {
+            soa[a].resize(count);
+        }
+        for (u32 i = 0; i < count; ++i) {
+            for (u32 a = 0; a < 3; ++a) {
+                soa[a][i] = position[i][a];
+                soa[3 + a][i] = scale[i][a];
+            }
+            soa[6][i] = rotation[i].x;
+            soa[7][i] = rotation[i].y;
+            soa[8][i] = rotation[i].z;
+            soa[9][i] = rotation[i].w;
+        }
+    }
+
+    std::vector<glm::vec3> position, scale;
+    std::vector<glm::quat> rotation;
+    std::vector<float> soa[10];
+    std::vector<glm::mat4> local, global;
+    std::vector<float*> out;
+};
+}
+
+BE_BENCHMARK(TransformKernels, Local2DGlmVsBatch)
+{
+    Transforms2D t(TRANSFORM_COUNT);
+
+    const double glmMs = Benchmark::measure(ITERATIONS, [&]() {
+        for (u32 i = 0; i < TRANSFORM_COUNT; ++i) {
+            // Transform2DProcessor::CalculateLocalModelMatrix before the batch kernels
+            const float cosx = cos(t.rotation[i]);
+            const float sinx = sin(t.rotation[i]);
+            t.local[i] = glm::transpose(glm::mat3(t.sx[i] * cosx, t.sy[i] * sinx, t.px[i],
+                -t.sx[i] * sinx, t.sy[i] * cosx, t.py[i],
+                0.0f, 0.0f, 1.0f));
+        }
+    });
+    Benchmark::report("glm local 2D", TRANSFORM_COUNT, glmMs);
+
+    const double batchMs = Benchmark::measure(ITERATIONS, [&]() {
+        TransformKernels::composeLocal2D({ t.px.data(), t.py.data(), t.rotation.data(), t.sx.data(), t.sy.data() }, TRANSFORM_COUNT, t.out.data());
+    });
+    Benchmark::report(std::string("composeLocal2D ") + TransformKernels::getInstructionSet(), TRANSFORM_COUNT, batchMs);
+
+    Benchmark::doNotOptimize(t.local[1][0][0]);
+}
+
+BE_BENCHMARK(TransformKernels, Local3DGlmVsBatch)
+{
+    Transforms3D t(TRANSFORM_COUNT);
+
+    const double glmMs = Benchmark::measure(ITERATIONS, [&]() {
+        for (u32 i = 0; i < TRANSFORM_COUNT; ++i) {
+            // Transform3DProcessor::CalculateLocalModelMatrix before the batch kernels
+            t.local[i] = glm::translate(glm::mat4_cast(t.rotation[i]) * glm::scale(glm::mat4(1), t.scale[i]), t.position[i]);
+        }
+    });
+    Benchmark::report("glm local 3D", TRANSFORM_COUNT, glmMs);
+
+    const double batchMs = Benchmark::measure(ITERATIONS, [&]() {
+        TransformKernels::composeLocal3D({ t.soa[0].data(), t.soa[1].data(), t.soa[2].data(), t.soa[3].data(), t.soa[4].data(),
+                                             t.soa[5].data(), t.soa[6].data(), t.soa[7].data(), t.soa[8].data(), t.soa[9].data() },
+            TRANSFORM_COUNT, t.out.data());
+    });
+    Benchmark::report(std::string("composeLocal3D ") + TransformKernels::getInstructionSet(), TRANSFORM_COUNT, batchMs);
+
+    Benchmark::doNotOptimize(t.local[1][0][0]);
+}
+
+BE_BENCHMARK(TransformKernels, GlobalGlmVsMultiply4x4)
+{
+    Transforms3D t(TRANSFORM_COUNT);
+    const glm::mat4 parent = glm::translate(glm::mat4(1), glm::vec3(1, 2, 3));
+
+    const double glmMs = Benchmark::measure(ITERATIONS, [&]() {
+        for (u32 i = 0; i < TRANSFORM_COUNT; ++i) {
+            t.global[i] = parent * t.local[i];
+        }
+    });
+    Benchmark::report("glm parent * local", TRANSFORM_COUNT, glmMs);
+
+    const double kernelMs = Benchmark::measure(ITERATIONS, [&]() {
+        for (u32 i = 0; i < TRANSFORM_COUNT; ++i) {
+            TransformKernels::multiply4x4(&parent[0][0], &t.local[i][0][0], &t.global[i][0][0]);
+        }
+    });
+    Benchmark::report(std::string("multiply4x4 ") + TransformKernels::getInstructionSet(), TRANSFORM_COUNT, kernelMs);
+
+    Benchmark::doNotOptimize(t.global[1][0][0]);
+}
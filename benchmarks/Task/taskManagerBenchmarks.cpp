@@ -0,0 +1,244 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <BitEngine/Core/FramePipeline.h>
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Core/ParallelFor.h>
+#include <BitEngine/Core/TaskGraph.h>
+#include <BitEngine/Core/TaskPool.h>
+
+#include "Benchmark.h"
+
+using namespace BitEngine;
+
+namespace {
+const u32 ITERATIONS = 10;
+
+class CountTask : public Task {
+public:
+    CountTask(std::atomic<u32>& counter)
+        : Task(TaskMode::NONE, Affinity::BACKGROUND)
+        , m_counter(counter)
+    {
+    }
+
+private:
+    void run() override { m_counter.fetch_add(1, std::memory_order_relaxed); }
+
+    std::atomic<u32>& m_counter;
+};
+}
+
+// Scheduling overhead: many tasks that do nothing, added from the main thread
+BE_BENCHMARK(TaskManager, EmptyTasks)
+{
+    const u32 count = 100000;
+    GeneralTaskManager taskManager;
+    std::atomic<u32> counter(0);
+
+    const double ms = Benchmark::measure(ITERATIONS, [&]() {
+        counter = 0;
+        for (u32 i = 0; i < count; ++i) {
+            taskManager.addTask(std::make_shared<CountTask>(counter));
+        }
+        while (counter.load() != count) {
+            std::this_thread::yield();
+        }
+    });
+    Benchmark::report("addTask + run empty tasks", count, ms);
+}
+
+BE_BENCHMARK(TaskManager, EmptyLambdaTasks)
+{
+    const u32 count = 100000;
+    std::atomic<u32> counter(0);
+
+    // Frame stats time every task, compare with them turned off
+    for (const bool collectStats : { true, false }) {
+        TaskManagerConfiguration configuration;
+        configuration.m_CollectStats = collectStats;
+        GeneralTaskManager taskManager(configuration);
+
+        const double ms = Benchmark::measure(ITERATIONS, [&]() {
+            counter = 0;
+            for (u32 i = 0; i < count; ++i) {
+                taskManager.addTask([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+            }
+            while (counter.load() != count) {
+                std::this_thread::yield();
+            }
+        });
+        Benchmark::report(collectStats ? "addTask + run empty lambdas" : "addTask + run empty lambdas, no stats", count, ms);
+    }
+}
+
+// Cost of creating and destroying a task, without scheduling it
+BE_BENCHMARK(TaskManager, TaskCreation)
+{
+    const u32 count = 100000;
+    std::atomic<u32> counter(0);
+    std::vector<TaskPtr> tasks(count);
+
+    double ms = Benchmark::measure(ITERATIONS, [&]() {
+        for (u32 i = 0; i < count; ++i) {
+            tasks[i] = std::make_shared<CountTask>(counter);
+        }
+        for (TaskPtr& task : tasks) {
+            task.reset();
+        }
+    });
+    Benchmark::report("std::make_shared", count, ms);
+
+    ms = Benchmark::measure(ITERATIONS, [&]() {
+        for (u32 i = 0; i < count; ++i) {
+            tasks[i] = makeTask<CountTask>(counter);
+        }
+        for (TaskPtr& task : tasks) {
+            task.reset();
+        }
+    });
+    Benchmark::report("makeTask", count, ms);
+}
+
+// Fork/join of small ranges, as systems do every frame
+BE_BENCHMARK(TaskManager, SmallParallelFor)
+{
+    const u32 count = 2000;
+    GeneralTaskManager taskManager;
+    std::vector<float> values(4096, 1.0f);
+
+    const double ms = Benchmark::measure(ITERATIONS, [&]() {
+        for (u32 i = 0; i < count; ++i) {
+            parallelForRange(&taskManager, static_cast<u32>(values.size()), 256, [&](u32 first, u32 last) {
+                for (u32 k = first; k < last; ++k) {
+                    values[k] = values[k] * 0.5f + 1.0f;
+                }
+            });
+        }
+    });
+    Benchmark::report("parallelForRange 4096 floats", count, ms);
+    Benchmark::doNotOptimize(values[0]);
+}
+
+// Uneven work per element, chunk sizes have to even it out
+BE_BENCHMARK(TaskManager, ParallelReduce)
+{
+    const u32 count = 200000;
+    GeneralTaskManager taskManager;
+    std::vector<float> values(count);
+    for (u32 i = 0; i < count; ++i) {
+        values[i] = (i % 97) * 0.01f;
+    }
+
+    float result = 0;
+    const double ms = Benchmark::measure(ITERATIONS, [&]() {
+        result = parallelReduce(&taskManager, 0, count, 1024, 0.0f,
+            [&values](u32 first, u32 last, float partial) {
+                for (u32 i = first; i < last; ++i) {
+                    // Later elements cost more
+                    for (u32 k = 0; k <= i / 50000; ++k) {
+                        partial += values[i] * values[i];
+                    }
+                }
+                return partial;
+            },
+            [](float a, float b) { return a + b; });
+    });
+    Benchmark::report("parallelReduce uneven sum", count, ms);
+    Benchmark::doNotOptimize(result);
+}
+
+// Chain where every task depends on the previous one, all added before the first runs
+BE_BENCHMARK(TaskManager, DependencyChain)
+{
+    const u32 count = 10000;
+    GeneralTaskManager taskManager;
+    std::atomic<u32> counter(0);
+
+    const double ms = Benchmark::measure(ITERATIONS, [&]() {
+        counter = 0;
+        std::vector<TaskPtr> tasks;
+        for (u32 i = 0; i < count; ++i) {
+            tasks.emplace_back(std::make_shared<CountTask>(counter));
+            if (i > 0) {
+                tasks[i]->addDependency(tasks[i - 1]);
+            }
+        }
+        for (u32 i = 0; i < count; ++i) {
+            taskManager.addTask(tasks[i]);
+        }
+        taskManager.waitTask(tasks.back());
+    });
+    Benchmark::report("dependency chain", count, ms);
+}
+
+// Fork/join graph submitted every frame: root -> 64 tasks -> join
+BE_BENCHMARK(TaskManager, GraphSubmit)
+{
+    const u32 frames = 1000;
+    const u32 width = 64;
+    GeneralTaskManager taskManager;
+    std::atomic<u32> counter(0);
+
+    TaskGraph graph;
+    TaskPtr root = std::make_shared<CountTask>(counter);
+    TaskPtr join = std::make_shared<CountTask>(counter);
+    graph.add(root);
+    graph.add(join);
+    for (u32 i = 0; i < width; ++i) {
+        TaskPtr task = std::make_shared<CountTask>(counter);
+        graph.add(task);
+        graph.addDependency(task, root);
+        graph.addDependency(join, task);
+    }
+
+    const double ms = Benchmark::measure(ITERATIONS, [&]() {
+        for (u32 f = 0; f < frames; ++f) {
+            graph.submit(&taskManager);
+            taskManager.waitTask(join);
+        }
+    });
+    Benchmark::report("submit 66 node graph", frames, ms);
+}
+
+// Simulation and render of the same cost, one after the other or overlapped
+BE_BENCHMARK(TaskManager, FramePipeline)
+{
+    const u32 frames = 200;
+    const u32 work = 20000;
+    GeneralTaskManager taskManager;
+
+    auto busy = [](std::vector<float>& data) {
+        for (u32 i = 0; i < work; ++i) {
+            data[i % data.size()] = data[i % data.size()] * 0.999f + 1.0f;
+        }
+    };
+    std::vector<float> simulation(256, 1.0f), rendering(256, 1.0f);
+    std::vector<float> queues[2] = { std::vector<float>(256, 0.0f), std::vector<float>(256, 0.0f) };
+
+    double ms = Benchmark::measure(ITERATIONS, [&]() {
+        for (u32 i = 0; i < frames; ++i) {
+            busy(simulation);
+            queues[0] = simulation;
+            busy(rendering);
+        }
+    });
+    Benchmark::report("serial frames", frames, ms);
+
+    ms = Benchmark::measure(ITERATIONS, [&]() {
+        FramePipeline<std::vector<float> > pipeline(&taskManager, &queues[0], &queues[1]);
+        for (u32 i = 0; i < frames; ++i) {
+            pipeline.produce([&](std::vector<float>& queue) {
+                busy(simulation);
+                queue = simulation;
+            });
+            if (pipeline.getReadySlot() != nullptr) {
+                busy(rendering);
+            }
+            pipeline.finishFrame();
+        }
+    });
+    Benchmark::report("pipelined frames", frames, ms);
+    Benchmark::doNotOptimize(rendering[0]);
+}
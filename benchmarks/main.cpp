@@ -0,0 +1,42 @@
+#include <cstdio>
+#include <cstring>
+
+#include <BitEngine/Core/Logger.h>
+#include <BitEngine/Core/Profiler.h>
+
+#include <BitEngine/Global/globals.cpp>
+
+#include "Benchmark.h"
+
+namespace Benchmark {
+void report(const std::string& name, u32 elements, double ms)
+{
+    printf("%-48s %10u elements %12.3f ms %10.2f ns/element\n", name.c_str(), elements, ms, ms * 1e6 / elements);
+}
+}
+
+// Usage: Benchmarks [filter]
+// Only benchmarks containing filter in the name are run
+int main(int argc, const char* argv[])
+{
+    BitEngine::Profiling::ChromeProfiler profiler;
+    profiler.enable_profiling = false;
+    BitEngine::Profiling::SetInstance(&profiler);
+    BitEngine::LoggerSetup::Setup(argc, argv);
+
+    const char* filter = "";
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            filter = argv[i];
+        }
+    }
+
+    for (const Benchmark::Entry& entry : Benchmark::Registry()) {
+        if (strstr(entry.name.c_str(), filter) != nullptr) {
+            printf("== %s\n", entry.name.c_str());
+            entry.run();
+        }
+    }
+
+    return 0;
+}
@@ -155,6 +155,7 @@ project "Tests"
 		"tests/Common/**.cpp",
 		"tests/Core/**.cpp",
 		"tests/*.cpp",
+		"BitEngine/src/BitEngine/Game/**.cpp",
 	}
 
 	includedirs
@@ -178,6 +179,58 @@ project "Tests"
 		symbols "on"
 		staticruntime "Off"
 
+project "Benchmarks"
+	location "benchmarks"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "off"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-tmp/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"benchmarks/**.h",
+		"benchmarks/**.cpp",
+		"BitEngine/src/BitEngine/Game/**.cpp",
+	}
+
+	includedirs
+	{
+		"BitEngine/src",
+		"benchmarks",
+		"%{IncludeDir.json}",
+		"%{IncludeDir.glm}"
+	}
+
+	links
+	{
+		"BitEngine"
+	}
+
+	filter "system:linux"
+		links
+		{
+			"pthread"
+		}
+
+	filter "configurations:Debug"
+		defines "BE_DEBUG"
+		runtime "Debug"
+		symbols "on"
+		staticruntime "Off"
+
+	filter "configurations:Release"
+		defines "BE_RELEASE"
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines "BE_DIST"
+		runtime "Release"
+		optimize "on"
+
 project "Sample01"
 	location "samples"
 	kind "ConsoleApp"
@@ -80,6 +80,44 @@ public:
         {
             auto taskManager = mainMemory->taskManager;
             // Display contents in a scrolling region
+            const BitEngine::TaskFrameStats& stats = taskManager->getFrameStats();
+            ImGui::Text("Frame %llu: %.2f ms, main queue: %u, shared queue: %u", (unsigned long long)stats.frame, stats.frameMs, stats.mainQueueDepth, stats.sharedQueueDepth);
+            ImGui::Columns(6, "workers");
+            ImGui::Text("Worker");
+            ImGui::NextColumn();
+            ImGui::Text("Tasks");
+            ImGui::NextColumn();
+            ImGui::Text("Stolen");
+            ImGui::NextColumn();
+            ImGui::Text("Queued");
+            ImGui::NextColumn();
+            ImGui::Text("Idle ms");
+            ImGui::NextColumn();
+            ImGui::Text("Latency ms (avg/max)");
+            ImGui::NextColumn();
+            ImGui::Separator();
+            for (size_t i = 0; i < stats.workers.size(); ++i) {
+                const BitEngine::TaskWorkerStats& worker = stats.workers[i];
+                if (i == 0) {
+                    ImGui::Text("main");
+                } else {
+                    ImGui::Text("%zu", i);
+                }
+                ImGui::NextColumn();
+                ImGui::Text("%u", worker.tasksExecuted);
+                ImGui::NextColumn();
+                ImGui::Text("%u", worker.tasksStolen);
+                ImGui::NextColumn();
+                ImGui::Text("%u", worker.queueDepth);
+                ImGui::NextColumn();
+                ImGui::Text("%.2f", worker.idleMs);
+                ImGui::NextColumn();
+                ImGui::Text("%.3f / %.3f", worker.averageLatencyMs, worker.maxLatencyMs);
+                ImGui::NextColumn();
+            }
+            ImGui::Columns(1);
+            ImGui::Separator();
+
             ImGui::TextColored(ImVec4(1, 1, 0, 1), "Tasks: %lu", taskManager->getTasks().size());
             ImGui::BeginChild("Scrolling");
             for (const BitEngine::TaskPtr& ptr : taskManager->getTasks()) {
@@ -131,6 +169,8 @@ public:
         // Init game state stuff
         gameState->entitySystem = permanentArena.push<MyGameEntitySystem>(loader, &gameState->entityArena);
         gameState->entitySystem->init();
+        gameState->entitySystem->setTaskManager(mainMemory->taskManager);
+        gameState->entitySystem->systems.setTaskManager(mainMemory->taskManager);
 
         gameState->m_userGUI = permanentArena.push<UserGUI>(gameState->entitySystem);
         gameState->m_world = permanentArena.push<GameWorld>(mainMemory, gameState->entitySystem);
@@ -181,8 +221,9 @@ public:
             BitEngine::ComponentRef<BitEngine::SceneTransform2DComponent> sceneComp;
             BitEngine::ComponentRef<BitEngine::GameLogicComponent> logicComp;
             transformComp = es->addComponent<BitEngine::Transform2DComponent>(h);
-            spriteComp = es->addComponent<BitEngine::Sprite2DComponent>(h, 6, spr3, nullptr); // es->spr2D.getMaterial(Sprite2DRenderer::EFFECT_SPRITE)
+            // Joining the sprite group moves components, add the sprite last so spriteComp stays valid
             sceneComp = es->addComponent<BitEngine::SceneTransform2DComponent>(h);
+            spriteComp = es->addComponent<BitEngine::Sprite2DComponent>(h, 6, spr3, nullptr); // es->spr2D.getMaterial(Sprite2DRenderer::EFFECT_SPRITE)
             logicComp = es->addComponent<BitEngine::GameLogicComponent>(h);
             es->addComponent<SpinnerComponent>(h, (rand() % 10) / 100.0f + 0.02f);
 
@@ -203,15 +244,7 @@ public:
 
         gameState->entitySystem->destroyPending();
 
-        SpinnerSystem(gameState->entitySystem);
-
-        gameState->entitySystem->t2p.Process();
-        gameState->entitySystem->t3p.Process();
-
-        gameState->entitySystem->cam2Dprocessor.Process();
-        gameState->entitySystem->cam3Dprocessor.Process();
-
-        PlayerControlSystem(gameState->entitySystem);
+        gameState->entitySystem->systems.run();
 
         mainMemory->taskManager->update();
         mainMemory->loader->update();
@@ -228,6 +261,35 @@ public:
         return gameState->running;
     }
 
+    // Pipelined mode splits update() in two: the part that must run on the main thread,
+    // and the simulation that runs in a background task while the previous frame renders
+    bool32 updateMainThread()
+    {
+        if (!gameState->initialized) {
+            init();
+            gameState->initialized = true;
+        }
+
+        gameState->entitySystem->destroyPending();
+
+        mainMemory->taskManager->update();
+        mainMemory->loader->update();
+
+        if (!gameState->running) {
+            gameState->entitySystem->~MyGameEntitySystem();
+        }
+
+        return gameState->running;
+    }
+
+    void simulate(RenderQueue* renderQueue)
+    {
+        gameState->entitySystem->systems.run();
+
+        mainMemory->renderQueue = renderQueue;
+        render();
+    }
+
     void onMessage(const BitEngine::WindowClosedEvent& msg) {
         gameState->running = false;
     }
@@ -6,6 +6,7 @@
 #include <BitEngine/Game/ECS/GameLogicProcessor.h>
 #include <BitEngine/Game/ECS/RenderableMeshComponent.h>
 #include <BitEngine/Game/ECS/EntitySystem.h>
+#include <BitEngine/Game/ECS/SystemScheduler.h>
 
 
 #include "Game/Common/MainMemory.h"
@@ -76,7 +77,7 @@ public:
         // TODO: Make loop append entries to render queue
         // Individual entries should be prepared for rendering
         // by the rendering implementation
-        es->forEach<BitEngine::SceneTransform2DComponent, BitEngine::Sprite2DComponent>(
+        es->group<BitEngine::SceneTransform2DComponent, BitEngine::Sprite2DComponent>().each(
             [=](BitEngine::ComponentRef<BitEngine::SceneTransform2DComponent>&& transform, BitEngine::ComponentRef<BitEngine::Sprite2DComponent>&& sprite)
         {
             if (insideScreen(viewScreen, transform->getGlobal(), 64))
@@ -150,7 +151,7 @@ public:
         batch->light.direction = { cos(f), 0.5f, -0.2f };
         batch->light.color = { 1.f, 1.f, 1.f };
 
-        es->forEach<RenderableMeshComponent, Transform3DComponent>(
+        es->view<RenderableMeshComponent, Transform3DComponent>().each(
             [&](ComponentRef<RenderableMeshComponent>&& renderable, ComponentRef<Transform3DComponent>&& transform)
         {
             RR<Model> model = renderable->getModel();
@@ -186,7 +187,11 @@ private:
 void PlayerControlSystem(BitEngine::EntitySystem* es)
 {
     BE_PROFILE_FUNCTION();
-    es->forAll<PlayerControlComponent>([](BitEngine::ComponentHandle id, PlayerControlComponent& comp) {
+    es->forAll<PlayerControlComponent>([es](BitEngine::ComponentHandle id, PlayerControlComponent& comp) {
+        if (!es->isValid(comp.transform2d)) {
+            return;
+        }
+
         float vel = 2.0f;
 
         // camT2D->setPosition(x, y);
@@ -215,7 +220,7 @@ public:
 void SpinnerSystem(BitEngine::EntitySystem *es)
 {
     using namespace BitEngine;
-    es->forEach<Transform2DComponent, SpinnerComponent>(
+    es->view<Transform2DComponent, SpinnerComponent>().each(
         [=](ComponentRef<Transform2DComponent> transform, const ComponentRef<SpinnerComponent> spinner)
     {
         transform->setLocalRotation(transform->getLocalRotation() + spinner->speed*1);
@@ -232,13 +237,16 @@ public:
         registerComponent<PlayerControlComponent>();
         registerComponent<GameLogicComponent>();
         registerComponent<SpinnerComponent>();
-        registerComponent<SceneTransform2DComponent>();
+        registerComponent<SceneTransform2DComponent>(BaseComponentHolder::StorageMode::PACKED);
         registerComponent<RenderableMeshComponent>();
-        registerComponent<Sprite2DComponent>();
+        registerComponent<Sprite2DComponent>(BaseComponentHolder::StorageMode::PACKED);
         registerComponent<Camera2DComponent>();
         registerComponent<Camera3DComponent>();
         registerComponent<Transform2DComponent>();
         registerComponent<Transform3DComponent>();
+
+        // Sprites are drawn with a linear scan over both arrays
+        createGroup<SceneTransform2DComponent, Sprite2DComponent>();
     }
 };
 
@@ -252,8 +260,28 @@ public:
         mesh3dSys(&t3p)
     {
         using namespace BitEngine;
+
+        // Registration order is the order conflicting systems run in
+        systems.addSystem("Spinner", [this]() { SpinnerSystem(this); })
+            .reads<SpinnerComponent>()
+            .writes<Transform2DComponent>();
+        systems.addSystem("Transform2D", [this]() { t2p.Process(); })
+            .writes<Transform2DComponent, SceneTransform2DComponent>();
+        systems.addSystem("Transform3D", [this]() { t3p.Process(); })
+            .writes<Transform3DComponent>();
+        systems.addSystem("Camera2D", [this]() { cam2Dprocessor.Process(); })
+            .writes<Camera2DComponent>();
+        systems.addSystem("Camera3D", [this]() { cam3Dprocessor.Process(); })
+            .reads<Transform3DComponent>()
+            .writes<Camera3DComponent>();
+        systems.addSystem("PlayerControl", [this]() { PlayerControlSystem(this); })
+            .reads<PlayerControlComponent>()
+            .writes<Transform2DComponent>();
     }
 
+    // Runs the systems above every frame
+    BitEngine::SystemScheduler systems;
+
     // Processors
     BitEngine::Transform2DProcessor t2p;
     BitEngine::Transform3DProcessor t3p;
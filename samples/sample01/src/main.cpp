@@ -1,8 +1,10 @@
 
+#include <memory>
 #include <string>
 
 #include <BitEngine/bitengine.h>
 #include <BitEngine/Core/Messenger.h>
+#include <BitEngine/Core/FramePipeline.h>
 #include <BitEngine/Core/GeneralTaskManager.h>
 #include <BitEngine/Core/Resources/DevResourceLoader.h>
 
@@ -34,10 +36,10 @@ void gameExecute(MainMemory& gameMemory)
 
     // Basic infrastructure
     BitEngine::EngineConfigurationFileLoader configurations("config.ini");
-    BitEngine::GeneralTaskManager taskManager;
 
     BitEngine::EngineConfiguration engineConfig;
     configurations.loadConfigurations(engineConfig);
+    BitEngine::GeneralTaskManager taskManager(BitEngine::GeneralTaskManager::loadConfiguration(engineConfig));
 
     BitEngine::GLFW_VideoSystem video;
     BitEngine::GLFW_ImGuiSystem imgui;
@@ -93,6 +95,17 @@ void gameExecute(MainMemory& gameMemory)
     memset(renderArena.base, 0, renderArena.size);
     RenderQueue renderQueue(renderArena);
 
+    // Pipelined: the next frame is simulated while the current one renders, into a second queue
+    const bool pipelined = engineConfig.getConfiguration("Video", "Pipelined", "false")->getValueAsBool();
+    BitEngine::MemoryArena nextRenderArena;
+    std::unique_ptr<RenderQueue> nextRenderQueue;
+    if (pipelined) {
+        nextRenderArena.init((u8*)malloc(renderMemSize), renderMemSize);
+        memset(nextRenderArena.base, 0, nextRenderArena.size);
+        nextRenderQueue = std::make_unique<RenderQueue>(nextRenderArena);
+    }
+    BitEngine::FramePipeline<RenderQueue> renderPipeline(&taskManager, &renderQueue, nextRenderQueue.get());
+
     GLRenderer renderer;
 
     gameMemory.loader = &loader;
@@ -120,6 +133,18 @@ void gameExecute(MainMemory& gameMemory)
 
         bool32 running = true;
 
+        auto renderFrame = [&](RenderQueue* queue) {
+            BE_PROFILE_SCOPE("Game Render Queue");
+            if (!rendererReady) {
+                // TODO: Clean this up, maybe have a platform index loaded previously so we can
+                // TODO: call init right after?
+                renderer.init(&loader);
+                rendererReady = true;
+            }
+            renderer.render(queue);
+            queue->clear();
+        };
+
         while (running) {
             BE_PROFILE_SCOPE("Game Loop");
 
@@ -127,21 +152,27 @@ void gameExecute(MainMemory& gameMemory)
 
             main_window->drawBegin();
 
-            running = game->update();
+            if (pipelined) {
+                running = game->updateMainThread();
+                if (running) {
+                    renderPipeline.produce([game](RenderQueue& queue) { game->simulate(&queue); });
 
-            if (running) {
-                {
-                    BE_PROFILE_SCOPE("Game Render Queue");
-                    if (!rendererReady) {
-                        // TODO: Clean this up, maybe have a platform index loaded previously so we can
-                        // TODO: call init right after?
-                        renderer.init(&loader);
-                        rendererReady = true;
+                    // Simulated on the previous loop, there is none on the first one
+                    if (RenderQueue* ready = renderPipeline.getReadySlot()) {
+                        renderFrame(ready);
                     }
-                    renderer.render(gameMemory.renderQueue);
-                    renderQueue.clear();
+
+                    renderPipeline.finishFrame();
+                }
+            }
+            else {
+                running = game->update();
+                if (running) {
+                    renderFrame(gameMemory.renderQueue);
                 }
+            }
 
+            if (running) {
                 imgui.update();
                 main_window->drawEnd();
             }
@@ -41,10 +41,10 @@ void game()
 {
     // Basic infrastructure
     BitEngine::EngineConfigurationFileLoader configurations("config.ini");
-    BitEngine::GeneralTaskManager taskManager;
 
     BitEngine::EngineConfiguration engineConfig;
     configurations.loadConfigurations(engineConfig);
+    BitEngine::GeneralTaskManager taskManager(BitEngine::GeneralTaskManager::loadConfiguration(engineConfig));
 
     BitEngine::GLFW_VideoSystem video;
     BitEngine::GLFW_ImGuiSystem imgui;
@@ -118,12 +118,12 @@ void game()
     fflush(stdout);
     // Basic infrastructure
     BitEngine::EngineConfigurationFileLoader configurations("config.ini");
-    BitEngine::GeneralTaskManager taskManager;
 
     BitEngine::EngineConfiguration engineConfig;
     printf("Loading configs...");
     fflush(stdout);
     configurations.loadConfigurations(engineConfig);
+    BitEngine::GeneralTaskManager taskManager(BitEngine::GeneralTaskManager::loadConfiguration(engineConfig));
     printf("configs ready\n");
     fflush(stdout);
 
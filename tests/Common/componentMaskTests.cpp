@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+
+#include "BitEngine/Common/ComponentMask.h"
+
+#include "gtest/gtest.h"
+
+typedef BitEngine::ComponentMask<256> Mask256;
+
+TEST(ComponentMaskTest, StartsEmpty)
+{
+	Mask256 mask;
+	ASSERT_TRUE(mask.none());
+	for (u32 i = 0; i < Mask256::BITS; ++i){
+		ASSERT_FALSE(mask.test(i));
+	}
+}
+
+TEST(ComponentMaskTest, SetAndUnsetAcrossWords)
+{
+	Mask256 mask;
+	const u32 bits[] = { 0, 63, 64, 127, 128, 200, 255 };
+	for (u32 b : bits){
+		mask.set(b);
+	}
+
+	for (u32 i = 0; i < Mask256::BITS; ++i){
+		const bool expected = std::find(std::begin(bits), std::end(bits), i) != std::end(bits);
+		ASSERT_EQ(expected, mask.test(i)) << "bit " << i;
+	}
+
+	mask.unset(64);
+	ASSERT_FALSE(mask.test(64));
+	ASSERT_TRUE(mask.test(63));
+	ASSERT_TRUE(mask.test(127));
+
+	mask.clear();
+	ASSERT_TRUE(mask.none());
+}
+
+TEST(ComponentMaskTest, ContainsAllAndIntersects)
+{
+	Mask256 entity;
+	entity.set(3);
+	entity.set(70);
+	entity.set(190);
+
+	Mask256 query;
+	query.set(70);
+	query.set(190);
+	ASSERT_TRUE(entity.containsAll(query));
+	ASSERT_TRUE(entity.containsAll(Mask256()));
+
+	query.set(130);
+	ASSERT_FALSE(entity.containsAll(query));
+	ASSERT_TRUE(entity.intersects(query));
+
+	Mask256 other;
+	other.set(4);
+	other.set(191);
+	ASSERT_FALSE(entity.intersects(other));
+	ASSERT_TRUE((entity | other).containsAll(other));
+}
+
+TEST(ComponentMaskTest, EqualityAndHash)
+{
+	Mask256 a;
+	Mask256 b;
+	a.set(100);
+	ASSERT_NE(a, b);
+	b.set(100);
+	ASSERT_EQ(a, b);
+	ASSERT_EQ(Mask256::Hash()(a), Mask256::Hash()(b));
+
+	std::unordered_set<Mask256, Mask256::Hash> masks;
+	for (u32 i = 0; i < Mask256::BITS; ++i){
+		Mask256 m;
+		m.set(i);
+		masks.insert(m);
+	}
+	masks.insert(a);
+	ASSERT_EQ(Mask256::BITS, masks.size());
+}
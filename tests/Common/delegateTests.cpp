@@ -0,0 +1,76 @@
+#include <functional>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Common/Delegate.h>
+#include <BitEngine/Common/TypeDefinition.h>
+
+using namespace BitEngine;
+
+namespace {
+struct Counter {
+    void add(int value) { total += value; }
+    void sub(int value) { total -= value; }
+    int total = 0;
+};
+}
+
+TEST(Delegate, BindsMemberFunctions)
+{
+    Counter counter;
+    Delegate<void(int)> add = Delegate<void(int)>::bind<Counter, &Counter::add>(&counter);
+    Delegate<void(int)> sub = Delegate<void(int)>::bind(&counter, &Counter::sub);
+
+    add(5);
+    sub(2);
+    ASSERT_EQ(counter.total, 3);
+}
+
+TEST(Delegate, StoresCallables)
+{
+    int calls = 0;
+    Delegate<int(int)> small([&calls](int v) {
+        ++calls;
+        return v * 2;
+    });
+    ASSERT_EQ(small(4), 8);
+
+    // Too big to be stored inline
+    u64 big[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    Delegate<int(int)> large([big, &calls](int v) {
+        ++calls;
+        return static_cast<int>(big[7]) + v;
+    });
+    ASSERT_EQ(large(1), 9);
+
+    std::function<int(int)> function = [](int v) { return v + 1; };
+    Delegate<int(int)> fromFunction(function);
+    ASSERT_EQ(fromFunction(1), 2);
+    ASSERT_EQ(calls, 2);
+}
+
+TEST(Delegate, MovesAndDestroysWhatItHolds)
+{
+    std::shared_ptr<int> value = std::make_shared<int>(7);
+    {
+        Delegate<int()> first([value]() { return *value; });
+        ASSERT_EQ(value.use_count(), 2);
+
+        Delegate<int()> second(std::move(first));
+        ASSERT_FALSE(static_cast<bool>(first));
+        ASSERT_EQ(second(), 7);
+        ASSERT_EQ(value.use_count(), 2);
+
+        second = Delegate<int()>([]() { return 1; });
+        ASSERT_EQ(value.use_count(), 1);
+        ASSERT_EQ(second(), 1);
+
+        u64 big[8] = {};
+        Delegate<int()> large([value, big]() { return *value + static_cast<int>(big[0]); });
+        Delegate<int()> moved(std::move(large));
+        ASSERT_EQ(moved(), 7);
+        ASSERT_EQ(value.use_count(), 2);
+    }
+    ASSERT_EQ(value.use_count(), 1);
+}
@@ -0,0 +1,170 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Common/RingQueue.h>
+#include <BitEngine/Common/TypeDefinition.h>
+
+using namespace BitEngine;
+
+template <typename Queue>
+class RingQueueTest : public ::testing::Test {
+};
+
+using RingQueueTypes = ::testing::Types<SpscRingQueue<u32>, MpscRingQueue<u32> >;
+TYPED_TEST_SUITE(RingQueueTest, RingQueueTypes);
+
+TYPED_TEST(RingQueueTest, FifoUntilFull)
+{
+    TypeParam queue(3);
+    ASSERT_EQ(queue.capacity(), 4u);
+
+    u32 value = 0;
+    ASSERT_FALSE(queue.tryPop(value));
+    ASSERT_TRUE(queue.empty());
+
+    // Wrap around a few times
+    u32 next = 0;
+    u32 expected = 0;
+    for (u32 round = 0; round < 3; ++round) {
+        while (queue.push(next)) {
+            ++next;
+        }
+        ASSERT_EQ(next - expected, 4u);
+
+        while (queue.tryPop(value)) {
+            ASSERT_EQ(value, expected);
+            ++expected;
+        }
+        ASSERT_EQ(expected, next);
+        ASSERT_TRUE(queue.empty());
+    }
+}
+
+TYPED_TEST(RingQueueTest, MovesItemsAcrossThreads)
+{
+    const u32 count = 200000;
+    TypeParam queue(64);
+
+    std::thread producer([&queue, count]() {
+        for (u32 i = 0; i < count; ++i) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    u32 value = 0;
+    for (u32 i = 0; i < count; ++i) {
+        while (!queue.tryPop(value)) {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(value, i);
+    }
+    producer.join();
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST(MpscRingQueue, EveryProducerKeepsItsOrder)
+{
+    const u32 producers = 4;
+    const u32 count = 50000;
+    MpscRingQueue<u32> queue(128);
+
+    std::vector<std::thread> threads;
+    for (u32 p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p, count]() {
+            for (u32 i = 0; i < count; ++i) {
+                while (!queue.push(p * count + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<u32> nextOf(producers, 0);
+    u32 value = 0;
+    for (u32 received = 0; received < producers * count;) {
+        if (!queue.tryPop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        const u32 p = value / count;
+        ASSERT_EQ(value % count, nextOf[p]);
+        ++nextOf[p];
+        ++received;
+    }
+
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    for (u32 p = 0; p < producers; ++p) {
+        ASSERT_EQ(nextOf[p], count);
+    }
+}
+
+TEST(MpscRingQueue, MovesOnlyTypes)
+{
+    MpscRingQueue<std::unique_ptr<u32> > queue(2);
+    ASSERT_TRUE(queue.push(new u32(7)));
+    ASSERT_TRUE(queue.push(std::make_unique<u32>(8)));
+
+    std::unique_ptr<u32> out;
+    ASSERT_TRUE(queue.tryPop(out));
+    ASSERT_EQ(*out, 7u);
+    ASSERT_TRUE(queue.tryPop(out));
+    ASSERT_EQ(*out, 8u);
+}
+
+TEST(BlockingQueue, PopWaitsUntilReleased)
+{
+    const u32 producers = 3;
+    const u32 count = 20000;
+    BlockingQueue<MpscRingQueue<u32> > queue(32);
+
+    std::atomic<u64> sum(0);
+    std::atomic<u32> popped(0);
+    std::thread consumer([&]() {
+        u32 value;
+        while (queue.pop(value)) {
+            sum.fetch_add(value);
+            popped.fetch_add(1);
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (u32 p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, count]() {
+            for (u32 i = 1; i <= count; ++i) {
+                while (!queue.push(i)) {
+                    std::this_thread::yield();
+                }
+                // Let the consumer run dry and sleep now and then
+                if (i % 1000 == 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    queue.release();
+    consumer.join();
+    ASSERT_EQ(popped.load(), producers * count);
+    ASSERT_EQ(sum.load(), u64(producers) * count * (count + 1) / 2);
+
+    // Released and empty, pop doesn't wait anymore
+    u32 value;
+    ASSERT_FALSE(queue.pop(value));
+
+    queue.reopen();
+    ASSERT_TRUE(queue.push(5u));
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(value, 5u);
+}
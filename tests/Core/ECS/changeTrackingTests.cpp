@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Game/ECS/EntitySystem.h>
+
+using namespace BitEngine;
+
+namespace {
+struct TrackedPosition : public Component<TrackedPosition>, public ChangeTrackedComponent {
+    TrackedPosition(float _x = 0)
+        : x(_x)
+    {
+    }
+
+    void setX(float _x)
+    {
+        x = _x;
+        markChanged();
+    }
+
+    float x;
+};
+
+class TrackingEntitySystem : public EntitySystem {
+public:
+    TrackingEntitySystem(BaseComponentHolder::StorageMode mode)
+    {
+        registerComponent<TrackedPosition>(mode);
+        init();
+    }
+};
+
+// Components changed since the last call, in handle order
+class ChangeReader {
+public:
+    ChangeReader(ComponentHolder<TrackedPosition>* holder)
+        : m_holder(holder)
+        , m_since(0)
+    {
+    }
+
+    std::vector<ComponentHandle> read()
+    {
+        std::vector<ComponentHandle> changed;
+        const u32 since = m_since;
+        m_since = m_holder->advanceChangeVersion();
+        m_holder->forEachChangedComponent(since, [&](ComponentHandle id, TrackedPosition*) {
+            changed.emplace_back(id);
+        });
+        return changed;
+    }
+
+private:
+    ComponentHolder<TrackedPosition>* m_holder;
+    u32 m_since;
+};
+}
+
+TEST(ChangeTracking, OnlyChangedComponentsAreVisited)
+{
+    TrackingEntitySystem es(BaseComponentHolder::StorageMode::STABLE);
+    std::vector<ComponentRef<TrackedPosition> > refs;
+    for (u32 i = 0; i < 1000; ++i) {
+        refs.emplace_back(es.addComponent<TrackedPosition>(es.createEntity(), (float)i));
+    }
+
+    ChangeReader reader(es.getHolder<TrackedPosition>());
+    ASSERT_EQ(reader.read().size(), 1000u); // new components are changed
+    ASSERT_TRUE(reader.read().empty());
+
+    refs[10]->setX(1.0f);
+    refs[700]->setX(2.0f);
+    refs[10]->setX(3.0f);
+    ASSERT_EQ(reader.read(), std::vector<ComponentHandle>({ refs[10].getComponentID(), refs[700].getComponentID() }));
+    ASSERT_TRUE(reader.read().empty());
+
+    // Direct writes are flagged on the holder
+    refs[5]->x = 5.0f;
+    es.getHolder<TrackedPosition>()->markChanged(refs[5].getComponentID());
+
+    // Copies are not bound, assigning to a component flags it
+    TrackedPosition copy = refs[20].ref();
+    copy.setX(6.0f);
+    refs[30].ref() = copy;
+    ASSERT_EQ(reader.read(), std::vector<ComponentHandle>({ refs[5].getComponentID(), refs[30].getComponentID() }));
+    ASSERT_EQ(refs[30]->x, 6.0f);
+}
+
+TEST(ChangeTracking, ReadersKeepTheirOwnVersion)
+{
+    TrackingEntitySystem es(BaseComponentHolder::StorageMode::STABLE);
+    ComponentRef<TrackedPosition> a = es.addComponent<TrackedPosition>(es.createEntity());
+    ComponentRef<TrackedPosition> b = es.addComponent<TrackedPosition>(es.createEntity());
+
+    ChangeReader first(es.getHolder<TrackedPosition>());
+    ChangeReader second(es.getHolder<TrackedPosition>());
+    ASSERT_EQ(first.read().size(), 2u);
+
+    a->setX(1.0f);
+    ASSERT_EQ(first.read(), std::vector<ComponentHandle>({ a.getComponentID() }));
+
+    b->setX(1.0f);
+    ASSERT_EQ(second.read().size(), 2u);
+    ASSERT_EQ(first.read(), std::vector<ComponentHandle>({ b.getComponentID() }));
+}
+
+TEST(ChangeTracking, PackedRelocationKeepsTracking)
+{
+    TrackingEntitySystem es(BaseComponentHolder::StorageMode::PACKED);
+    std::vector<EntityHandle> entities = es.createEntities(300, TrackedPosition(1.0f));
+    EntityCommandBuffer& commands = es.getCommandBuffer();
+    commands.addComponent<TrackedPosition>(commands.createEntity(), 2.0f);
+    es.destroyPending();
+
+    ChangeReader reader(es.getHolder<TrackedPosition>());
+    ASSERT_EQ(reader.read().size(), 301u);
+
+    // Destroying the first entities moves the last components into their slots
+    for (u32 i = 0; i < 50; ++i) {
+        es.destroyEntity(entities[i]);
+    }
+    es.destroyPending();
+    ASSERT_TRUE(reader.read().empty());
+
+    ComponentRef<TrackedPosition> last = es.getComponentRef<TrackedPosition>(entities.back());
+    last->setX(4.0f);
+    ASSERT_EQ(reader.read(), std::vector<ComponentHandle>({ last.getComponentID() }));
+}
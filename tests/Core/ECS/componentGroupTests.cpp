@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Game/ECS/EntityCommandBuffer.h>
+#include <BitEngine/Game/ECS/EntitySystem.h>
+
+using namespace BitEngine;
+
+namespace {
+struct GroupPosition : public Component<GroupPosition> {
+    GroupPosition(float _x = 0)
+        : x(_x)
+    {
+    }
+    float x;
+};
+
+struct GroupName : public Component<GroupName> {
+    GroupName(const std::string& n = "")
+        : name(n)
+    {
+    }
+    std::string name;
+};
+
+struct GroupVelocity : public Component<GroupVelocity> {
+    GroupVelocity(float _v = 0)
+        : v(_v)
+    {
+    }
+    float v;
+};
+
+class GroupEntitySystem : public EntitySystem {
+public:
+    GroupEntitySystem()
+    {
+        registerComponent<GroupPosition>(BaseComponentHolder::StorageMode::PACKED);
+        registerComponent<GroupName>(BaseComponentHolder::StorageMode::PACKED);
+        registerComponent<GroupVelocity>();
+        init();
+    }
+};
+
+// Every grouped entity must be visited once, with its own components
+void checkGroup(GroupEntitySystem& es, std::vector<EntityHandle> expected)
+{
+    std::vector<EntityHandle> visited;
+    es.group<GroupPosition, GroupName>().each([&](ComponentRef<GroupPosition> pos, ComponentRef<GroupName> name) {
+        ASSERT_EQ(pos.getEntity(), name.getEntity());
+        ASSERT_EQ(es.getComponentRef<GroupPosition>(pos.getEntity())->x, pos->x);
+        ASSERT_EQ(name->name, std::to_string(static_cast<u32>(pos->x)));
+        visited.emplace_back(pos.getEntity());
+    });
+
+    std::sort(visited.begin(), visited.end());
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(visited, expected);
+}
+}
+
+TEST(ComponentGroup, RequiresPackedHolders)
+{
+    GroupEntitySystem es;
+    ASSERT_FALSE((es.createGroup<GroupPosition, GroupVelocity>()));
+    ASSERT_TRUE((es.createGroup<GroupPosition, GroupName>()));
+    // A type belongs to one group at most
+    ASSERT_FALSE(es.createGroup<GroupName>());
+}
+
+TEST(ComponentGroup, TracksAddAndRemove)
+{
+    GroupEntitySystem es;
+    ASSERT_TRUE((es.createGroup<GroupPosition, GroupName>()));
+
+    std::vector<EntityHandle> grouped;
+    std::vector<EntityHandle> all;
+    for (u32 i = 0; i < 1000; ++i) {
+        EntityHandle e = es.createEntity();
+        all.emplace_back(e);
+        es.addComponent<GroupPosition>(e, (float)i);
+        if (i % 3 != 0) {
+            ComponentRef<GroupName> name = es.addComponent<GroupName>(e, std::to_string(i));
+            // The returned component is already in place
+            ASSERT_EQ(name->name, std::to_string(i));
+            grouped.emplace_back(e);
+        }
+    }
+    checkGroup(es, grouped);
+
+    // Leave by removing a component
+    for (u32 i = 1; i < all.size(); i += 6) {
+        es.RemoveComponent<GroupName>(all[i], es.getComponentRef<GroupName>(all[i]));
+        grouped.erase(std::find(grouped.begin(), grouped.end(), all[i]));
+    }
+    checkGroup(es, grouped);
+
+    // Leave by destroying the entity
+    for (u32 i = 2; i < all.size(); i += 7) {
+        es.destroyEntity(all[i]);
+        auto it = std::find(grouped.begin(), grouped.end(), all[i]);
+        if (it != grouped.end()) {
+            grouped.erase(it);
+        }
+    }
+    es.destroyPending();
+    checkGroup(es, grouped);
+    ASSERT_EQ((es.group<GroupPosition, GroupName>().getRangeSize()), grouped.size());
+}
+
+TEST(ComponentGroup, GroupsExistingAndDeferredEntities)
+{
+    GroupEntitySystem es;
+    std::vector<EntityHandle> grouped = es.createEntities(300, GroupPosition(7), GroupName("7"));
+    EntityHandle alone = es.createEntity();
+    es.addComponent<GroupPosition>(alone, 1.0f);
+
+    ASSERT_TRUE((es.createGroup<GroupPosition, GroupName>()));
+    checkGroup(es, grouped);
+
+    // Batch creation and command buffers join the group too
+    std::vector<EntityHandle> batch = es.createEntities(200, GroupPosition(8), GroupName("8"));
+    grouped.insert(grouped.end(), batch.begin(), batch.end());
+    es.getCommandBuffer().addComponent<GroupName>(alone, "1");
+    es.destroyPending();
+    grouped.emplace_back(alone);
+    checkGroup(es, grouped);
+}
+
+TEST(ComponentGroup, EachInRangeSplitsTheGroup)
+{
+    GroupEntitySystem es;
+    ASSERT_TRUE((es.createGroup<GroupPosition, GroupName>()));
+    es.createEntities(1000, GroupPosition(3), GroupName("3"));
+
+    EntityGroup<GroupPosition, GroupName> group = es.group<GroupPosition, GroupName>();
+    u32 visited = 0;
+    for (u32 first = 0; first < group.getRangeSize(); first += 77) {
+        group.eachInRange(first, first + 77, [&visited](ComponentRef<GroupPosition>, ComponentRef<GroupName>) { ++visited; });
+    }
+    ASSERT_EQ(visited, 1000u);
+}
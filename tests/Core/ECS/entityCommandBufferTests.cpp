@@ -0,0 +1,141 @@
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Game/ECS/EntitySystem.h>
+
+using namespace BitEngine;
+
+namespace {
+struct CmdPosition : public Component<CmdPosition> {
+    CmdPosition(float _x = 0)
+        : x(_x)
+    {
+    }
+    float x;
+};
+
+struct CmdName : public Component<CmdName> {
+    CmdName(const std::string& n = "")
+        : name(n)
+    {
+    }
+    std::string name;
+};
+
+// Counts live instances, to check staged components are destroyed
+struct CmdTracked : public Component<CmdTracked> {
+    CmdTracked(std::shared_ptr<int> c = nullptr)
+        : counter(c)
+    {
+    }
+    std::shared_ptr<int> counter;
+};
+
+class CmdEntitySystem : public EntitySystem {
+public:
+    CmdEntitySystem()
+    {
+        registerComponent<CmdPosition>();
+        registerComponent<CmdName>(BaseComponentHolder::StorageMode::PACKED);
+        registerComponent<CmdTracked>();
+        init();
+    }
+};
+}
+
+TEST(EntityCommandBuffer, NothingChangesUntilPlayback)
+{
+    CmdEntitySystem es;
+    EntityHandle existing = es.createEntity();
+    es.addComponent<CmdPosition>(existing, 1.0f);
+
+    EntityCommandBuffer& commands = es.getCommandBuffer();
+    DeferredEntity spawned = commands.createEntity();
+    commands.addComponent<CmdPosition>(spawned, 5.0f);
+    commands.addComponent<CmdName>(spawned, "spawned");
+    commands.addComponent<CmdName>(existing, "existing");
+    commands.removeComponent<CmdPosition>(existing);
+
+    ASSERT_FALSE(commands.empty());
+    ASSERT_EQ(es.getNumberOfValidComponents<CmdPosition>(), 1u);
+    ASSERT_EQ(es.getNumberOfValidComponents<CmdName>(), 0u);
+
+    es.destroyPending();
+    ASSERT_TRUE(commands.empty());
+
+    const EntityHandle created = commands.getCreatedEntity(spawned);
+    ASSERT_NE(created, existing);
+    ASSERT_EQ(es.getComponentRef<CmdPosition>(created)->x, 5.0f);
+    ASSERT_EQ(es.getComponentRef<CmdName>(created)->name, "spawned");
+    ASSERT_EQ(es.getComponentRef<CmdName>(existing)->name, "existing");
+    ASSERT_FALSE(es.getComponentRef<CmdPosition>(existing).isValid());
+}
+
+TEST(EntityCommandBuffer, DestroyWhileIterating)
+{
+    CmdEntitySystem es;
+    for (u32 i = 0; i < 100; ++i) {
+        es.addComponent<CmdPosition>(es.createEntity(), (float)i);
+    }
+
+    es.view<CmdPosition>().each([&](ComponentRef<CmdPosition> pos) {
+        if ((u32)pos->x % 2 == 0) {
+            es.getCommandBuffer().destroyEntity(es.getHolder<CmdPosition>()->getEntityForComponent(pos.getComponentID()));
+        }
+    });
+    ASSERT_EQ(es.getNumberOfValidComponents<CmdPosition>(), 100u);
+
+    es.destroyPending();
+    ASSERT_EQ(es.getNumberOfValidComponents<CmdPosition>(), 50u);
+}
+
+TEST(EntityCommandBuffer, RecordFromWorkerThreads)
+{
+    GeneralTaskManager taskManager;
+    CmdEntitySystem es;
+    es.setTaskManager(&taskManager);
+    for (u32 i = 0; i < 10000; ++i) {
+        es.addComponent<CmdPosition>(es.createEntity(), (float)i);
+    }
+
+    // Every entity spawns a named entity, the spawning may happen on any thread
+    es.parallelForEach<CmdPosition>(128, [&](ComponentRef<CmdPosition> pos) {
+        EntityCommandBuffer& commands = es.getCommandBuffer();
+        DeferredEntity e = commands.createEntity();
+        commands.addComponent<CmdName>(e, std::to_string((u32)pos->x));
+    });
+
+    es.destroyPending();
+    ASSERT_EQ(es.getNumberOfValidComponents<CmdName>(), 10000u);
+
+    std::vector<bool> seen(10000, false);
+    es.view<CmdName>().each([&](ComponentRef<CmdName> name) {
+        const u32 i = std::stoul(name->name);
+        ASSERT_FALSE(seen[i]);
+        seen[i] = true;
+    });
+}
+
+TEST(EntityCommandBuffer, ClearDestroysStagedComponents)
+{
+    std::shared_ptr<int> counter = std::make_shared<int>(0);
+    {
+        CmdEntitySystem es;
+        EntityCommandBuffer& commands = es.getCommandBuffer();
+        for (u32 i = 0; i < 1000; ++i) {
+            commands.addComponent<CmdTracked>(commands.createEntity(), counter);
+        }
+        ASSERT_EQ(counter.use_count(), 1001);
+
+        commands.clear();
+        ASSERT_EQ(counter.use_count(), 1);
+
+        // Buffer memory is reused after a clear
+        commands.addComponent<CmdTracked>(commands.createEntity(), counter);
+        es.destroyPending();
+        ASSERT_EQ(counter.use_count(), 2);
+    }
+}
@@ -0,0 +1,457 @@
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Game/ECS/EntitySystem.h>
+
+using namespace BitEngine;
+
+namespace {
+struct TestPosition : public Component<TestPosition> {
+    TestPosition(float _x = 0)
+        : x(_x)
+    {
+    }
+    float x;
+};
+
+struct TestVelocity : public Component<TestVelocity> {
+    TestVelocity(float _v = 0)
+        : v(_v)
+    {
+    }
+    float v;
+};
+
+struct TestName : public Component<TestName> {
+    TestName(const std::string& n = "")
+        : name(n)
+    {
+    }
+    std::string name;
+};
+
+template <u32 I>
+struct ManyComp : public Component<ManyComp<I> > {
+    ManyComp(u32 _v = 0)
+        : v(_v)
+    {
+    }
+    u32 v;
+};
+
+class TestEntitySystem : public EntitySystem {
+public:
+    TestEntitySystem()
+    {
+        registerComponent<TestPosition>();
+        registerComponent<TestVelocity>();
+        init();
+    }
+};
+
+// Registers more component types than fit in a single 64 bit mask
+class ManyTypesEntitySystem : public EntitySystem {
+public:
+    static constexpr u32 TYPE_COUNT = 80;
+
+    ManyTypesEntitySystem()
+    {
+        registerAll(std::make_index_sequence<TYPE_COUNT>());
+        init();
+    }
+
+private:
+    template <size_t... I>
+    void registerAll(std::index_sequence<I...>)
+    {
+        (registerComponent<ManyComp<I> >(), ...);
+    }
+};
+
+// Counts the live instances, to check removed components are destroyed
+struct TestCounted : public Component<TestCounted> {
+    static int alive;
+
+    TestCounted(u32 _v = 0)
+        : v(_v)
+    {
+        ++alive;
+    }
+    TestCounted(const TestCounted& other)
+        : v(other.v)
+    {
+        ++alive;
+    }
+    TestCounted(TestCounted&& other)
+        : v(other.v)
+    {
+        ++alive;
+    }
+    ~TestCounted() { --alive; }
+
+    u32 v;
+};
+int TestCounted::alive = 0;
+
+class PackedEntitySystem : public EntitySystem {
+public:
+    PackedEntitySystem()
+    {
+        registerComponent<TestPosition>(BaseComponentHolder::StorageMode::PACKED);
+        registerComponent<TestName>(BaseComponentHolder::StorageMode::PACKED);
+        registerComponent<TestVelocity>();
+        init();
+    }
+};
+}
+
+TEST(EntitySystem, ViewMatchesForEach)
+{
+    TestEntitySystem es;
+    std::vector<EntityHandle> entities;
+    for (u32 i = 0; i < 1000; ++i) {
+        EntityHandle e = es.createEntity();
+        es.addComponent<TestPosition>(e, (float)i);
+        if (i % 4 == 0) {
+            es.addComponent<TestVelocity>(e, 2.0f);
+        }
+        entities.emplace_back(e);
+    }
+
+    // Create some holes
+    for (u32 i = 0; i < entities.size(); i += 10) {
+        es.RemoveComponent<TestPosition>(entities[i], es.getComponentRef<TestPosition>(entities[i]));
+    }
+
+    std::vector<ComponentHandle> fromForEach;
+    es.forEach<TestPosition, TestVelocity>([&](ComponentRef<TestPosition> pos, ComponentRef<TestVelocity>) {
+        fromForEach.emplace_back(pos.getComponentID());
+    });
+
+    std::vector<ComponentHandle> fromView;
+    es.view<TestPosition, TestVelocity>().each([&](ComponentRef<TestPosition> pos, ComponentRef<TestVelocity> vel) {
+        ASSERT_EQ(vel->v, 2.0f);
+        fromView.emplace_back(pos.getComponentID());
+    });
+
+    ASSERT_FALSE(fromView.empty());
+    ASSERT_EQ(fromForEach, fromView);
+}
+
+TEST(EntitySystem, ViewSingleComponentSkipsReleased)
+{
+    TestEntitySystem es;
+    std::vector<EntityHandle> entities;
+    for (u32 i = 0; i < 300; ++i) {
+        EntityHandle e = es.createEntity();
+        es.addComponent<TestPosition>(e, 1.0f);
+        entities.emplace_back(e);
+    }
+
+    for (u32 i = 0; i < entities.size(); i += 3) {
+        es.RemoveComponent<TestPosition>(entities[i], es.getComponentRef<TestPosition>(entities[i]));
+    }
+
+    u32 visited = 0;
+    es.view<TestPosition>().each([&](ComponentRef<TestPosition> pos) {
+        ASSERT_TRUE(pos.isValid());
+        ++visited;
+    });
+    ASSERT_EQ(visited, es.getNumberOfValidComponents<TestPosition>());
+    ASSERT_EQ(visited, 200u);
+}
+
+TEST(EntitySystem, PackedSwapRemoveKeepsComponents)
+{
+    PackedEntitySystem es;
+    std::vector<EntityHandle> entities;
+    for (u32 i = 0; i < 1000; ++i) {
+        EntityHandle e = es.createEntity();
+        es.addComponent<TestPosition>(e, (float)i);
+        es.addComponent<TestName>(e, std::to_string(i));
+        entities.emplace_back(e);
+    }
+
+    for (u32 i = 0; i < entities.size(); i += 3) {
+        es.destroyEntity(entities[i]);
+    }
+    es.destroyPending();
+
+    ASSERT_EQ(es.getNumberOfValidComponents<TestPosition>(), 666u);
+    for (u32 i = 0; i < entities.size(); ++i) {
+        ComponentRef<TestPosition> pos = es.getComponentRef<TestPosition>(entities[i]);
+        if (i % 3 == 0) {
+            ASSERT_FALSE(pos.isValid());
+        }
+        else {
+            ASSERT_EQ(pos->x, (float)i);
+            ASSERT_EQ(es.getComponentRef<TestName>(entities[i])->name, std::to_string(i));
+        }
+    }
+
+    // Packed storage is visited linearly and has no holes
+    u32 visited = 0;
+    es.view<TestPosition, TestName>().each([&](ComponentRef<TestPosition> pos, ComponentRef<TestName> name) {
+        ASSERT_EQ(name->name, std::to_string((u32)pos->x));
+        ++visited;
+    });
+    ASSERT_EQ(visited, 666u);
+
+    visited = 0;
+    es.forAll<TestPosition>([&](ComponentHandle id, TestPosition& pos) {
+        ASSERT_EQ(es.getHolder<TestPosition>()->getComponent(id), &pos);
+        ++visited;
+    });
+    ASSERT_EQ(visited, 666u);
+}
+
+TEST(EntitySystem, ReleasedComponentsAreDestroyed)
+{
+    const BaseComponentHolder::StorageMode modes[] = { BaseComponentHolder::StorageMode::STABLE, BaseComponentHolder::StorageMode::PACKED };
+    for (const BaseComponentHolder::StorageMode mode : modes) {
+        TestCounted::alive = 0;
+        EntitySystem es;
+        es.registerComponent<TestCounted>(mode);
+        es.init();
+
+        std::vector<EntityHandle> entities;
+        std::vector<ComponentHandle> handles;
+        for (u32 i = 0; i < 100; ++i) {
+            EntityHandle e = es.createEntity();
+            handles.emplace_back(es.addComponent<TestCounted>(e, i).getComponentID());
+            entities.emplace_back(e);
+        }
+        ASSERT_EQ(TestCounted::alive, 100);
+
+        // Both the last slot and holes filled by the last component
+        es.RemoveComponent<TestCounted>(entities[99], es.getComponentRef<TestCounted>(entities[99]));
+        for (u32 i = 0; i < 50; i += 2) {
+            es.destroyEntity(entities[i]);
+        }
+        es.destroyPending();
+        ASSERT_EQ(TestCounted::alive, 74);
+
+        for (u32 i = 1; i < 99; i += 2) {
+            ASSERT_EQ(es.getComponentRef<TestCounted>(entities[i])->v, i);
+        }
+        if (mode == BaseComponentHolder::StorageMode::PACKED) {
+            // A released handle doesn't reach the component now in its old slot
+            ASSERT_EQ(es.getHolder<TestCounted>()->getComponent(handles[0]), nullptr);
+        }
+    }
+}
+
+TEST(EntitySystem, PackedChurnReusesEntitiesAndHandles)
+{
+    PackedEntitySystem es;
+    std::vector<EntityHandle> alive;
+    for (u32 frame = 0; frame < 10; ++frame) {
+        for (u32 i = 0; i < 200; ++i) {
+            EntityHandle e = es.createEntity();
+            es.addComponent<TestPosition>(e, (float)e);
+            alive.emplace_back(e);
+        }
+
+        // Despawn half of the entities every frame
+        for (u32 i = 0; i < alive.size(); i += 2) {
+            es.destroyEntity(alive[i]);
+        }
+        es.destroyPending();
+
+        std::vector<EntityHandle> survivors;
+        for (u32 i = 1; i < alive.size(); i += 2) {
+            survivors.emplace_back(alive[i]);
+        }
+        alive.swap(survivors);
+
+        u32 visited = 0;
+        es.view<TestPosition>().each([&](ComponentRef<TestPosition> pos) {
+            ASSERT_EQ(pos->x, (float)es.getHolder<TestPosition>()->getEntityForComponent(pos.getComponentID()));
+            ++visited;
+        });
+        ASSERT_EQ(visited, alive.size());
+    }
+
+    // Destroyed entities are recycled, so indices stay bounded
+    for (EntityHandle e : alive) {
+        ASSERT_LT(getEntityIndex(e), 400u);
+    }
+}
+
+TEST(EntitySystem, ParallelForEachVisitsEveryMatchOnce)
+{
+    GeneralTaskManager taskManager;
+    const BaseComponentHolder::StorageMode modes[] = { BaseComponentHolder::StorageMode::STABLE, BaseComponentHolder::StorageMode::PACKED };
+
+    for (BaseComponentHolder::StorageMode mode : modes) {
+        EntitySystem es;
+        es.registerComponent<TestPosition>(mode);
+        es.registerComponent<TestVelocity>(mode);
+        es.init();
+        es.setTaskManager(&taskManager);
+
+        std::vector<EntityHandle> entities;
+        for (u32 i = 0; i < 20000; ++i) {
+            EntityHandle e = es.createEntity();
+            es.addComponent<TestPosition>(e, 0.0f);
+            if (i % 2 == 0) {
+                es.addComponent<TestVelocity>(e, (float)i);
+            }
+            entities.emplace_back(e);
+        }
+
+        // Create some holes
+        for (u32 i = 0; i < entities.size(); i += 7) {
+            es.destroyEntity(entities[i]);
+        }
+        es.destroyPending();
+
+        es.parallelForEach<TestPosition, TestVelocity>(256, [](ComponentRef<TestPosition> pos, ComponentRef<TestVelocity> vel) {
+            pos->x += vel->v;
+        });
+
+        u32 visited = 0;
+        es.view<TestPosition>().each([&](ComponentRef<TestPosition> pos) {
+            ComponentRef<TestVelocity> vel = es.getComponentRef<TestVelocity>(es.getHolder<TestPosition>()->getEntityForComponent(pos.getComponentID()));
+            ASSERT_EQ(pos->x, vel.isValid() ? vel->v : 0.0f);
+            visited += vel.isValid() ? 1 : 0;
+        });
+        ASSERT_EQ(visited, es.getNumberOfValidComponents<TestVelocity>());
+    }
+}
+
+TEST(EntitySystem, ParallelForEachWithoutTaskManagerRunsInline)
+{
+    TestEntitySystem es;
+    for (u32 i = 0; i < 1000; ++i) {
+        es.addComponent<TestPosition>(es.createEntity(), 1.0f);
+    }
+
+    const std::thread::id caller = std::this_thread::get_id();
+    u32 visited = 0;
+    es.parallelForEach<TestPosition>(16, [&](ComponentRef<TestPosition>) {
+        ASSERT_EQ(std::this_thread::get_id(), caller);
+        ++visited;
+    });
+    ASSERT_EQ(visited, 1000u);
+}
+
+TEST(EntitySystem, CreateEntitiesCopiesPrototypes)
+{
+    PackedEntitySystem es;
+
+    // Leave some released entities to be reused by the batch
+    std::vector<EntityHandle> old;
+    for (u32 i = 0; i < 10; ++i) {
+        old.emplace_back(es.createEntity());
+        es.addComponent<TestPosition>(old.back(), -1.0f);
+    }
+    for (u32 i = 0; i < old.size(); i += 2) {
+        es.destroyEntity(old[i]);
+    }
+    es.destroyPending();
+
+    u32 entityMessages = 0;
+    u32 createdEntities = 0;
+    Messenger<MsgEntitiesCreated>::ScopedSubscription entitiesSub(es, [&](const MsgEntitiesCreated& msg) {
+        ++entityMessages;
+        createdEntities += msg.count;
+    });
+    u32 positionMessages = 0;
+    Messenger<MsgComponentsCreated<TestPosition> >::ScopedSubscription positionsSub(es.getHolder<TestPosition>()->componentsCreatedSignal,
+        [&](const MsgComponentsCreated<TestPosition>& msg) {
+            ++positionMessages;
+            for (u32 i = 0; i < msg.count; ++i) {
+                ASSERT_EQ(es.getHolder<TestPosition>()->getComponentForEntity(msg.entities[i]), msg.components[i]);
+                ASSERT_EQ(es.getHolder<TestPosition>()->getComponent(msg.components[i])->x, 3.0f);
+            }
+        });
+
+    const std::vector<EntityHandle> entities = es.createEntities(1000, TestPosition(3.0f), TestName("batch"));
+    ASSERT_EQ(entities.size(), 1000u);
+    ASSERT_EQ(entityMessages, 1u);
+    ASSERT_EQ(createdEntities, 1000u);
+    ASSERT_EQ(positionMessages, 1u);
+
+    for (EntityHandle e : entities) {
+        ASSERT_EQ(es.getComponentRef<TestPosition>(e)->x, 3.0f);
+        ASSERT_EQ(es.getComponentRef<TestName>(e)->name, "batch");
+        ASSERT_FALSE(es.getComponentRef<TestVelocity>(e).isValid());
+    }
+    for (u32 i = 0; i < old.size(); i += 2) {
+        ASSERT_NE(std::find_if(entities.begin(), entities.end(), [&](EntityHandle e) { return getEntityIndex(e) == getEntityIndex(old[i]); }), entities.end());
+    }
+
+    ASSERT_EQ(es.getNumberOfValidComponents<TestPosition>(), 1005u);
+    u32 matches = 0;
+    es.view<TestPosition, TestName>().each([&](ComponentRef<TestPosition>, ComponentRef<TestName>) {
+        ++matches;
+    });
+    ASSERT_EQ(matches, 1000u);
+}
+
+TEST(EntitySystem, StaleHandlesStayInvalid)
+{
+    TestEntitySystem es;
+    EntityHandle first = es.createEntity();
+    ComponentRef<TestPosition> firstPos = es.addComponent<TestPosition>(first, 1.0f);
+    ASSERT_TRUE(es.isValid(firstPos));
+
+    es.destroyEntity(first);
+    es.destroyPending();
+    ASSERT_FALSE(es.isValid(firstPos));
+
+    // The new entity reuses the index and the component handle
+    EntityHandle second = es.createEntity();
+    ComponentRef<TestPosition> secondPos = es.addComponent<TestPosition>(second, 2.0f);
+    ASSERT_EQ(getEntityIndex(second), getEntityIndex(first));
+    ASSERT_EQ(secondPos.getComponentID(), firstPos.getComponentID());
+    ASSERT_NE(second, first);
+
+    ASSERT_FALSE(es.isValid(firstPos));
+    ASSERT_TRUE(es.isValid(secondPos));
+    ASSERT_FALSE(es.getComponentRef<TestPosition>(first).isValid());
+    ASSERT_EQ(es.getComponentRef<TestPosition>(second)->x, 2.0f);
+
+    // Removing the component invalidates references to it
+    es.RemoveComponent<TestPosition>(second, secondPos);
+    ASSERT_FALSE(es.isValid(secondPos));
+}
+
+TEST(EntitySystem, MoreThan64ComponentTypes)
+{
+    ManyTypesEntitySystem es;
+    ASSERT_GE(ManyComp<ManyTypesEntitySystem::TYPE_COUNT - 1>::getComponentType(), 64u);
+
+    for (u32 i = 0; i < 100; ++i) {
+        EntityHandle entity = es.createEntity();
+        es.addComponent<ManyComp<0> >(entity, i);
+        if (i % 2 == 0) {
+            es.addComponent<ManyComp<ManyTypesEntitySystem::TYPE_COUNT - 1> >(entity, i);
+        }
+        if (i % 4 == 0) {
+            es.addComponent<ManyComp<70> >(entity, i);
+        }
+    }
+
+    u32 matches = 0;
+    es.view<ManyComp<0>, ManyComp<ManyTypesEntitySystem::TYPE_COUNT - 1>, ManyComp<70> >().each(
+        [&](ComponentRef<ManyComp<0> > a, ComponentRef<ManyComp<ManyTypesEntitySystem::TYPE_COUNT - 1> > b, ComponentRef<ManyComp<70> > c) {
+            ASSERT_EQ(a->v % 4, 0u);
+            ASSERT_EQ(a->v, b->v);
+            ASSERT_EQ(a->v, c->v);
+            ++matches;
+        });
+    ASSERT_EQ(matches, 25u);
+
+    matches = 0;
+    es.forEach<ManyComp<0>, ManyComp<ManyTypesEntitySystem::TYPE_COUNT - 1> >(
+        [&](ComponentRef<ManyComp<0> >, ComponentRef<ManyComp<ManyTypesEntitySystem::TYPE_COUNT - 1> >) {
+            ++matches;
+        });
+    ASSERT_EQ(matches, 50u);
+}
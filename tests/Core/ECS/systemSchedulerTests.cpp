@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Game/ECS/SystemScheduler.h>
+
+using namespace BitEngine;
+
+namespace {
+struct SchedPosition : public Component<SchedPosition> {
+};
+
+struct SchedVelocity : public Component<SchedVelocity> {
+};
+
+struct SchedHealth : public Component<SchedHealth> {
+};
+
+class ExecutionLog {
+public:
+    void add(u32 system)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_order.emplace_back(system);
+    }
+
+    // Position of the system in the execution order
+    u32 at(u32 system)
+    {
+        return std::find(m_order.begin(), m_order.end(), system) - m_order.begin();
+    }
+
+    std::vector<u32> m_order;
+
+private:
+    std::mutex m_mutex;
+};
+}
+
+TEST(SystemScheduler, ConflictingSystemsKeepRegistrationOrder)
+{
+    ExecutionLog log;
+    SystemScheduler scheduler;
+    scheduler.addSystem("Move", [&]() { log.add(0); }).reads<SchedVelocity>().writes<SchedPosition>();
+    scheduler.addSystem("Damage", [&]() { log.add(1); }).writes<SchedHealth>();
+    scheduler.addSystem("Render", [&]() { log.add(2); }).reads<SchedPosition, SchedHealth>();
+    scheduler.addSystem("Accelerate", [&]() { log.add(3); }).writes<SchedVelocity>();
+
+    scheduler.run();
+    ASSERT_EQ(log.m_order, std::vector<u32>({ 0, 1, 2, 3 }));
+
+    // Move and Damage don't conflict, Render waits for both, Accelerate waits for Move
+    const std::string dump = scheduler.dumpSchedule();
+    EXPECT_NE(dump.find("[0] Move"), std::string::npos);
+    EXPECT_NE(dump.find("[0] Damage"), std::string::npos);
+    EXPECT_NE(dump.find("[1] Render"), std::string::npos);
+    EXPECT_NE(dump.find("[1] Accelerate"), std::string::npos);
+    EXPECT_NE(dump.find("after: Move Damage\n"), std::string::npos);
+}
+
+TEST(SystemScheduler, ReadersDontConflict)
+{
+    SystemScheduler scheduler;
+    scheduler.addSystem("A", []() {}).reads<SchedPosition>();
+    scheduler.addSystem("B", []() {}).reads<SchedPosition>();
+    scheduler.addSystem("C", []() {}).exclusive();
+    scheduler.addSystem("D", []() {}).reads<SchedHealth>();
+
+    const std::string dump = scheduler.dumpSchedule();
+    EXPECT_NE(dump.find("[0] A"), std::string::npos);
+    EXPECT_NE(dump.find("[0] B"), std::string::npos);
+    EXPECT_NE(dump.find("[1] C (exclusive)"), std::string::npos);
+    EXPECT_NE(dump.find("[2] D"), std::string::npos);
+}
+
+TEST(SystemScheduler, ParallelRunRespectsDependencies)
+{
+    GeneralTaskManager taskManager;
+    SystemScheduler scheduler(&taskManager);
+
+    ExecutionLog log;
+    std::atomic<u32> runs(0);
+    const std::thread::id caller = std::this_thread::get_id();
+
+    scheduler.addSystem("WritePosition", [&]() { log.add(0); ++runs; }).writes<SchedPosition>();
+    scheduler.addSystem("WriteVelocity", [&]() { log.add(1); ++runs; }).writes<SchedVelocity>();
+    scheduler.addSystem("WriteHealth", [&]() { log.add(2); ++runs; }).writes<SchedHealth>();
+    scheduler.addSystem("ReadAll", [&]() { log.add(3); ++runs; }).reads<SchedPosition, SchedVelocity, SchedHealth>();
+    scheduler.addSystem("Main", [&]() {
+                 EXPECT_EQ(std::this_thread::get_id(), caller);
+                 log.add(4);
+                 ++runs;
+             })
+        .reads<SchedHealth>()
+        .mainThread();
+    scheduler.addSystem("WritePositionAgain", [&]() { log.add(5); ++runs; }).writes<SchedPosition>();
+
+    for (u32 frame = 0; frame < 100; ++frame) {
+        log.m_order.clear();
+        scheduler.run();
+
+        ASSERT_EQ(log.m_order.size(), 6u);
+        ASSERT_LT(log.at(0), log.at(3));
+        ASSERT_LT(log.at(1), log.at(3));
+        ASSERT_LT(log.at(2), log.at(3));
+        ASSERT_LT(log.at(2), log.at(4));
+        ASSERT_LT(log.at(3), log.at(5));
+    }
+    ASSERT_EQ(runs, 600u);
+}
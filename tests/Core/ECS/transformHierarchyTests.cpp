@@ -0,0 +1,205 @@
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Game/ECS/TransformHierarchy.h>
+
+using namespace BitEngine;
+
+namespace {
+// Visits every node and checks each parent is visited before its children
+std::vector<ComponentHandle> visitAll(const TransformHierarchy& hierarchy, u32 maxHandle)
+{
+    std::vector<u32> slots;
+    for (ComponentHandle h = 1; h <= maxHandle; ++h) {
+        slots.emplace_back(hierarchy.getSlot(h));
+    }
+
+    std::vector<ComponentHandle> visited;
+    std::map<ComponentHandle, bool> seen;
+    hierarchy.updateSubtrees(slots, [&](ComponentHandle node, ComponentHandle parent) {
+        EXPECT_FALSE(seen[node]);
+        EXPECT_TRUE(parent == 0 || seen[parent]) << "node " << node << " before parent " << parent;
+        seen[node] = true;
+        visited.emplace_back(node);
+    });
+    return visited;
+}
+}
+
+TEST(TransformHierarchy, ParentsBeforeChildren)
+{
+    TransformHierarchy hierarchy;
+    for (ComponentHandle h = 1; h <= 6; ++h) {
+        hierarchy.add(h);
+    }
+
+    // 6 -> 5 -> 4, 1 -> 3, 1 -> 2
+    hierarchy.setParent(4, 5);
+    hierarchy.setParent(5, 6);
+    hierarchy.setParent(3, 1);
+    hierarchy.setParent(2, 1);
+
+    ASSERT_EQ(hierarchy.getParent(4), 5u);
+    ASSERT_EQ(hierarchy.getParent(5), 6u);
+    ASSERT_EQ(hierarchy.getParent(6), 0u);
+    ASSERT_EQ(visitAll(hierarchy, 6).size(), 6u);
+
+    std::vector<ComponentHandle> children;
+    hierarchy.forEachChild(1, [&](ComponentHandle c) { children.emplace_back(c); });
+    ASSERT_EQ(children, std::vector<ComponentHandle>({ 3, 2 }));
+
+    // Move a subtree under another node
+    hierarchy.setParent(6, 2);
+    ASSERT_EQ(visitAll(hierarchy, 6).size(), 6u);
+
+    // Only the changed subtree is visited
+    std::vector<u32> changed = { hierarchy.getSlot(5) };
+    std::vector<ComponentHandle> visited;
+    hierarchy.updateSubtrees(changed, [&](ComponentHandle node, ComponentHandle) { visited.emplace_back(node); });
+    ASSERT_EQ(visited, std::vector<ComponentHandle>({ 5, 4 }));
+}
+
+TEST(TransformHierarchy, RemoveGivesChildrenToParent)
+{
+    TransformHierarchy hierarchy;
+    for (ComponentHandle h = 1; h <= 5; ++h) {
+        hierarchy.add(h);
+    }
+    hierarchy.setParent(2, 1);
+    hierarchy.setParent(3, 2);
+    hierarchy.setParent(4, 2);
+
+    hierarchy.remove(2);
+    ASSERT_FALSE(hierarchy.contains(2));
+    ASSERT_EQ(hierarchy.getParent(3), 1u);
+    ASSERT_EQ(hierarchy.getParent(4), 1u);
+    ASSERT_EQ(hierarchy.size(), 4u);
+
+    std::vector<ComponentHandle> children;
+    hierarchy.forEachChild(1, [&](ComponentHandle c) { children.emplace_back(c); });
+    ASSERT_EQ(children, std::vector<ComponentHandle>({ 3, 4 }));
+
+    // Handle is reused by a new component
+    hierarchy.add(2);
+    hierarchy.setParent(2, 4);
+    hierarchy.setParent(1, 5);
+    ASSERT_EQ(visitAll(hierarchy, 5).size(), 5u);
+}
+
+TEST(TransformHierarchy, DeepChainDoesntRecurse)
+{
+    const u32 depth = 20000;
+    TransformHierarchy hierarchy;
+    for (ComponentHandle h = 1; h <= depth; ++h) {
+        hierarchy.add(h);
+        if (h > 1) {
+            hierarchy.setParent(h, h - 1);
+        }
+    }
+
+    std::vector<u32> changed = { hierarchy.getSlot(1) };
+    ComponentHandle expected = 1;
+    hierarchy.updateSubtrees(changed, [&](ComponentHandle node, ComponentHandle parent) {
+        ASSERT_EQ(node, expected);
+        ASSERT_EQ(parent, expected - 1);
+        ++expected;
+    });
+    ASSERT_EQ(expected, depth + 1);
+}
+
+TEST(TransformHierarchy, ManyRemovalsCompact)
+{
+    TransformHierarchy hierarchy;
+    for (ComponentHandle h = 1; h <= 1000; ++h) {
+        hierarchy.add(h);
+        if (h % 10 != 1) {
+            hierarchy.setParent(h, h - 1);
+        }
+    }
+
+    for (ComponentHandle h = 1; h <= 1000; ++h) {
+        if (h % 3 == 0) {
+            hierarchy.remove(h);
+        }
+    }
+    ASSERT_EQ(hierarchy.size(), 667u);
+
+    for (ComponentHandle h = 1; h <= 1000; ++h) {
+        if (h % 3 != 0) {
+            const ComponentHandle parent = hierarchy.getParent(h);
+            ASSERT_TRUE(parent == 0 || hierarchy.contains(parent));
+        }
+    }
+    ASSERT_EQ(visitAll(hierarchy, 1000).size(), 667u);
+}
+
+TEST(TransformHierarchy, DepthFollowsReparenting)
+{
+    TransformHierarchy hierarchy;
+    for (ComponentHandle h = 1; h <= 5; ++h) {
+        hierarchy.add(h);
+    }
+    hierarchy.setParent(3, 2);
+    hierarchy.setParent(4, 3);
+    ASSERT_EQ(hierarchy.getDepth(2), 0u);
+    ASSERT_EQ(hierarchy.getDepth(4), 2u);
+
+    // The whole subtree moves one level down
+    hierarchy.setParent(2, 1);
+    ASSERT_EQ(hierarchy.getDepth(2), 1u);
+    ASSERT_EQ(hierarchy.getDepth(3), 2u);
+    ASSERT_EQ(hierarchy.getDepth(4), 3u);
+
+    // Children of a removed node move up
+    hierarchy.remove(2);
+    ASSERT_EQ(hierarchy.getDepth(3), 1u);
+    ASSERT_EQ(hierarchy.getDepth(4), 2u);
+
+    hierarchy.setParent(3, 0);
+    ASSERT_EQ(hierarchy.getDepth(3), 0u);
+    ASSERT_EQ(hierarchy.getDepth(4), 1u);
+}
+
+TEST(TransformHierarchy, ParallelLevelsUpdateParentsFirst)
+{
+    // Many small trees: a root, 3 children, each with 2 children
+    TransformHierarchy hierarchy;
+    const u32 trees = 2000;
+    const u32 treeSize = 10;
+    for (ComponentHandle h = 1; h <= trees * treeSize; ++h) {
+        hierarchy.add(h);
+    }
+    for (u32 t = 0; t < trees; ++t) {
+        const ComponentHandle root = 1 + t * treeSize;
+        for (u32 c = 0; c < 3; ++c) {
+            const ComponentHandle child = root + 1 + c * 3;
+            hierarchy.setParent(child, root);
+            hierarchy.setParent(child + 1, child);
+            hierarchy.setParent(child + 2, child);
+        }
+    }
+
+    GeneralTaskManager taskManager;
+    for (u32 round = 0; round < 3; ++round) {
+        // value[node] = value[parent] + 1, so it ends as the depth + 1 only if parents go first
+        std::vector<std::atomic<u32> > value(trees * treeSize + 1);
+        std::vector<u32> slots;
+        for (ComponentHandle h = 1; h <= trees * treeSize; ++h) {
+            slots.emplace_back(hierarchy.getSlot(h));
+        }
+
+        hierarchy.parallelUpdateSubtrees(&taskManager, slots, 64, [&](ComponentHandle node, ComponentHandle parent) {
+            const u32 parentValue = parent != 0 ? value[parent].load() : 0;
+            EXPECT_TRUE(parent == 0 || parentValue != 0);
+            EXPECT_EQ(value[node].exchange(parentValue + 1), 0u);
+        });
+
+        for (ComponentHandle h = 1; h <= trees * treeSize; ++h) {
+            ASSERT_EQ(value[h].load(), hierarchy.getDepth(h) + 1);
+        }
+    }
+}
@@ -36,6 +36,8 @@ class MockTaskManager : public BitEngine::TaskManager {
     MOCK_METHOD1(waitTask, void(std::shared_ptr<Task>& task));
 
     MOCK_CONST_METHOD0(getTasks, const std::vector<TaskPtr>&());
+    MOCK_CONST_METHOD0(getWorkerCount, u32());
+    MOCK_CONST_METHOD0(getFrameStats, const TaskFrameStats&());
 
     MOCK_CONST_METHOD0(verifyMainThread, void());
 };
@@ -0,0 +1,30 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/CpuTopology.h>
+
+using namespace BitEngine;
+
+TEST(CpuTopology, CpusSortedByNode)
+{
+    const std::vector<CpuTopology::Cpu> cpus = CpuTopology::getCpus();
+    ASSERT_FALSE(cpus.empty());
+    for (u32 i = 1; i < cpus.size(); ++i) {
+        ASSERT_LE(cpus[i - 1].node, cpus[i].node);
+        if (cpus[i - 1].node == cpus[i].node) {
+            ASSERT_LT(cpus[i - 1].id, cpus[i].id);
+        }
+    }
+}
+
+#if defined(__linux__) || defined(_WIN32)
+TEST(CpuTopology, PinThread)
+{
+    const u32 cpu = CpuTopology::getCpus().back().id;
+    bool pinned = false;
+    std::thread t([&]() { pinned = CpuTopology::pinCurrentThread(cpu); });
+    t.join();
+    ASSERT_TRUE(pinned);
+}
+#endif
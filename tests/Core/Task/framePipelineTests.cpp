@@ -0,0 +1,82 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/FramePipeline.h>
+#include <BitEngine/Core/GeneralTaskManager.h>
+
+using namespace BitEngine;
+
+namespace {
+struct FrameData {
+    u32 frame = 0;
+    std::vector<u32> commands;
+};
+}
+
+TEST(FramePipeline, ConsumesThePreviousFrame)
+{
+    GeneralTaskManager manager;
+    FrameData a, b;
+    FramePipeline<FrameData> pipeline(&manager, &a, &b);
+
+    std::vector<u32> consumed;
+    for (u32 frame = 1; frame <= 100; ++frame) {
+        pipeline.produce([frame](FrameData& data) {
+            EXPECT_TRUE(data.commands.empty());
+            data.frame = frame;
+            data.commands.assign(frame % 7 + 1, frame);
+        });
+
+        FrameData* ready = pipeline.getReadySlot();
+        if (frame == 1) {
+            ASSERT_EQ(ready, nullptr);
+        }
+        else {
+            ASSERT_NE(ready, nullptr);
+            ASSERT_EQ(ready->frame, frame - 1);
+            for (u32 c : ready->commands) {
+                ASSERT_EQ(c, frame - 1);
+            }
+            consumed.emplace_back(ready->frame);
+            ready->commands.clear();
+        }
+
+        pipeline.finishFrame();
+    }
+    ASSERT_EQ(consumed.size(), 99u);
+    ASSERT_EQ(pipeline.getReadySlot()->frame, 100u);
+}
+
+TEST(FramePipeline, ProducerRunsWhileConsuming)
+{
+    GeneralTaskManager manager;
+    FrameData a, b;
+    FramePipeline<FrameData> pipeline(&manager, &a, &b);
+
+    // The main thread only goes on once the producer started on a worker,
+    // it would never happen if they ran one after the other
+    std::atomic<bool> producing(false);
+    pipeline.produce([&producing](FrameData& data) {
+        producing = true;
+        data.frame = 1;
+    });
+    while (!producing.load()) {
+        std::this_thread::yield();
+    }
+    pipeline.finishFrame();
+    ASSERT_EQ(pipeline.getReadySlot()->frame, 1u);
+}
+
+TEST(FramePipeline, WithoutTaskManager)
+{
+    FrameData a, b;
+    FramePipeline<FrameData> pipeline(nullptr, &a, &b);
+
+    pipeline.produce([](FrameData& data) { data.frame = 5; });
+    ASSERT_EQ(pipeline.getReadySlot()->frame, 5u);
+    pipeline.finishFrame();
+    ASSERT_EQ(pipeline.getReadySlot()->frame, 5u);
+}
@@ -0,0 +1,165 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/CpuTopology.h>
+#include <BitEngine/Core/EngineConfiguration.h>
+#include <BitEngine/Core/GeneralTaskManager.h>
+
+using namespace BitEngine;
+
+namespace {
+class CountTask : public Task {
+public:
+    CountTask(std::atomic<u32>& counter, Affinity affinity = Affinity::BACKGROUND)
+        : Task(TaskMode::NONE, affinity)
+        , m_counter(counter)
+    {
+    }
+
+private:
+    void run() override { m_counter.fetch_add(1); }
+
+    std::atomic<u32>& m_counter;
+};
+
+// Adds children from inside a worker, they go to the worker own deque
+class SpawnTask : public Task {
+public:
+    SpawnTask(TaskManager& manager, std::atomic<u32>& counter, u32 children)
+        : Task(TaskMode::NONE, Affinity::BACKGROUND)
+        , m_manager(manager)
+        , m_counter(counter)
+        , m_children(children)
+    {
+    }
+
+private:
+    void run() override
+    {
+        for (u32 i = 0; i < m_children; ++i) {
+            m_manager.addTask(std::make_shared<CountTask>(m_counter));
+        }
+        m_counter.fetch_add(1);
+    }
+
+    TaskManager& m_manager;
+    std::atomic<u32>& m_counter;
+    u32 m_children;
+};
+
+void waitCount(std::atomic<u32>& counter, u32 expected)
+{
+    const auto start = std::chrono::steady_clock::now();
+    while (counter.load() != expected && std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+        std::this_thread::yield();
+    }
+}
+}
+
+TEST(GeneralTaskManager, RunsTasksFromAnyThread)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> counter(0);
+
+    // Main thread deque
+    for (u32 i = 0; i < 1000; ++i) {
+        manager.addTask(std::make_shared<CountTask>(counter));
+    }
+
+    // Worker deques
+    for (u32 i = 0; i < 50; ++i) {
+        manager.addTask(std::make_shared<SpawnTask>(manager, counter, 20));
+    }
+
+    // Thread that is not a worker
+    std::thread other([&]() {
+        for (u32 i = 0; i < 500; ++i) {
+            manager.addTask(std::make_shared<CountTask>(counter));
+        }
+    });
+    other.join();
+
+    const u32 expected = 1000 + 50 * 21 + 500;
+    waitCount(counter, expected);
+    ASSERT_EQ(counter.load(), expected);
+}
+
+TEST(GeneralTaskManager, ParkedWorkersWakeUp)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> counter(0);
+
+    for (u32 round = 1; round <= 5; ++round) {
+        // Long enough for every worker to run out of work and park
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::thread other([&]() { manager.addTask(std::make_shared<CountTask>(counter)); });
+        other.join();
+
+        waitCount(counter, round);
+        ASSERT_EQ(counter.load(), round);
+    }
+}
+
+TEST(GeneralTaskManager, WaitTaskRunsMainTasks)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> counter(0);
+
+    TaskPtr mainTask = std::make_shared<CountTask>(counter, Task::Affinity::MAIN);
+    manager.addTask(mainTask);
+    manager.waitTask(mainTask);
+    ASSERT_EQ(counter.load(), 1u);
+
+    TaskPtr background = std::make_shared<CountTask>(counter);
+    manager.addTask(background);
+    manager.waitTask(background);
+    ASSERT_EQ(counter.load(), 2u);
+}
+
+TEST(GeneralTaskManager, ConfiguredWorkerCount)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 3;
+    GeneralTaskManager manager(configuration);
+    ASSERT_EQ(manager.getWorkerCount(), 3u);
+
+    // Automatic count leaves a CPU to the main thread, but always has a worker
+    GeneralTaskManager automatic;
+    const u32 cpus = static_cast<u32>(CpuTopology::getCpus().size());
+    ASSERT_EQ(automatic.getWorkerCount(), cpus > 1 ? cpus - 1 : 1u);
+}
+
+TEST(GeneralTaskManager, PinnedWorkersRunTasks)
+{
+    // More workers than CPUs in small machines, pinned workers share CPUs then
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 4;
+    configuration.m_PinThreads = true;
+    GeneralTaskManager manager(configuration);
+    std::atomic<u32> counter(0);
+
+    for (u32 i = 0; i < 20; ++i) {
+        manager.addTask(std::make_shared<SpawnTask>(manager, counter, 10));
+    }
+    waitCount(counter, 20 * 11);
+    ASSERT_EQ(counter.load(), 20u * 11);
+}
+
+TEST(GeneralTaskManager, LoadConfiguration)
+{
+    EngineConfiguration engineConfig;
+    TaskManagerConfiguration configuration = GeneralTaskManager::loadConfiguration(engineConfig);
+    ASSERT_EQ(configuration.m_WorkerCount, 0u);
+    ASSERT_FALSE(configuration.m_PinThreads);
+
+    engineConfig.getConfiguration("TaskManager", "Workers", "0")->setValue(std::string("6"));
+    engineConfig.getConfiguration("TaskManager", "PinThreads", "false")->setValue(true);
+    configuration = GeneralTaskManager::loadConfiguration(engineConfig);
+    ASSERT_EQ(configuration.m_WorkerCount, 6u);
+    ASSERT_TRUE(configuration.m_PinThreads);
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Core/ParallelFor.h>
+
+using namespace BitEngine;
+
+TEST(ParallelFor, RangesCoverEverythingOnce)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 3;
+    GeneralTaskManager manager(configuration);
+
+    for (const u32 size : { 1u, 7u, 64u, 1000u, 100003u }) {
+        for (const u32 grain : { 1u, 16u, 1000u }) {
+            std::vector<std::atomic<u32> > visits(size);
+            std::atomic<u32> chunks(0);
+            parallelForRange(&manager, size, grain, [&](u32 first, u32 last) {
+                EXPECT_LT(first, last);
+                EXPECT_EQ(first % grain, 0u);
+                for (u32 i = first; i < last; ++i) {
+                    visits[i].fetch_add(1);
+                }
+                chunks.fetch_add(1);
+            });
+
+            for (u32 i = 0; i < size; ++i) {
+                ASSERT_EQ(visits[i].load(), 1u) << "size " << size << " grain " << grain << " index " << i;
+            }
+            ASSERT_LE(chunks.load(), (size + grain - 1) / grain);
+        }
+    }
+}
+
+TEST(ParallelFor, Indices)
+{
+    GeneralTaskManager manager;
+    std::vector<u32> values(5000, 0);
+
+    parallelFor(&manager, 1000, 4000, 100, [&](u32 i) { values[i] = i * 2; });
+
+    for (u32 i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], i >= 1000 && i < 4000 ? i * 2 : 0u);
+    }
+
+    // Empty range and no task manager
+    parallelFor(&manager, 10, 10, 1, [&](u32) { FAIL(); });
+    parallelFor(nullptr, 0, 10, 1, [&](u32 i) { values[i] = 1; });
+    ASSERT_EQ(values[9], 1u);
+}
+
+TEST(ParallelFor, Reduce)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 2;
+    GeneralTaskManager manager(configuration);
+
+    const u64 sum = parallelReduce(&manager, 1, 100001, 64, u64(0),
+        [](u32 first, u32 last, u64 partial) {
+            for (u32 i = first; i < last; ++i) {
+                partial += i;
+            }
+            return partial;
+        },
+        [](u64 a, u64 b) { return a + b; });
+    ASSERT_EQ(sum, 5000050000ull);
+
+    std::vector<s32> values(3000);
+    for (u32 i = 0; i < values.size(); ++i) {
+        values[i] = (i * 7919) % 3001 - 1500;
+    }
+    const s32 maxValue = parallelReduce(&manager, 0, static_cast<u32>(values.size()), 16, values[0],
+        [&values](u32 first, u32 last, s32 partial) {
+            for (u32 i = first; i < last; ++i) {
+                partial = std::max(partial, values[i]);
+            }
+            return partial;
+        },
+        [](s32 a, s32 b) { return std::max(a, b); });
+    ASSERT_EQ(maxValue, *std::max_element(values.begin(), values.end()));
+
+    ASSERT_EQ(parallelReduce(&manager, 5, 5, 1, 42, [](u32, u32, s32 p) { return p + 1; }, [](s32 a, s32 b) { return a + b; }), 42);
+}
+
+TEST(ParallelFor, NestedInTasks)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> total(0);
+
+    std::vector<TaskPtr> tasks;
+    for (u32 t = 0; t < 8; ++t) {
+        tasks.emplace_back(manager.addTask([&manager, &total]() {
+            parallelFor(&manager, 0, 1000, 10, [&total](u32) { total.fetch_add(1, std::memory_order_relaxed); });
+        }));
+    }
+    for (TaskPtr& task : tasks) {
+        manager.waitTask(task);
+    }
+    ASSERT_EQ(total.load(), 8000u);
+}
+
+TEST(ParallelFor, RunsMainTasksWhileWaiting)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 1;
+    GeneralTaskManager manager(configuration);
+
+    // Chunks on the worker can only finish after a main task ran
+    std::atomic<bool> mainRan(false);
+    manager.addTask([&mainRan]() { mainRan = true; }, Task::Affinity::MAIN);
+
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::atomic<u32> visited(0);
+    parallelForRange(&manager, 64, 1, [&](u32 first, u32 last) {
+        while (std::this_thread::get_id() != mainThread && !mainRan) {
+            std::this_thread::yield();
+        }
+        visited.fetch_add(last - first);
+    });
+    ASSERT_EQ(visited.load(), 64u);
+}
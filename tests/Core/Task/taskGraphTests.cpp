@@ -0,0 +1,170 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Core/TaskGraph.h>
+
+using namespace BitEngine;
+
+namespace {
+class FunctionTask : public Task {
+public:
+    FunctionTask(std::function<void()> f, Affinity affinity = Affinity::BACKGROUND)
+        : Task(TaskMode::NONE, affinity)
+        , m_function(std::move(f))
+    {
+    }
+
+private:
+    void run() override { m_function(); }
+
+    std::function<void()> m_function;
+};
+
+// Each task takes a ticket when it runs, so the order can be checked afterwards
+struct Recorder {
+    std::atomic<u32> next{ 1 };
+    std::vector<std::atomic<u32> > tickets;
+
+    explicit Recorder(u32 count)
+        : tickets(count)
+    {
+    }
+
+    TaskPtr task(u32 id, Task::Affinity affinity = Task::Affinity::BACKGROUND)
+    {
+        return std::make_shared<FunctionTask>([this, id]() { tickets[id] = next.fetch_add(1); }, affinity);
+    }
+};
+
+template <typename Pred>
+bool waitFor(Pred&& pred)
+{
+    const auto start = std::chrono::steady_clock::now();
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+}
+
+TEST(TaskGraph, DependencyRunsFirst)
+{
+    GeneralTaskManager manager;
+    Recorder recorder(2);
+
+    TaskPtr first = recorder.task(0);
+    TaskPtr second = recorder.task(1);
+    second->addDependency(first);
+    ASSERT_FALSE(second->isReady());
+
+    // The waiting task is added first, it must not run until first is done
+    manager.addTask(second);
+    manager.addTask(first);
+
+    manager.waitTask(second);
+    ASSERT_TRUE(first->isFinished());
+    ASSERT_LT(recorder.tickets[0].load(), recorder.tickets[1].load());
+}
+
+TEST(TaskGraph, FinishedDependencyDoesntBlock)
+{
+    GeneralTaskManager manager;
+    Recorder recorder(2);
+
+    TaskPtr first = recorder.task(0);
+    manager.addTask(first);
+    manager.waitTask(first);
+
+    TaskPtr second = recorder.task(1);
+    second->addDependency(first);
+    ASSERT_TRUE(second->isReady());
+    manager.addTask(second);
+    manager.waitTask(second);
+    ASSERT_EQ(recorder.tickets[1].load(), 2u);
+}
+
+TEST(TaskGraph, LongChain)
+{
+    // File load -> decode -> upload like chains, many levels deep
+    const u32 length = 5000;
+    GeneralTaskManager manager;
+    Recorder recorder(length);
+
+    std::vector<TaskPtr> tasks;
+    for (u32 i = 0; i < length; ++i) {
+        tasks.emplace_back(recorder.task(i));
+        if (i > 0) {
+            tasks[i]->addDependency(tasks[i - 1]);
+        }
+    }
+
+    // Last ones first, so every task is added before its dependency finished
+    for (u32 i = length; i-- > 0;) {
+        manager.addTask(tasks[i]);
+    }
+    manager.waitTask(tasks.back());
+
+    for (u32 i = 0; i < length; ++i) {
+        ASSERT_EQ(recorder.tickets[i].load(), i + 1);
+    }
+}
+
+TEST(TaskGraph, MainTaskAfterBackgroundTask)
+{
+    GeneralTaskManager manager;
+    Recorder recorder(2);
+    std::thread::id uploadThread;
+
+    TaskPtr decode = recorder.task(0);
+    TaskPtr upload = std::make_shared<FunctionTask>([&]() { uploadThread = std::this_thread::get_id(); }, Task::Affinity::MAIN);
+    upload->addDependency(decode);
+    manager.addTask(upload);
+    manager.addTask(decode);
+
+    manager.waitTask(upload);
+    ASSERT_EQ(uploadThread, std::this_thread::get_id());
+}
+
+TEST(TaskGraph, SubmitEveryFrame)
+{
+    // Diamond: a -> (b, c) -> d
+    GeneralTaskManager manager;
+    Recorder recorder(4);
+    TaskPtr a = recorder.task(0);
+    TaskPtr b = recorder.task(1);
+    TaskPtr c = recorder.task(2);
+    TaskPtr d = recorder.task(3);
+
+    TaskGraph graph;
+    graph.add(a);
+    graph.add(b);
+    graph.add(c);
+    graph.add(d);
+    graph.addDependency(b, a);
+    graph.addDependency(c, a);
+    graph.addDependency(d, b);
+    graph.addDependency(d, c);
+    ASSERT_TRUE(graph.isFinished());
+
+    for (u32 frame = 0; frame < 200; ++frame) {
+        graph.submit(&manager);
+        ASSERT_TRUE(waitFor([&]() { return graph.isFinished(); })) << "frame " << frame;
+
+        const u32 ta = recorder.tickets[0], tb = recorder.tickets[1], tc = recorder.tickets[2], td = recorder.tickets[3];
+        ASSERT_LT(ta, tb);
+        ASSERT_LT(ta, tc);
+        ASSERT_LT(tb, td);
+        ASSERT_LT(tc, td);
+    }
+    ASSERT_EQ(recorder.next.load(), 200u * 4 + 1);
+}
@@ -0,0 +1,98 @@
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Core/TaskPool.h>
+
+using namespace BitEngine;
+
+TEST(TaskPool, BlocksAreReused)
+{
+    void* a = TaskPool::allocate(100);
+    TaskPool::deallocate(a, 100);
+
+    // Same size class
+    void* b = TaskPool::allocate(120);
+    ASSERT_EQ(a, b);
+    TaskPool::deallocate(b, 120);
+
+    // Bigger blocks are not cached
+    const u32 cached = TaskPool::getCachedBlocks();
+    void* big = TaskPool::allocate(TaskPool::MAX_BLOCK_SIZE + 1);
+    TaskPool::deallocate(big, TaskPool::MAX_BLOCK_SIZE + 1);
+    ASSERT_EQ(TaskPool::getCachedBlocks(), cached);
+}
+
+TEST(TaskPool, LambdaTasksRun)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> counter(0);
+
+    std::vector<TaskPtr> tasks;
+    for (u32 i = 0; i < 1000; ++i) {
+        tasks.emplace_back(manager.addTask([&counter]() { counter.fetch_add(1); }));
+    }
+    for (TaskPtr& task : tasks) {
+        manager.waitTask(task);
+    }
+    ASSERT_EQ(counter.load(), 1000u);
+
+    // Main affinity runs on the calling thread
+    std::thread::id runThread;
+    TaskPtr mainTask = manager.addTask([&runThread]() { runThread = std::this_thread::get_id(); }, Task::Affinity::MAIN);
+    manager.waitTask(mainTask);
+    ASSERT_EQ(runThread, std::this_thread::get_id());
+}
+
+TEST(TaskPool, LambdaTaskDependencies)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> step(0);
+
+    TaskPtr first = makeLambdaTask([&step]() { EXPECT_EQ(step.exchange(1), 0u); });
+    TaskPtr second = makeLambdaTask([&step]() { EXPECT_EQ(step.exchange(2), 1u); });
+    second->addDependency(first);
+
+    manager.addTask(second);
+    manager.addTask(first);
+    manager.waitTask(second);
+    ASSERT_EQ(step.load(), 2u);
+}
+
+TEST(TaskPool, CapturesAreDestroyed)
+{
+    auto data = std::make_shared<u32>(7);
+    std::atomic<u32> result(0);
+    {
+        GeneralTaskManager manager;
+        TaskPtr task = manager.addTask([data, &result]() { result = *data; });
+        manager.waitTask(task);
+    }
+    ASSERT_EQ(result.load(), 7u);
+    ASSERT_EQ(data.use_count(), 1);
+}
+
+TEST(TaskPool, TasksSpawnedByWorkers)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> counter(0);
+
+    // Blocks allocated on one thread and freed on another
+    std::vector<TaskPtr> parents;
+    for (u32 i = 0; i < 50; ++i) {
+        parents.emplace_back(manager.addTask([&manager, &counter]() {
+            for (u32 c = 0; c < 20; ++c) {
+                manager.addTask([&counter]() { counter.fetch_add(1); });
+            }
+        }));
+    }
+    for (TaskPtr& task : parents) {
+        manager.waitTask(task);
+    }
+    while (counter.load() != 1000u) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,164 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Core/TaskSequence.h>
+
+using namespace BitEngine;
+
+namespace {
+TaskPtr addMainTask(GeneralTaskManager& manager, Task::Priority priority, std::function<void()> f)
+{
+    TaskPtr task = makeLambdaTask(std::move(f), Task::Affinity::MAIN);
+    task->setPriority(priority);
+    manager.addTask(task);
+    return task;
+}
+}
+
+TEST(TaskPriority, MainTasksByPriority)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 1;
+    configuration.m_MainTaskBudgetMs = 0;
+    GeneralTaskManager manager(configuration);
+
+    std::vector<Task::Priority> order;
+    for (u32 i = 0; i < 3; ++i) {
+        addMainTask(manager, Task::Priority::IDLE, [&order]() { order.emplace_back(Task::Priority::IDLE); });
+        addMainTask(manager, Task::Priority::NORMAL, [&order]() { order.emplace_back(Task::Priority::NORMAL); });
+        addMainTask(manager, Task::Priority::CRITICAL, [&order]() { order.emplace_back(Task::Priority::CRITICAL); });
+    }
+
+    // Without budget: every critical task and a single normal one
+    manager.update();
+    ASSERT_EQ(order, std::vector<Task::Priority>({ Task::Priority::CRITICAL, Task::Priority::CRITICAL, Task::Priority::CRITICAL, Task::Priority::NORMAL }));
+
+    manager.update();
+    manager.update();
+    ASSERT_EQ(order.size(), 6u);
+    ASSERT_EQ(order.back(), Task::Priority::NORMAL);
+    ASSERT_EQ(manager.getFrameStats().mainQueueDepth, 3u);
+}
+
+TEST(TaskPriority, IdleMainTasksSpillToNextFrames)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 1;
+    configuration.m_MainTaskBudgetMs = 2;
+    GeneralTaskManager manager(configuration);
+
+    const u32 count = 10;
+    u32 ran = 0;
+    for (u32 i = 0; i < count; ++i) {
+        addMainTask(manager, Task::Priority::IDLE, [&ran]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ++ran;
+        });
+    }
+
+    manager.update();
+    ASSERT_GE(ran, 1u);
+    ASSERT_LE(ran, 3u);
+
+    u32 frames = 1;
+    while (ran != count) {
+        manager.update();
+        ++frames;
+        ASSERT_LE(frames, count);
+    }
+    ASSERT_GE(frames, 4u);
+}
+
+TEST(TaskPriority, CriticalTasksDontUseTheBudget)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 1;
+    configuration.m_MainTaskBudgetMs = 50;
+    GeneralTaskManager manager(configuration);
+
+    u32 ran = 0;
+    addMainTask(manager, Task::Priority::CRITICAL, []() { std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+    for (u32 i = 0; i < 3; ++i) {
+        addMainTask(manager, Task::Priority::IDLE, [&ran]() { ++ran; });
+    }
+
+    manager.update();
+    ASSERT_EQ(ran, 3u);
+}
+
+TEST(TaskPriority, WaitingRunsIdleTasks)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 1;
+    configuration.m_MainTaskBudgetMs = 0;
+    GeneralTaskManager manager(configuration);
+
+    bool ran = false;
+    TaskPtr task = addMainTask(manager, Task::Priority::IDLE, [&ran]() { ran = true; });
+    manager.waitTask(task);
+    ASSERT_TRUE(ran);
+}
+
+TEST(TaskPriority, IdleBackgroundTasksRunLast)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 1;
+    GeneralTaskManager manager(configuration);
+
+    std::atomic<bool> release(false);
+    std::atomic<bool> blocking(false);
+    manager.addTask([&]() {
+        blocking = true;
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!blocking.load()) {
+        std::this_thread::yield();
+    }
+
+    // The worker is busy, both kinds wait
+    std::mutex orderMutex;
+    std::vector<Task::Priority> order;
+    std::atomic<u32> done(0);
+    std::vector<TaskPtr> tasks;
+    for (u32 i = 0; i < 10; ++i) {
+        const Task::Priority priority = i % 2 == 0 ? Task::Priority::IDLE : Task::Priority::NORMAL;
+        TaskPtr task = makeLambdaTask([&, priority]() {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.emplace_back(priority);
+            done.fetch_add(1);
+        });
+        task->setPriority(priority);
+        manager.addTask(task);
+    }
+
+    release = true;
+    while (done.load() != 10) {
+        std::this_thread::yield();
+    }
+    for (u32 i = 0; i < 10; ++i) {
+        ASSERT_EQ(order[i], i < 5 ? Task::Priority::NORMAL : Task::Priority::IDLE);
+    }
+}
+
+TEST(TaskPriority, SequenceSteps)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> ran(0);
+
+    TaskPtr last = TaskSequence(&manager, Task::Priority::IDLE)
+                       .then(Task::Affinity::BACKGROUND, [&ran]() { ran.fetch_add(1); })
+                       .then(Task::Affinity::MAIN, [&ran]() { ran.fetch_add(1); })
+                       .submit();
+    ASSERT_EQ(last->getPriority(), Task::Priority::IDLE);
+    manager.waitTask(last);
+    ASSERT_EQ(ran.load(), 2u);
+}
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+#include <BitEngine/Core/TaskSequence.h>
+
+using namespace BitEngine;
+
+TEST(TaskSequence, StepsRunInOrderOnTheirThreads)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 2;
+    GeneralTaskManager manager(configuration);
+    const std::thread::id mainThread = std::this_thread::get_id();
+
+    for (u32 round = 0; round < 50; ++round) {
+        auto steps = std::make_shared<std::vector<u32> >();
+        TaskPtr last = TaskSequence(&manager)
+                           .then(Task::Affinity::MAIN, [steps, mainThread]() {
+                               EXPECT_EQ(std::this_thread::get_id(), mainThread);
+                               steps->emplace_back(1);
+                           })
+                           .then(Task::Affinity::BACKGROUND, [steps]() { steps->emplace_back(2); })
+                           .then(Task::Affinity::MAIN, [steps, mainThread]() {
+                               EXPECT_EQ(std::this_thread::get_id(), mainThread);
+                               steps->emplace_back(3);
+                           })
+                           .submit();
+
+        manager.waitTask(last);
+        ASSERT_EQ(*steps, std::vector<u32>({ 1, 2, 3 }));
+    }
+}
+
+TEST(TaskSequence, WaitsForOtherTasks)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> loaded(0);
+
+    std::vector<TaskPtr> files;
+    for (u32 i = 0; i < 4; ++i) {
+        files.emplace_back(makeLambdaTask([&loaded]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            loaded.fetch_add(1);
+        }));
+    }
+
+    std::atomic<u32> seen(0);
+    TaskSequence sequence(&manager);
+    for (TaskPtr& file : files) {
+        sequence.after(file);
+    }
+    TaskPtr last = sequence.then(Task::Affinity::BACKGROUND, [&]() { seen = loaded.load(); }).submit();
+
+    for (TaskPtr& file : files) {
+        manager.addTask(file);
+    }
+    manager.waitTask(last);
+    ASSERT_EQ(seen.load(), 4u);
+
+    // Waiting without steps after it
+    TaskPtr file = makeLambdaTask([&loaded]() { loaded.fetch_add(1); });
+    TaskPtr end = TaskSequence(&manager).after(file).submit();
+    manager.addTask(file);
+    manager.waitTask(end);
+    ASSERT_EQ(loaded.load(), 5u);
+}
+
+TEST(TaskSequence, FalseStopsTheSequence)
+{
+    GeneralTaskManager manager;
+    std::atomic<u32> ran(0);
+
+    TaskPtr last = TaskSequence(&manager)
+                       .then(Task::Affinity::BACKGROUND, [&ran]() {
+                           ran.fetch_add(1);
+                           return true;
+                       })
+                       .then(Task::Affinity::BACKGROUND, [&ran]() {
+                           ran.fetch_add(1);
+                           return false;
+                       })
+                       .then(Task::Affinity::MAIN, [&ran]() { ran.fetch_add(100); })
+                       .then(Task::Affinity::BACKGROUND, [&ran]() { ran.fetch_add(100); })
+                       .submit();
+
+    // Skipped steps still finish, so the sequence can be waited for
+    manager.waitTask(last);
+    ASSERT_EQ(ran.load(), 2u);
+}
@@ -0,0 +1,123 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/GeneralTaskManager.h>
+
+using namespace BitEngine;
+
+namespace {
+u32 totalExecuted(const TaskFrameStats& stats)
+{
+    u32 total = 0;
+    for (const TaskWorkerStats& worker : stats.workers) {
+        total += worker.tasksExecuted;
+    }
+    return total;
+}
+}
+
+TEST(TaskStats, CountsTasksOfTheFrame)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 2;
+    GeneralTaskManager manager(configuration);
+    ASSERT_EQ(manager.getFrameStats().frame, 0u);
+
+    std::atomic<u32> done(0);
+    for (u32 i = 0; i < 100; ++i) {
+        manager.addTask([&done]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            done.fetch_add(1);
+        });
+    }
+    while (done.load() != 100) {
+        std::this_thread::yield();
+    }
+    manager.update();
+
+    const TaskFrameStats& stats = manager.getFrameStats();
+    ASSERT_EQ(stats.frame, 1u);
+    ASSERT_EQ(stats.workers.size(), 3u);
+    ASSERT_EQ(totalExecuted(stats), 100u);
+    ASSERT_GT(stats.frameMs, 0.0);
+    for (const TaskWorkerStats& worker : stats.workers) {
+        ASSERT_LE(worker.averageLatencyMs, worker.maxLatencyMs);
+        ASSERT_EQ(worker.queueDepth, 0u);
+    }
+
+    // Counters start over every frame
+    manager.update();
+    ASSERT_EQ(manager.getFrameStats().frame, 2u);
+    ASSERT_EQ(totalExecuted(manager.getFrameStats()), 0u);
+}
+
+TEST(TaskStats, LatencyAndSteals)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 1;
+    GeneralTaskManager manager(configuration);
+
+    // Tasks added from the main thread go to its deque, the background worker steals them
+    // while the main thread is busy
+    std::atomic<bool> release(false);
+    std::atomic<u32> done(0);
+    for (u32 i = 0; i < 20; ++i) {
+        manager.addTask([&]() {
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+            done.fetch_add(1);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    release = true;
+    while (done.load() != 20) {
+        std::this_thread::yield();
+    }
+    manager.update();
+
+    const TaskFrameStats& stats = manager.getFrameStats();
+    ASSERT_EQ(stats.workers[1].tasksStolen, stats.workers[1].tasksExecuted);
+    ASSERT_EQ(stats.workers[1].tasksExecuted, 20u);
+    // The last tasks waited at least until the first one was released
+    ASSERT_GE(stats.workers[1].maxLatencyMs, 4.0);
+}
+
+TEST(TaskStats, IdleWorkersCountTheWholeFrame)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 2;
+    GeneralTaskManager manager(configuration);
+
+    // Let the workers park, they stay idle across frames
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    manager.update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    manager.update();
+
+    const TaskFrameStats& stats = manager.getFrameStats();
+    for (u32 i = 1; i < stats.workers.size(); ++i) {
+        ASSERT_EQ(stats.workers[i].tasksExecuted, 0u);
+        ASSERT_GE(stats.workers[i].idleMs, 15.0);
+        ASSERT_LE(stats.workers[i].idleMs, stats.frameMs + 1.0);
+    }
+}
+
+TEST(TaskStats, Disabled)
+{
+    TaskManagerConfiguration configuration;
+    configuration.m_WorkerCount = 1;
+    configuration.m_CollectStats = false;
+    GeneralTaskManager manager(configuration);
+
+    TaskPtr task = manager.addTask([]() {});
+    manager.waitTask(task);
+    manager.update();
+
+    const TaskFrameStats& stats = manager.getFrameStats();
+    ASSERT_EQ(stats.frame, 1u);
+    ASSERT_EQ(totalExecuted(stats), 0u);
+}
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Common/WorkStealingDeque.h>
+
+using namespace BitEngine;
+
+TEST(WorkStealingDeque, OwnerIsLifoThiefIsFifo)
+{
+    WorkStealingDeque<u32> deque(4);
+    for (u32 i = 1; i <= 3; ++i) {
+        deque.push(i);
+    }
+
+    u32 value = 0;
+    ASSERT_TRUE(deque.steal(value));
+    ASSERT_EQ(value, 1u);
+    ASSERT_TRUE(deque.pop(value));
+    ASSERT_EQ(value, 3u);
+    ASSERT_TRUE(deque.pop(value));
+    ASSERT_EQ(value, 2u);
+
+    ASSERT_FALSE(deque.pop(value));
+    ASSERT_FALSE(deque.steal(value));
+    ASSERT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDeque, GrowsKeepingItems)
+{
+    WorkStealingDeque<u32> deque(2);
+
+    // Move top away from 0 so the copy wraps around the old buffer
+    u32 value;
+    for (u32 i = 0; i < 3; ++i) {
+        deque.push(i);
+        ASSERT_TRUE(deque.steal(value));
+    }
+
+    for (u32 i = 0; i < 1000; ++i) {
+        deque.push(i);
+    }
+    for (u32 i = 0; i < 500; ++i) {
+        ASSERT_TRUE(deque.steal(value));
+        ASSERT_EQ(value, i);
+    }
+    for (u32 i = 1000; i-- > 500;) {
+        ASSERT_TRUE(deque.pop(value));
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDeque, EveryItemTakenOnce)
+{
+    const u32 count = 200000;
+    const u32 thieves = 3;
+    WorkStealingDeque<u32> deque(16);
+    std::vector<std::atomic<u32> > taken(count);
+    std::atomic<bool> ownerDone(false);
+
+    std::vector<std::thread> threads;
+    for (u32 t = 0; t < thieves; ++t) {
+        threads.emplace_back([&]() {
+            u32 value;
+            while (!ownerDone || !deque.empty()) {
+                if (deque.steal(value)) {
+                    taken[value].fetch_add(1);
+                }
+            }
+        });
+    }
+
+    // Owner pushes and pops at the same time, fighting thieves for the last items
+    u32 value;
+    for (u32 i = 0; i < count; ++i) {
+        deque.push(i);
+        if (i % 3 == 0 && deque.pop(value)) {
+            taken[value].fetch_add(1);
+        }
+    }
+    while (deque.pop(value)) {
+        taken[value].fetch_add(1);
+    }
+    ownerDone = true;
+
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    for (u32 i = 0; i < count; ++i) {
+        ASSERT_EQ(taken[i].load(), 1u) << "item " << i;
+    }
+}
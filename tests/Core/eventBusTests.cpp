@@ -0,0 +1,143 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/EventBus.h>
+
+using namespace BitEngine;
+
+namespace {
+struct MsgDamage {
+    u32 source;
+    u32 amount;
+};
+
+struct MsgSpawn {
+    u32 id;
+};
+}
+
+TEST(EventBus, DeliversAtDispatchByType)
+{
+    EventBus bus;
+    std::vector<u32> order;
+    bus.subscribe<MsgDamage>([&order](const MsgDamage& msg) { order.emplace_back(msg.amount); });
+    bus.subscribe<MsgSpawn>([&order](const MsgSpawn& msg) { order.emplace_back(1000 + msg.id); });
+
+    bus.post(MsgDamage{ 0, 1 });
+    bus.post(MsgSpawn{ 1 });
+    bus.post(MsgDamage{ 0, 2 });
+    ASSERT_TRUE(order.empty());
+
+    bus.dispatchAll();
+    // Batched by type, each type in the order it was posted
+    ASSERT_EQ(order, std::vector<u32>({ 1, 2, 1001 }));
+
+    // Delivered once
+    bus.dispatchAll();
+    ASSERT_EQ(order.size(), 3u);
+}
+
+TEST(EventBus, BatchSubscribersAndUnsubscribe)
+{
+    EventBus bus;
+    u32 batches = 0;
+    u32 total = 0;
+    bus.subscribeBatch<MsgDamage>([&](const MsgDamage* events, ptrsize count) {
+        ++batches;
+        for (ptrsize i = 0; i < count; ++i) {
+            total += events[i].amount;
+        }
+    });
+    u32 calls = 0;
+    const u32 handle = bus.subscribe<MsgDamage>([&calls](const MsgDamage&) { ++calls; });
+
+    for (u32 i = 1; i <= 10; ++i) {
+        bus.post(MsgDamage{ 0, i });
+    }
+    bus.dispatchAll();
+    ASSERT_EQ(batches, 1u);
+    ASSERT_EQ(total, 55u);
+    ASSERT_EQ(calls, 10u);
+
+    // Nothing posted, no empty batch
+    bus.dispatchAll();
+    ASSERT_EQ(batches, 1u);
+
+    bus.unsubscribe<MsgDamage>(handle);
+    bus.post(MsgDamage{ 0, 1 });
+    bus.dispatchAll();
+    ASSERT_EQ(batches, 2u);
+    ASSERT_EQ(calls, 10u);
+}
+
+TEST(EventBus, PostedWhileDispatchingGoesToNextDispatch)
+{
+    EventBus bus;
+    std::vector<u32> spawned;
+    bus.subscribe<MsgSpawn>([&](const MsgSpawn& msg) {
+        spawned.emplace_back(msg.id);
+        if (msg.id < 3) {
+            bus.post(MsgSpawn{ msg.id + 1 });
+        }
+    });
+
+    bus.post(MsgSpawn{ 1 });
+    bus.dispatchAll();
+    ASSERT_EQ(spawned, std::vector<u32>({ 1 }));
+    bus.dispatchAll();
+    bus.dispatchAll();
+    bus.dispatchAll();
+    ASSERT_EQ(spawned, std::vector<u32>({ 1, 2, 3 }));
+}
+
+TEST(EventBus, PostFromManyThreads)
+{
+    const u32 producers = 4;
+    const u32 count = 20000;
+    EventBus bus;
+
+    std::vector<u32> nextOf(producers, 0);
+    u32 received = 0;
+    bus.subscribe<MsgDamage>([&](const MsgDamage& msg) {
+        // Each thread keeps its order
+        EXPECT_EQ(msg.amount, nextOf[msg.source]);
+        ++nextOf[msg.source];
+        ++received;
+    });
+
+    std::atomic<u32> running(producers);
+    std::vector<std::thread> threads;
+    for (u32 p = 0; p < producers; ++p) {
+        threads.emplace_back([&bus, &running, p, count]() {
+            // Half posted one by one, half through Posters
+            for (u32 i = 0; i < count / 2; ++i) {
+                bus.post(MsgDamage{ p, i });
+            }
+            for (u32 i = count / 2; i < count;) {
+                EventBus::Poster poster(bus);
+                for (u32 end = i + 100; i < end && i < count; ++i) {
+                    poster.post(MsgDamage{ p, i });
+                }
+            }
+            --running;
+        });
+    }
+
+    // Dispatch while the threads are still posting
+    while (running.load() != 0) {
+        bus.dispatchAll();
+        std::this_thread::yield();
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    bus.dispatchAll();
+
+    ASSERT_EQ(received, producers * count);
+    for (u32 p = 0; p < producers; ++p) {
+        ASSERT_EQ(nextOf[p], count);
+    }
+}
@@ -0,0 +1,115 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/Messenger.h>
+
+using namespace BitEngine;
+
+namespace {
+struct MsgValue {
+    int value;
+};
+
+class Receiver {
+public:
+    void onMessage(const MsgValue& msg) { received.emplace_back(msg.value); }
+    void onMessage(const float&) {}
+
+    std::vector<int> received;
+};
+}
+
+TEST(Messenger, CallsEverySubscriberInOrder)
+{
+    Messenger<MsgValue> messenger;
+    std::vector<int> order;
+    for (int i = 0; i < 10; ++i) {
+        messenger.subscribe([&order, i](const MsgValue& msg) { order.emplace_back(i * 100 + msg.value); });
+    }
+
+    messenger.emit({ 1 });
+    ASSERT_EQ(order.size(), 10u);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(order[i], i * 100 + 1);
+    }
+}
+
+TEST(Messenger, MemberFunctions)
+{
+    Messenger<MsgValue> messenger;
+    Receiver compileTime, runTime;
+    messenger.subscribe<Receiver, &Receiver::onMessage>(&compileTime);
+    const u32 handle = messenger.subscribe(&Receiver::onMessage, &runTime);
+
+    messenger.emit({ 3 });
+    messenger.unsubscribe(handle);
+    messenger.emit({ 4 });
+
+    ASSERT_EQ(compileTime.received, std::vector<int>({ 3, 4 }));
+    ASSERT_EQ(runTime.received, std::vector<int>({ 3 }));
+}
+
+TEST(Messenger, ScopedSubscription)
+{
+    Messenger<MsgValue> messenger;
+    Receiver receiver;
+    {
+        Messenger<MsgValue>::ScopedSubscription subscription(messenger, Messenger<MsgValue>::bind<Receiver, &Receiver::onMessage>(&receiver));
+        messenger.emit({ 1 });
+    }
+    messenger.emit({ 2 });
+    ASSERT_EQ(receiver.received, std::vector<int>({ 1 }));
+}
+
+TEST(Messenger, DispatchDeliversEnqueuedOnce)
+{
+    Messenger<MsgValue> messenger;
+    std::vector<int> received;
+    messenger.subscribe([&](const MsgValue& msg) {
+        received.emplace_back(msg.value);
+        if (msg.value < 10) {
+            messenger.enqueue({ msg.value + 10 });
+        }
+    });
+
+    for (int i = 0; i < 6; ++i) {
+        messenger.enqueue({ i });
+    }
+    ASSERT_TRUE(received.empty());
+
+    messenger.dispatch();
+    ASSERT_EQ(received, std::vector<int>({ 0, 1, 2, 3, 4, 5 }));
+    messenger.dispatch();
+    ASSERT_EQ(received.size(), 12u);
+    ASSERT_EQ(received.back(), 15);
+    messenger.dispatch();
+    ASSERT_EQ(received.size(), 12u);
+}
+
+TEST(Messenger, SubscribeAndUnsubscribeWhileEmitting)
+{
+    Messenger<MsgValue> messenger;
+    std::vector<int> received;
+    u32 self = 0;
+    self = messenger.subscribe([&](const MsgValue& msg) {
+        // Enough new subscribers to grow the vector, and removing the one running
+        for (int i = 0; i < 32; ++i) {
+            messenger.subscribe([&received, i](const MsgValue& m) { received.emplace_back(m.value * 100 + i); });
+        }
+        messenger.unsubscribe(self);
+        received.emplace_back(msg.value);
+    });
+    messenger.subscribe([&received](const MsgValue& msg) { received.emplace_back(-msg.value); });
+
+    // The added subscribers get the next message, the removed one doesn't
+    messenger.emit({ 1 });
+    ASSERT_EQ(received, std::vector<int>({ 1, -1 }));
+
+    received.clear();
+    messenger.emit({ 2 });
+    ASSERT_EQ(received.size(), 33u);
+    ASSERT_EQ(received[0], -2);
+    ASSERT_EQ(received[1], 200);
+    ASSERT_EQ(received.back(), 231);
+}
@@ -0,0 +1,141 @@
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BitEngine/Core/TransformKernels.h>
+
+using namespace BitEngine;
+
+namespace {
+// Column major 4x4 product, reference for the kernels
+void referenceMultiply(const float* a, const float* b, float* out)
+{
+    for (u32 j = 0; j < 4; ++j) {
+        for (u32 r = 0; r < 4; ++r) {
+            out[j * 4 + r] = 0;
+            for (u32 k = 0; k < 4; ++k) {
+                out[j * 4 + r] += a[k * 4 + r] * b[j * 4 + k];
+            }
+        }
+    }
+}
+}
+
+TEST(TransformKernels, SinCosMatchesStd)
+{
+    // Odd count to go through the scalar tail too
+    std::vector<float> angles;
+    for (float a = -100.0f; a <= 100.0f; a += 0.0137f) {
+        angles.emplace_back(a);
+    }
+    angles.emplace_back(0.0f);
+    angles.emplace_back(-0.0f);
+
+    std::vector<float> s(angles.size()), c(angles.size());
+    TransformKernels::sinCos(angles.data(), s.data(), c.data(), angles.size());
+
+    for (u32 i = 0; i < angles.size(); ++i) {
+        ASSERT_NEAR(s[i], std::sin(angles[i]), 2e-6f) << angles[i];
+        ASSERT_NEAR(c[i], std::cos(angles[i]), 2e-6f) << angles[i];
+    }
+}
+
+TEST(TransformKernels, ComposeLocal2D)
+{
+    const u32 count = 37;
+    std::vector<float> px(count), py(count), rot(count), sx(count), sy(count);
+    for (u32 i = 0; i < count; ++i) {
+        px[i] = i * 1.5f;
+        py[i] = -(float)i;
+        rot[i] = i * 0.3f - 5.0f;
+        sx[i] = 1.0f + i * 0.1f;
+        sy[i] = 2.0f - i * 0.05f;
+    }
+
+    std::vector<float> matrices(count * 9);
+    std::vector<float*> out(count);
+    for (u32 i = 0; i < count; ++i) {
+        out[i] = &matrices[i * 9];
+    }
+    TransformKernels::composeLocal2D({ px.data(), py.data(), rot.data(), sx.data(), sy.data() }, count, out.data());
+
+    for (u32 i = 0; i < count; ++i) {
+        const float c = std::cos(rot[i]);
+        const float s = std::sin(rot[i]);
+        const float expected[9] = { sx[i] * c, -sx[i] * s, 0, sy[i] * s, sy[i] * c, 0, px[i], py[i], 1 };
+        for (u32 k = 0; k < 9; ++k) {
+            ASSERT_NEAR(out[i][k], expected[k], 1e-5f) << "transform " << i << " element " << k;
+        }
+    }
+}
+
+TEST(TransformKernels, ComposeLocal3D)
+{
+    const u32 count = 21;
+    std::vector<float> p[3], s[3], q[4];
+    for (u32 a = 0; a < 3; ++a) {
+        p[a].resize(count);
+        s[a].resize(count);
+    }
+    for (u32 a = 0; a < 4; ++a) {
+        q[a].resize(count);
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 a = 0; a < 3; ++a) {
+            p[a][i] = (float)(i + a) - 10.0f;
+            s[a][i] = 0.5f + 0.1f * (i + a);
+        }
+        // Rotation of i * 0.4 radians around a normalized (1, 2, 3) axis
+        const float half = i * 0.2f;
+        const float len = std::sqrt(14.0f);
+        q[0][i] = std::sin(half) * 1.0f / len;
+        q[1][i] = std::sin(half) * 2.0f / len;
+        q[2][i] = std::sin(half) * 3.0f / len;
+        q[3][i] = std::cos(half);
+    }
+
+    std::vector<float> matrices(count * 16);
+    std::vector<float*> out(count);
+    for (u32 i = 0; i < count; ++i) {
+        out[i] = &matrices[i * 16];
+    }
+    TransformKernels::composeLocal3D({ p[0].data(), p[1].data(), p[2].data(), s[0].data(), s[1].data(), s[2].data(),
+                                         q[0].data(), q[1].data(), q[2].data(), q[3].data() },
+        count, out.data());
+
+    for (u32 i = 0; i < count; ++i) {
+        const float x = q[0][i], y = q[1][i], z = q[2][i], w = q[3][i];
+        const float rotation[16] = {
+            1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y), 0,
+            2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x), 0,
+            2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y), 0,
+            0, 0, 0, 1
+        };
+        const float scale[16] = { s[0][i], 0, 0, 0, 0, s[1][i], 0, 0, 0, 0, s[2][i], 0, 0, 0, 0, 1 };
+        const float translation[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, p[0][i], p[1][i], p[2][i], 1 };
+
+        float rs[16], expected[16];
+        referenceMultiply(rotation, scale, rs);
+        referenceMultiply(rs, translation, expected);
+        for (u32 k = 0; k < 16; ++k) {
+            ASSERT_NEAR(out[i][k], expected[k], 1e-4f) << "transform " << i << " element " << k;
+        }
+    }
+}
+
+TEST(TransformKernels, Multiply4x4)
+{
+    float a[16], b[16], expected[16], result[16];
+    for (u32 k = 0; k < 16; ++k) {
+        a[k] = k * 0.5f - 3.0f;
+        b[k] = 2.0f - k * 0.25f;
+    }
+
+    referenceMultiply(a, b, expected);
+    TransformKernels::multiply4x4(a, b, result);
+    for (u32 k = 0; k < 16; ++k) {
+        ASSERT_FLOAT_EQ(result[k], expected[k]);
+    }
+}
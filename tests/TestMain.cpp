@@ -4,6 +4,7 @@
 
 #include <BitEngine/Core/Logger.h>
 #include <BitEngine/Core/EngineConfiguration.h>
+#include <BitEngine/Core/Profiler.h>
 
 #include <BitEngine/Global/globals.cpp>
 
@@ -11,6 +12,11 @@ int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
 
+    // Engine code is instrumented, keep a profiler instance around but don't record anything
+    BitEngine::Profiling::ChromeProfiler profiler;
+    profiler.enable_profiling = false;
+    BitEngine::Profiling::SetInstance(&profiler);
+
     const char* argvs[] = { BE_PARAM_DEBUG, BE_PARAM_DEBUG_FILE_ONLY };
     BitEngine::LoggerSetup::Setup(2, argvs);
 